@@ -24,6 +24,7 @@ static void AdiAppInit();
 
 /* Tell the compiler where to find the needed globals */
 extern CyU3PEvent EventHandler;
+extern StreamState StreamThreadState;
 
 /** Global char buffer to store unique FX3 serial number */
 extern char serial_number[];
@@ -288,7 +289,15 @@ void AdiAppThreadEntry(uint32_t input)
     		ADI_TRANSFER_STREAM_STOP |
     		ADI_I2C_STREAM_DONE |
     		ADI_I2C_STREAM_START |
-    		ADI_I2C_STREAM_STOP;
+    		ADI_I2C_STREAM_STOP |
+    		ADI_BITBANG_STREAM_DONE |
+    		ADI_BITBANG_STREAM_START |
+    		ADI_BITBANG_STREAM_STOP |
+    		ADI_SEQ_STREAM_DONE |
+    		ADI_SEQ_STREAM_START |
+    		ADI_SEQ_STREAM_STOP |
+    		ADI_BULK_CMD_RECEIVED |
+    		ADI_PIN_STREAM_START;
 
     /* Event flags */
     uint32_t eventFlag;
@@ -419,6 +428,77 @@ void AdiAppThreadEntry(uint32_t input)
 #endif
 			}
 
+			/* Handle bit bang SPI stream commands */
+			if (eventFlag & ADI_BITBANG_STREAM_START)
+			{
+				AdiBitBangStreamStart();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Bit bang stream start finished.\r\n");
+#endif
+			}
+			if (eventFlag & ADI_BITBANG_STREAM_STOP)
+			{
+				AdiStopAnyDataStream();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Bit bang stream stop finished.\r\n");
+#endif
+			}
+			if (eventFlag & ADI_BITBANG_STREAM_DONE)
+			{
+				AdiBitBangStreamFinished();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Bit bang stream cleanup finished.\r\n");
+#endif
+			}
+
+			/* Handle SPI micro-sequencer stream commands */
+			if (eventFlag & ADI_SEQ_STREAM_START)
+			{
+				AdiSpiSeqStreamStart();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Sequencer stream start finished.\r\n");
+#endif
+			}
+			if (eventFlag & ADI_SEQ_STREAM_STOP)
+			{
+				AdiStopAnyDataStream();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Sequencer stream stop finished.\r\n");
+#endif
+			}
+			if (eventFlag & ADI_SEQ_STREAM_DONE)
+			{
+				AdiSpiSeqStreamFinished();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Sequencer stream cleanup finished.\r\n");
+#endif
+			}
+
+			/* Handle pin capture stream start (stop and cleanup use the generic stream events) */
+			if (eventFlag & ADI_PIN_STREAM_START)
+			{
+				if(StreamThreadState.PinStreamType == ADI_PIN_STREAM_LOGIC)
+				{
+					AdiLogicStreamStart();
+				}
+				else
+				{
+					AdiEdgeStreamStart();
+				}
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Pin stream start finished.\r\n");
+#endif
+			}
+
+			/* Handle bulk command channel frames */
+			if (eventFlag & ADI_BULK_CMD_RECEIVED)
+			{
+				AdiBulkCmdService();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Bulk command serviced.\r\n");
+#endif
+			}
+
     	}
         /* Allow other ready threads to run. */
         CyU3PThreadRelinquish();
@@ -98,4 +98,37 @@ void AdiAppThreadEntry(uint32_t input);
 /** I2C read stream enable */
 #define ADI_I2C_STREAM_ENABLE					(1 << 20)
 
+/** Event handler bit for starting a bit bang SPI stream */
+#define ADI_BITBANG_STREAM_START				(1 << 21)
+
+/** Event handler bit to asynchronously stop a bit bang SPI stream */
+#define ADI_BITBANG_STREAM_STOP					(1 << 22)
+
+/** Event handler bit for cleaning up a bit bang SPI stream */
+#define ADI_BITBANG_STREAM_DONE					(1 << 23)
+
+/** Event handler bit for continuing a bit bang SPI stream, within the StreamThread */
+#define ADI_BITBANG_STREAM_ENABLE				(1 << 24)
+
+/** Event handler bit for starting a SPI micro-sequencer stream */
+#define ADI_SEQ_STREAM_START					(1 << 25)
+
+/** Event handler bit to asynchronously stop a SPI micro-sequencer stream */
+#define ADI_SEQ_STREAM_STOP						(1 << 26)
+
+/** Event handler bit for cleaning up a SPI micro-sequencer stream */
+#define ADI_SEQ_STREAM_DONE						(1 << 27)
+
+/** Event handler bit for continuing a SPI micro-sequencer stream, within the StreamThread */
+#define ADI_SEQ_STREAM_ENABLE					(1 << 28)
+
+/** Event handler bit for a command frame received on the bulk command channel */
+#define ADI_BULK_CMD_RECEIVED					(1 << 29)
+
+/** Event handler bit for pin capture (edge timestamp or logic analyzer) stream start. Stop and cleanup use the generic stream events */
+#define ADI_PIN_STREAM_START					(1 << 30)
+
+/** Event handler bit for continuing a pin capture stream, within the StreamThread */
+#define ADI_PIN_STREAM_ENABLE					(1 << 31)
+
 #endif
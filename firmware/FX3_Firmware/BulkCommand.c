@@ -0,0 +1,785 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		BulkCommand.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Framed command channel on the bulk endpoints (ADI_FROM_PC_ENDPOINT / ADI_TO_PC_ENDPOINT).
+  *
+  * Commands sent over the control endpoint pay the control transfer setup and status stage overhead,
+  * are limited to the 4KB USBBuffer, and run in the USB setup callback context. This module accepts
+  * the same vendor request codes as framed commands on the bulk OUT endpoint. Each command frame gets
+  * exactly one response frame on the bulk IN endpoint, which carries the same opcode and tag, so the
+  * host can match responses to commands.
+  *
+  * Up to ADI_BULK_CMD_QUEUE_DEPTH commands can be in flight. Each received frame stays in its slot
+  * until its response has been read by the host, and the bulk OUT endpoint is re-armed with the next
+  * free slot as soon as a frame is received. When all slots are in use the endpoint NAKs until one is
+  * freed. Endpoint arming and response sending are driven from the DMA callbacks (DMA driver thread),
+  * so no thread ever blocks waiting on the host.
+  *
+  * Fast commands are executed by the AppThread as they arrive. Long running pin measurements are
+  * posted to a message queue and executed by the lower priority BulkCmdThread, so commands sent after
+  * a measurement can complete before it (out of order completion, matched by tag).
+  *
+  * Handlers which already return their results over the bulk endpoint are reused unchanged: they
+  * read their request data through AdiGetRequestData and send their results through
+  * AdiReturnBulkEndpointData, both of which are redirected to the command frame while the calling
+  * thread is servicing a bulk command. These handlers share USBBuffer / BulkBuffer with the control
+  * endpoint commands, so they are serialized with BufferLock, which the control endpoint handler also
+  * holds. The deferred pin measurements run from private parameter and result buffers (the same split
+  * as the pin jobs), so a long measurement never holds BufferLock.
+  *
+  * ChannelToPC is also shared with the control endpoint commands which return data over the bulk
+  * endpoint. Those sends go through AdiBulkCmdSendData, which takes the channel like a response slot.
+  * When the host gives up on a command (response timeout) it sends ADI_BULK_CMD_FLUSH, which drops
+  * every queued response and marks the commands still executing, so their late responses are never
+  * sent to the host in place of the data for a later command.
+ **/
+
+#include "BulkCommand.h"
+
+/* Private function prototypes */
+static void AdiBulkCmdArm();
+static void AdiBulkCmdStartSend();
+static void AdiBulkCmdExecute(uint8_t slot, AdiBulkCmdContext * ctx);
+static AdiBulkCmdContext * AdiBulkCmdGetContext();
+static CyBool_t AdiBulkCmdIsDeferred(uint8_t opcode);
+static CyU3PReturnStatus_t AdiBulkCmdRunDeferred(AdiBulkCmdContext * ctx);
+
+/* Tell the compiler where to find the needed globals */
+extern CyU3PEvent EventHandler;
+extern CyU3PDmaChannel ChannelFromPC;
+extern CyU3PDmaChannel ChannelToPC;
+extern CyU3PThread AppThread;
+extern CyU3PThread BulkCmdThread;
+extern BoardState FX3State;
+extern uint8_t USBBuffer[4096];
+
+/** Command slot frame buffers (multiple of the SuperSpeed max packet size). Responses are built in place */
+static uint8_t SlotFrame[ADI_BULK_CMD_QUEUE_DEPTH][ADI_BULK_CMD_FRAME_SIZE] __attribute__((aligned(32)));
+
+/** Number of bytes received in each slot (set by the DMA callback), then the response frame length */
+static volatile uint32_t SlotLength[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** Track which slots are armed, hold a command, or hold an unsent response */
+static CyBool_t SlotInUse[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** Track which slots hold a command the host has stopped waiting for (ADI_BULK_CMD_FLUSH). Its response is dropped */
+static CyBool_t SlotDiscard[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** Slot currently armed on the bulk OUT endpoint */
+static uint8_t RxSlot = ADI_BULK_CMD_NO_SLOT;
+
+/** Slot currently being sent on the bulk IN endpoint */
+static uint8_t TxSlot = ADI_BULK_CMD_NO_SLOT;
+
+/** FIFO of slots with a response waiting to be sent */
+static uint8_t TxFifo[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** TxFifo read index */
+static uint8_t TxFifoHead = 0;
+
+/** Number of entries in TxFifo */
+static uint8_t TxFifoCount = 0;
+
+/** Context for commands executed by the AppThread */
+static AdiBulkCmdContext AppContext = {0};
+
+/** Context for commands executed by the BulkCmdThread */
+static AdiBulkCmdContext WorkerContext = {0};
+
+/** Message queue of received slots for the AppThread */
+static CyU3PQueue ReceivedQueue;
+
+/** Storage for the received command queue (one 32-bit message per slot) */
+static uint32_t ReceivedQueueStorage[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** Message queue of slots for the BulkCmdThread */
+static CyU3PQueue DeferredQueue;
+
+/** Storage for the deferred command queue (one 32-bit message per slot) */
+static uint32_t DeferredQueueStorage[ADI_BULK_CMD_QUEUE_DEPTH];
+
+/** Protects the slot state, endpoint arming and response FIFO. Only held briefly */
+static CyU3PMutex SlotLock;
+
+/** Serializes the reused handlers and control endpoint commands, which share USBBuffer and BulkBuffer */
+static CyU3PMutex BufferLock;
+
+/**
+  * @brief Entry point for the BulkCmdThread. Executes deferred bulk commands in the order received.
+  *
+  * @param input Unused
+  *
+  * @return void
+  *
+  * Also creates the queue and mutexes used by the command channel. The thread is started by the
+  * kernel at boot, well ahead of the USB enumeration which starts the command channel.
+ **/
+void AdiBulkCmdThreadEntry(uint32_t input)
+{
+	UNUSED(input);
+	CyU3PReturnStatus_t status;
+	uint32_t slot;
+
+	status = CyU3PQueueCreate(&ReceivedQueue, 1, ReceivedQueueStorage, sizeof(ReceivedQueueStorage));
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+	status = CyU3PQueueCreate(&DeferredQueue, 1, DeferredQueueStorage, sizeof(DeferredQueueStorage));
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+	status = CyU3PMutexCreate(&SlotLock, CYU3P_NO_INHERIT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+	status = CyU3PMutexCreate(&BufferLock, CYU3P_INHERIT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+
+	for(;;)
+	{
+		if(CyU3PQueueReceive(&DeferredQueue, &slot, CYU3P_WAIT_FOREVER) == CY_U3P_SUCCESS)
+		{
+			AdiBulkCmdExecute((uint8_t) slot, &WorkerContext);
+		}
+	}
+}
+
+/**
+  * @brief Starts the bulk command channel, by arming the bulk OUT endpoint with a free command slot.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Must be called after ChannelFromPC is created. Frame reception completes on a short packet, so
+  * the host must pad any frame which is a multiple of the max packet size by one byte.
+ **/
+CyU3PReturnStatus_t AdiBulkCmdStart()
+{
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+
+	/* Transfers set up on a previous channel instance will never complete */
+	if(RxSlot != ADI_BULK_CMD_NO_SLOT)
+	{
+		SlotInUse[RxSlot] = CyFalse;
+		RxSlot = ADI_BULK_CMD_NO_SLOT;
+	}
+	if(TxSlot != ADI_BULK_CMD_NO_SLOT)
+	{
+		if(TxSlot != ADI_BULK_CMD_DATA_SLOT)
+			SlotInUse[TxSlot] = CyFalse;
+		TxSlot = ADI_BULK_CMD_NO_SLOT;
+	}
+	while(TxFifoCount)
+	{
+		SlotInUse[TxFifo[TxFifoHead]] = CyFalse;
+		TxFifoHead = (TxFifoHead + 1) % ADI_BULK_CMD_QUEUE_DEPTH;
+		TxFifoCount--;
+	}
+	CyU3PMemSet((uint8_t *) SlotDiscard, 0, sizeof(SlotDiscard));
+	AdiBulkCmdArm();
+
+	CyU3PMutexPut(&SlotLock);
+
+	return (RxSlot == ADI_BULK_CMD_NO_SLOT) ? CY_U3P_ERROR_NOT_STARTED : CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief DMA callback for ChannelFromPC. Queues the received command frame and arms the next free slot.
+  *
+  * @param handle The DMA channel handle (unused)
+  *
+  * @param type The DMA callback type
+  *
+  * @param input The DMA callback input (holds the received buffer)
+  *
+  * @return void
+ **/
+void AdiBulkCmdDmaCallback(CyU3PDmaChannel * handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t * input)
+{
+	UNUSED(handle);
+	uint32_t msg;
+
+	if(type != CY_U3P_DMA_CB_RECV_CPLT)
+		return;
+
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+	if(RxSlot != ADI_BULK_CMD_NO_SLOT)
+	{
+		SlotLength[RxSlot] = input->buffer_p.count;
+		msg = RxSlot;
+		RxSlot = ADI_BULK_CMD_NO_SLOT;
+		/* Queue has one entry per slot, so can't be full */
+		CyU3PQueueSend(&ReceivedQueue, &msg, CYU3P_NO_WAIT);
+		AdiBulkCmdArm();
+	}
+	CyU3PMutexPut(&SlotLock);
+
+	CyU3PEventSet(&EventHandler, ADI_BULK_CMD_RECEIVED, CYU3P_EVENT_OR);
+}
+
+/**
+  * @brief DMA callback for ChannelToPC. Frees the slot of the sent response and starts the next one.
+  *
+  * @param handle The DMA channel handle (unused)
+  *
+  * @param type The DMA callback type
+  *
+  * @param input The DMA callback input (unused)
+  *
+  * @return void
+  *
+  * Also called for data sent by control endpoint commands (ADI_BULK_CMD_DATA_SLOT), which holds no slot.
+ **/
+void AdiBulkCmdSendCallback(CyU3PDmaChannel * handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t * input)
+{
+	UNUSED(handle);
+	UNUSED(input);
+
+	if(type != CY_U3P_DMA_CB_SEND_CPLT)
+		return;
+
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+	if(TxSlot != ADI_BULK_CMD_NO_SLOT)
+	{
+		if(TxSlot != ADI_BULK_CMD_DATA_SLOT)
+			SlotInUse[TxSlot] = CyFalse;
+		TxSlot = ADI_BULK_CMD_NO_SLOT;
+		AdiBulkCmdArm();
+		AdiBulkCmdStartSend();
+	}
+	CyU3PMutexPut(&SlotLock);
+}
+
+/**
+  * @brief Checks if the calling thread is currently servicing a bulk command.
+  *
+  * @return CyTrue if request data and bulk responses should use the bulk command frames
+ **/
+CyBool_t AdiBulkCmdActive()
+{
+	AdiBulkCmdContext * ctx = AdiBulkCmdGetContext();
+	return (ctx != NULL) && ctx->Active;
+}
+
+/**
+  * @brief Copies request data from the payload of the calling thread's active command.
+  *
+  * @param length The number of bytes requested
+  *
+  * @param outBuf Buffer to copy the payload to
+  *
+  * @return A status code indicating the success of the function. Fails if the payload is too short.
+ **/
+CyU3PReturnStatus_t AdiBulkCmdGetPayload(uint16_t length, uint8_t * outBuf)
+{
+	AdiBulkCmdContext * ctx = AdiBulkCmdGetContext();
+
+	if((ctx == NULL) || (!ctx->Active) || (length > ctx->PayloadLength))
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMemCopy(outBuf, SlotFrame[ctx->Slot] + ADI_BULK_CMD_HEADER_LEN, length);
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Sends the response frame for the calling thread's active bulk command.
+  *
+  * @param status The command status
+  *
+  * @param data The response data (can be NULL if length is 0)
+  *
+  * @param length The number of response data bytes
+  *
+  * @return void
+  *
+  * The response is built in the command slot (the payload has already been consumed) and queued
+  * for sending. The slot is freed once the host has read it.
+ **/
+void AdiBulkCmdRespond(CyU3PReturnStatus_t status, uint8_t * data, uint32_t length)
+{
+	AdiBulkCmdContext * ctx = AdiBulkCmdGetContext();
+	uint8_t * frame;
+
+	if((ctx == NULL) || (!ctx->Active) || ctx->Responded)
+		return;
+
+	if(length > ADI_BULK_CMD_MAX_PAYLOAD)
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(BulkCommand_c, __LINE__, status);
+		length = 0;
+	}
+
+	/* Build header */
+	frame = SlotFrame[ctx->Slot];
+	frame[0] = ADI_BULK_CMD_SYNC;
+	frame[1] = ctx->Opcode;
+	frame[2] = ctx->Tag & 0xFF;
+	frame[3] = (ctx->Tag & 0xFF00) >> 8;
+	frame[4] = status & 0xFF;
+	frame[5] = (status & 0xFF00) >> 8;
+	frame[6] = (status & 0xFF0000) >> 16;
+	frame[7] = (status & 0xFF000000) >> 24;
+	frame[8] = length & 0xFF;
+	frame[9] = (length & 0xFF00) >> 8;
+	frame[10] = (length & 0xFF0000) >> 16;
+	frame[11] = (length & 0xFF000000) >> 24;
+	if(length)
+	{
+		CyU3PMemCopy(frame + ADI_BULK_RESP_HEADER_LEN, data, length);
+	}
+
+	length += ADI_BULK_RESP_HEADER_LEN;
+
+	/* Pad by one byte so the host always sees a short packet at the end of the frame */
+	if((length % FX3State.UsbBufferSize) == 0)
+	{
+		frame[length] = 0;
+		length++;
+	}
+	SlotLength[ctx->Slot] = length;
+
+	/* Queue for sending to the PC. If the host has flushed the command, free the slot instead */
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+	if(SlotDiscard[ctx->Slot])
+	{
+		SlotDiscard[ctx->Slot] = CyFalse;
+		SlotInUse[ctx->Slot] = CyFalse;
+		AdiBulkCmdArm();
+	}
+	else
+	{
+		TxFifo[(TxFifoHead + TxFifoCount) % ADI_BULK_CMD_QUEUE_DEPTH] = ctx->Slot;
+		TxFifoCount++;
+		AdiBulkCmdStartSend();
+	}
+	CyU3PMutexPut(&SlotLock);
+
+	ctx->Responded = CyTrue;
+}
+
+/**
+  * @brief Sends bulk IN data for a control endpoint command over ChannelToPC.
+  *
+  * @param buffer The DMA buffer to send
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The data takes ChannelToPC like a response slot, so responses queued while it is being sent wait
+  * for it to complete. If a bulk command response is already queued or being sent, the data is not
+  * sent (CY_U3P_ERROR_INVALID_SEQUENCE), since the host would read the response in its place.
+ **/
+CyU3PReturnStatus_t AdiBulkCmdSendData(CyU3PDmaBuffer_t * buffer)
+{
+	CyU3PReturnStatus_t status;
+
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+	if((TxSlot != ADI_BULK_CMD_NO_SLOT) || TxFifoCount)
+	{
+		status = CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+	else
+	{
+		status = CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, buffer);
+		if(status == CY_U3P_SUCCESS)
+			TxSlot = ADI_BULK_CMD_DATA_SLOT;
+	}
+	CyU3PMutexPut(&SlotLock);
+
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+	return status;
+}
+
+/**
+  * @brief Discards the bulk command responses the host has stopped waiting for (ADI_BULK_CMD_FLUSH)
+  *
+  * @param transferLength The control transfer length. Must be at least 8
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Called by the host after a bulk command response timeout, before it sends any other command. Queued
+  * responses are dropped, a response (or control endpoint data) being sent is aborted, and commands which
+  * are still executing are marked so their responses are dropped when they finish. Returns status[0-3]
+  * and the number of slots still held by executing commands [4-7] over the control endpoint. Those slots
+  * are freed as the commands finish, so the host can repeat the flush to track them.
+ **/
+CyU3PReturnStatus_t AdiBulkCmdFlush(uint16_t transferLength)
+{
+	uint32_t busySlots = 0;
+	uint8_t slot;
+
+	if(transferLength < 8)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMutexGet(&SlotLock, CYU3P_WAIT_FOREVER);
+
+	/* Drop the responses waiting to be sent */
+	while(TxFifoCount)
+	{
+		SlotInUse[TxFifo[TxFifoHead]] = CyFalse;
+		TxFifoHead = (TxFifoHead + 1) % ADI_BULK_CMD_QUEUE_DEPTH;
+		TxFifoCount--;
+	}
+
+	/* Abort the send in progress, and clear anything already in the endpoint buffer */
+	if(TxSlot != ADI_BULK_CMD_NO_SLOT)
+	{
+		CyU3PDmaChannelReset(&ChannelToPC);
+		CyU3PUsbFlushEp(ADI_TO_PC_ENDPOINT);
+		if(TxSlot != ADI_BULK_CMD_DATA_SLOT)
+			SlotInUse[TxSlot] = CyFalse;
+		TxSlot = ADI_BULK_CMD_NO_SLOT;
+	}
+
+	/* Every other slot in use (except the armed one) holds a command which has not responded yet */
+	for(slot = 0; slot < ADI_BULK_CMD_QUEUE_DEPTH; slot++)
+	{
+		if(SlotInUse[slot] && (slot != RxSlot))
+		{
+			SlotDiscard[slot] = CyTrue;
+			busySlots++;
+		}
+	}
+	AdiBulkCmdArm();
+
+	CyU3PMutexPut(&SlotLock);
+
+	USBBuffer[4] = busySlots & 0xFF;
+	USBBuffer[5] = (busySlots & 0xFF00) >> 8;
+	USBBuffer[6] = (busySlots & 0xFF0000) >> 16;
+	USBBuffer[7] = (busySlots & 0xFF000000) >> 24;
+	AdiSendStatus(CY_U3P_SUCCESS, 8, CyTrue);
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Takes the lock on USBBuffer / BulkBuffer. Held by the control endpoint handler for each vendor command.
+  *
+  * @return void
+ **/
+void AdiBulkCmdLockBuffers()
+{
+	CyU3PMutexGet(&BufferLock, CYU3P_WAIT_FOREVER);
+}
+
+/**
+  * @brief Releases the lock on USBBuffer / BulkBuffer.
+  *
+  * @return void
+ **/
+void AdiBulkCmdUnlockBuffers()
+{
+	CyU3PMutexPut(&BufferLock);
+}
+
+/**
+  * @brief Services a received bulk command frame. Called from the AppThread.
+  *
+  * @return void
+  *
+  * Drains the received command queue. Each command is either executed in place, or posted to the
+  * BulkCmdThread queue.
+ **/
+void AdiBulkCmdService()
+{
+	uint32_t slot;
+
+	while(CyU3PQueueReceive(&ReceivedQueue, &slot, CYU3P_NO_WAIT) == CY_U3P_SUCCESS)
+	{
+		if(AdiBulkCmdIsDeferred(SlotFrame[slot][1]))
+		{
+			if(CyU3PQueueSend(&DeferredQueue, &slot, CYU3P_NO_WAIT) == CY_U3P_SUCCESS)
+				continue;
+		}
+		AdiBulkCmdExecute((uint8_t) slot, &AppContext);
+	}
+}
+
+/**
+  * @brief Arms the bulk OUT endpoint with a free command slot. Caller must hold SlotLock.
+  *
+  * @return void
+  *
+  * Does nothing if a slot is already armed, or if all slots are in use. In the latter case the
+  * endpoint is armed when a slot is freed.
+ **/
+static void AdiBulkCmdArm()
+{
+	CyU3PReturnStatus_t status;
+	CyU3PDmaBuffer_t recvBuffer;
+	uint8_t slot;
+
+	if(RxSlot != ADI_BULK_CMD_NO_SLOT)
+		return;
+
+	for(slot = 0; slot < ADI_BULK_CMD_QUEUE_DEPTH; slot++)
+	{
+		if(!SlotInUse[slot])
+			break;
+	}
+	if(slot == ADI_BULK_CMD_QUEUE_DEPTH)
+		return;
+
+	SlotInUse[slot] = CyTrue;
+	RxSlot = slot;
+
+	recvBuffer.buffer = SlotFrame[slot];
+	recvBuffer.size = ADI_BULK_CMD_FRAME_SIZE;
+	recvBuffer.count = 0;
+	recvBuffer.status = 0;
+	status = CyU3PDmaChannelSetupRecvBuffer(&ChannelFromPC, &recvBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(BulkCommand_c, __LINE__, status);
+		SlotInUse[slot] = CyFalse;
+		RxSlot = ADI_BULK_CMD_NO_SLOT;
+	}
+}
+
+/**
+  * @brief Starts sending the next queued response frame. Caller must hold SlotLock.
+  *
+  * @return void
+  *
+  * Does nothing if a response is already being sent. If the send can't be set up the response is
+  * dropped (the host times out) and its slot freed.
+ **/
+static void AdiBulkCmdStartSend()
+{
+	CyU3PReturnStatus_t status;
+	CyU3PDmaBuffer_t sendBuffer;
+	uint8_t slot;
+
+	while((TxSlot == ADI_BULK_CMD_NO_SLOT) && TxFifoCount)
+	{
+		slot = TxFifo[TxFifoHead];
+		TxFifoHead = (TxFifoHead + 1) % ADI_BULK_CMD_QUEUE_DEPTH;
+		TxFifoCount--;
+
+		sendBuffer.buffer = SlotFrame[slot];
+		sendBuffer.size = ADI_BULK_CMD_FRAME_SIZE;
+		sendBuffer.count = SlotLength[slot];
+		sendBuffer.status = 0;
+		status = CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, &sendBuffer);
+		if(status == CY_U3P_SUCCESS)
+		{
+			TxSlot = slot;
+		}
+		else
+		{
+			AdiLogError(BulkCommand_c, __LINE__, status);
+			SlotInUse[slot] = CyFalse;
+			AdiBulkCmdArm();
+		}
+	}
+}
+
+/**
+  * @brief Executes a bulk command and sends its response.
+  *
+  * @param slot The slot holding the command frame
+  *
+  * @param ctx The context of the executing thread
+  *
+  * @return void
+  *
+  * Parses the frame header, dispatches the command, and sends a status only response if the handler
+  * did not send one. The slot is freed when the response has been sent.
+ **/
+static void AdiBulkCmdExecute(uint8_t slot, AdiBulkCmdContext * ctx)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint8_t * frame = SlotFrame[slot];
+	uint16_t value, index;
+	uint8_t regData[2];
+	CyBool_t pinValue;
+
+	/* Parse header */
+	ctx->Slot = slot;
+	ctx->Opcode = frame[1];
+	ctx->Tag = frame[2] | (frame[3] << 8);
+	value = frame[4] | (frame[5] << 8);
+	index = frame[6] | (frame[7] << 8);
+	ctx->PayloadLength = frame[8];
+	ctx->PayloadLength |= (frame[9] << 8);
+	ctx->PayloadLength |= (frame[10] << 16);
+	ctx->PayloadLength |= (frame[11] << 24);
+
+	ctx->Responded = CyFalse;
+	ctx->Active = CyTrue;
+
+	if((SlotLength[slot] < ADI_BULK_CMD_HEADER_LEN) ||
+		(frame[0] != ADI_BULK_CMD_SYNC) ||
+		(ctx->PayloadLength > ADI_BULK_CMD_MAX_PAYLOAD) ||
+		((ctx->PayloadLength + ADI_BULK_CMD_HEADER_LEN) > SlotLength[slot]))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(BulkCommand_c, __LINE__, status);
+	}
+	else
+	{
+		switch(ctx->Opcode)
+		{
+		/* No operation (used to benchmark command throughput) */
+		case ADI_NULL_COMMAND:
+			break;
+
+		/* Register read (index = address). Returns 2 bytes */
+		case ADI_READ_BYTES:
+			status = AdiReadRegData(index, regData);
+			AdiBulkCmdRespond(status, regData, 2);
+			break;
+
+		/* Register byte write (index = address, value = data) */
+		case ADI_WRITE_BYTE:
+			status = AdiWriteRegData(index, value & 0xFF);
+			break;
+
+		/* Drive a pin (index = pin, value = level) */
+		case ADI_SET_PIN:
+			status = AdiSetPin(index, (CyBool_t) value);
+			break;
+
+		/* Read a pin (index = pin). Returns 1 byte */
+		case ADI_READ_PIN:
+			status = AdiReadPinValue(index, &pinValue);
+			regData[0] = (uint8_t) pinValue;
+			AdiBulkCmdRespond(status, regData, 1);
+			break;
+
+		/* Handlers which respond over the bulk endpoint */
+		case ADI_REG_BATCH:
+			CyU3PMutexGet(&BufferLock, CYU3P_WAIT_FOREVER);
+			status = AdiRegBatchHandler(ctx->PayloadLength);
+			CyU3PMutexPut(&BufferLock);
+			break;
+
+		case ADI_RMW:
+			CyU3PMutexGet(&BufferLock, CYU3P_WAIT_FOREVER);
+			status = AdiRegReadModifyWrite(ctx->PayloadLength);
+			CyU3PMutexPut(&BufferLock);
+			break;
+
+		/* Pin measurements (private buffers, no BufferLock) */
+		case ADI_PULSE_WAIT:
+		case ADI_PIN_DELAY_MEASURE:
+			status = AdiBulkCmdRunDeferred(ctx);
+			break;
+
+		case ADI_I2C_BATCH:
+			CyU3PMutexGet(&BufferLock, CYU3P_WAIT_FOREVER);
+			status = AdiI2CBatchHandler(ctx->PayloadLength, value);
+			CyU3PMutexPut(&BufferLock);
+			break;
+
+		case ADI_I2C_SCAN:
+			CyU3PMutexGet(&BufferLock, CYU3P_WAIT_FOREVER);
+			status = AdiI2CScanHandler(ctx->PayloadLength, value);
+			CyU3PMutexPut(&BufferLock);
+			break;
+
+		default:
+			status = CY_U3P_ERROR_NOT_SUPPORTED;
+			break;
+		}
+	}
+
+	/* Every command gets exactly one response */
+	if(!ctx->Responded)
+	{
+		AdiBulkCmdRespond(status, NULL, 0);
+	}
+	ctx->Active = CyFalse;
+}
+
+/**
+  * @brief Gets the bulk command context of the calling thread.
+  *
+  * @return The context, or NULL if the calling thread does not execute bulk commands
+ **/
+static AdiBulkCmdContext * AdiBulkCmdGetContext()
+{
+	CyU3PThread * thread = CyU3PThreadIdentify();
+
+	if(thread == &AppThread)
+		return &AppContext;
+	if(thread == &BulkCmdThread)
+		return &WorkerContext;
+	return NULL;
+}
+
+/**
+  * @brief Checks if a command should be executed by the BulkCmdThread.
+  *
+  * @param opcode The command opcode
+  *
+  * @return CyTrue for long running commands, which must not block the AppThread
+  *
+  * Only commands which do not use the SPI bus are deferred, so SPI transactions are never
+  * interleaved between the two threads.
+ **/
+static CyBool_t AdiBulkCmdIsDeferred(uint8_t opcode)
+{
+	return (opcode == ADI_PULSE_WAIT) || (opcode == ADI_PIN_DELAY_MEASURE);
+}
+
+/**
+  * @brief Runs a pin measurement command, and sends its response.
+  *
+  * @param ctx The context of the executing thread
+  *
+  * @return A status code indicating the success of the measurement
+  *
+  * The parameters are copied from the command payload and the result is sent from a local buffer,
+  * so the measurement never touches USBBuffer / BulkBuffer. The response data matches the control
+  * endpoint version of the command (8 bytes). The measurement holds the pin job interlock
+  * (AdiPinJobClaimMeasure), so streams, pin jobs and router monitor changes are refused while it runs.
+ **/
+static CyU3PReturnStatus_t AdiBulkCmdRunDeferred(AdiBulkCmdContext * ctx)
+{
+	CyU3PReturnStatus_t status;
+	uint8_t params[ADI_PIN_JOB_MAX_PARAMS] = {0};
+	uint8_t results[ADI_PIN_JOB_MAX_RESULT] = {0};
+	uint64_t startTime;
+	uint16_t length;
+
+	/* The pulse wait delay and timeout start when the command starts running */
+	startTime = AdiGetTicks64();
+
+	length = (ctx->PayloadLength > sizeof(params)) ? sizeof(params) : ctx->PayloadLength;
+	status = AdiBulkCmdGetPayload(length, params);
+	if(status == CY_U3P_SUCCESS)
+	{
+		status = AdiPinJobClaimMeasure();
+	}
+	if(status == CY_U3P_SUCCESS)
+	{
+		if(ctx->Opcode == ADI_PULSE_WAIT)
+			status = AdiPulseWaitRun(params, results, startTime);
+		else
+			status = AdiMeasurePinDelayRun(params, results);
+		AdiPinJobReleaseMeasure();
+	}
+
+	AdiBulkCmdRespond(status, results, 8);
+	return status;
+}
@@ -0,0 +1,90 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		BulkCommand.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the bulk endpoint framed command channel
+ **/
+
+#ifndef BULKCOMMAND_H_
+#define BULKCOMMAND_H_
+
+/* Include main */
+#include "main.h"
+
+/** State of the bulk command being executed by a thread */
+typedef struct AdiBulkCmdContext
+{
+	/** Command slot holding the frame */
+	uint8_t Slot;
+
+	/** Command opcode */
+	uint8_t Opcode;
+
+	/** Command tag (echoed in the response) */
+	uint16_t Tag;
+
+	/** Command payload length */
+	uint32_t PayloadLength;
+
+	/** Track if the context is executing a command */
+	CyBool_t Active;
+
+	/** Track if the command has sent its response */
+	CyBool_t Responded;
+}AdiBulkCmdContext;
+
+/* Public function prototypes */
+void AdiBulkCmdThreadEntry(uint32_t input);
+CyU3PReturnStatus_t AdiBulkCmdStart();
+void AdiBulkCmdDmaCallback(CyU3PDmaChannel * handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t * input);
+void AdiBulkCmdSendCallback(CyU3PDmaChannel * handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t * input);
+void AdiBulkCmdService();
+CyBool_t AdiBulkCmdActive();
+CyU3PReturnStatus_t AdiBulkCmdGetPayload(uint16_t length, uint8_t * outBuf);
+void AdiBulkCmdRespond(CyU3PReturnStatus_t status, uint8_t * data, uint32_t length);
+CyU3PReturnStatus_t AdiBulkCmdSendData(CyU3PDmaBuffer_t * buffer);
+void AdiBulkCmdLockBuffers();
+void AdiBulkCmdUnlockBuffers();
+CyU3PReturnStatus_t AdiBulkCmdFlush(uint16_t transferLength);
+
+/** BulkCmdThread allocated stack size (2KB) */
+#define BULKCMDTHREAD_STACK						(0x0800)
+
+/** BulkCmdThread execution priority. Lower than the AppThread, so fast commands pre-empt deferred commands */
+#define BULKCMDTHREAD_PRIORITY					(10)
+
+/** First byte of every command and response frame */
+#define ADI_BULK_CMD_SYNC						(0xA5)
+
+/** Command frame header length. Formatted as sync[0], opcode[1], tag[2-3], value[4-5], index[6-7], payload length[8-11] */
+#define ADI_BULK_CMD_HEADER_LEN					(12)
+
+/** Response frame header length. Formatted as sync[0], opcode[1], tag[2-3], status[4-7], data length[8-11] */
+#define ADI_BULK_RESP_HEADER_LEN				(12)
+
+/** Max command payload / response data length, in bytes */
+#define ADI_BULK_CMD_MAX_PAYLOAD				(4096)
+
+/** Command / response frame buffer size. Holds a header and max payload, rounded up to a multiple of 1024 bytes */
+#define ADI_BULK_CMD_FRAME_SIZE					(5120)
+
+/** Number of command slots. This is the number of commands the host can have in flight */
+#define ADI_BULK_CMD_QUEUE_DEPTH				(4)
+
+/** Slot index indicating no slot */
+#define ADI_BULK_CMD_NO_SLOT					(0xFF)
+
+/** Send slot index indicating ChannelToPC is sending data for a control endpoint command */
+#define ADI_BULK_CMD_DATA_SLOT					(0xFE)
+
+#endif /* BULKCOMMAND_H_ */
@@ -19,17 +19,40 @@
 
 /* Tell the compiler where to find the needed globals */
 extern BoardState FX3State;
+extern StreamState StreamThreadState;
 extern uint8_t FirmwareID[32];
 
 /** Error log buffer. Each error log entry is copied here before being written to flash */
 uint8_t LogBuffer[FLASH_PAGE_SIZE];
 
+/** RAM ring of error log entries waiting to be written to flash */
+static ErrorMsg PendingLogs[LOG_RAM_ENTRIES];
+
+/** Ring write index (free running). Only advanced by AdiLogError */
+static volatile uint32_t PendingHead = 0;
+
+/** Ring read index (free running). Only advanced by a flush */
+static volatile uint32_t PendingTail = 0;
+
+/** Number of errors dropped since the last flush because the RAM ring was full */
+static volatile uint32_t DroppedLogs = 0;
+
+/** Flash log slot the next entry is written to */
+static uint32_t LogHead = 0;
+
+/** Sequence number of the next entry written to flash */
+static uint32_t NextLogSequence = LOG_SEQ_BASE;
+
+/** Track if LogHead and NextLogSequence have been found from the flash contents */
+static CyBool_t LogHeadValid = CyFalse;
+
 /* Private helper function protypes */
+static void FlushPendingLogs(CyBool_t deferToStream);
 static void FindFirmwareVersion(uint8_t* buf);
 static void WriteLogToFlash(ErrorMsg* msg);
 static void WriteLogToDebug(ErrorMsg* msg);
-static uint32_t GetNewLogAddress(uint32_t* TotalLogCount);
-static uint32_t GetLogCount();
+static void FindLogHead();
+static uint32_t ReadLogWord(uint32_t Address);
 
 /**
   * @brief Logs a firmware error to flash memory for later examination
@@ -45,12 +68,17 @@ static uint32_t GetLogCount();
   * When calling this function, the Line parameter should be generated by the C
   * pre-processor using the __LINE__ macro. Internally, this function sets the
   * unit boot time stamp (FX3 boot time), system uptime based on the FX3 RTOS tick clock,
-  * and the FX3 firmware version before logging the error to both the debugger output (serial port)
-  * and flash memory.
+  * and the FX3 firmware version before logging the error to the debugger output (serial port).
+  *
+  * The error is then queued in a RAM ring, and written to flash later by the LogThread. This
+  * keeps the (slow) flash writes, and the I2C re-configuration they need, out of the stream
+  * workers and command handlers which report errors. If the ring is full the error is dropped
+  * (the oldest errors are kept, since they are usually the root cause).
  **/
 void AdiLogError(FileIdentifier File, uint32_t Line, uint32_t ErrorCode)
 {
 	ErrorMsg error = {.FirmwareVersion = {0}};
+	uint32_t intrMask;
 
 	/* Set the uptime */
 	error.Uptime = CyU3PGetTime();
@@ -61,6 +89,9 @@ void AdiLogError(FileIdentifier File, uint32_t Line, uint32_t ErrorCode)
 	/* Set the line */
 	error.Line = Line;
 
+	/* Sequence number is assigned when the entry is written to flash */
+	error.Sequence = LOG_SEQ_EMPTY;
+
 	/* Set the error code */
 	error.ErrorCode = ErrorCode;
 
@@ -73,24 +104,132 @@ void AdiLogError(FileIdentifier File, uint32_t Line, uint32_t ErrorCode)
 	/* Print to debug */
 	WriteLogToDebug(&error);
 
-	/* Store to flash */
-	WriteLogToFlash(&error);
+	/* Queue for the LogThread */
+	intrMask = CyU3PVicDisableAllInterrupts();
+	if((PendingHead - PendingTail) < LOG_RAM_ENTRIES)
+	{
+		PendingLogs[PendingHead & (LOG_RAM_ENTRIES - 1)] = error;
+		PendingHead++;
+	}
+	else
+	{
+		DroppedLogs++;
+	}
+	CyU3PVicEnableInterrupts(intrMask);
 }
 
 /**
-  * @brief Sets the error log count value in flash
+  * @brief Entry point for the LogThread. Writes queued error log entries to flash in the background.
   *
-  * @param count The new error log count value to write to flash
+  * @param input Unused
   *
   * @return void
+  *
+  * Finds the head of the flash log, then pending entries are batch written every LOG_FLUSH_PERIOD_MS, while
+  * no stream is running. Since this is the lowest priority thread, the flush only runs when the
+  * command handlers and stream thread are idle.
  **/
-void WriteErrorLogCount(uint32_t count)
+void AdiLogThreadEntry(uint32_t input)
 {
-	LogBuffer[0] = count & 0xFF;
-	LogBuffer[1] = (count & 0xFF00) >> 8;
-	LogBuffer[2] = (count & 0xFF0000) >> 16;
-	LogBuffer[3] = (count & 0xFF000000) >> 24;
-	AdiFlashWrite(LOG_COUNT_ADDR, 4, LogBuffer);
+	UNUSED(input);
+
+	AdiFlashLock();
+	FindLogHead();
+	AdiFlashUnlock();
+
+	for(;;)
+	{
+		CyU3PThreadSleep(LOG_FLUSH_PERIOD_MS);
+		if((PendingTail != PendingHead) && !StreamThreadState.StreamActive)
+		{
+			FlushPendingLogs(CyTrue);
+		}
+	}
+}
+
+/**
+  * @brief Writes all pending error log entries to flash, even if a stream is running
+  *
+  * @return void
+  *
+  * Called before the FX3 is reset, so queued errors are not lost. This can run in the USB driver thread,
+  * so the flash lock wait is bounded (LOG_STOP_FLUSH_WAIT_MS). If the lock is still held, the flush is
+  * skipped and the queued errors are lost.
+ **/
+void AdiErrorLogFlush()
+{
+	if(!AdiFlashTryLock(LOG_STOP_FLUSH_WAIT_MS))
+	{
+		CyU3PDebugPrint (4, "Error log flush skipped (flash busy)\r\n");
+		return;
+	}
+	FlushPendingLogs(CyFalse);
+	AdiFlashUnlock();
+}
+
+/**
+  * @brief Clears the error log (pending entries and the flash log entries)
+  *
+  * @return void
+  *
+  * The entries are not erased. Instead, the log floor is moved up to the next sequence number, which
+  * hides every entry written so far. New entries continue from the current head, so clearing the log
+  * does not concentrate wear at the start of the ring.
+ **/
+void AdiErrorLogClear()
+{
+	AdiFlashLock();
+	PendingTail = PendingHead;
+	DroppedLogs = 0;
+	if(!LogHeadValid)
+		FindLogHead();
+	LogBuffer[0] = NextLogSequence & 0xFF;
+	LogBuffer[1] = (NextLogSequence & 0xFF00) >> 8;
+	LogBuffer[2] = (NextLogSequence & 0xFF0000) >> 16;
+	LogBuffer[3] = (NextLogSequence & 0xFF000000) >> 24;
+	AdiFlashWrite(LOG_FLOOR_ADDR, 4, LogBuffer);
+	AdiFlashUnlock();
+}
+
+/**
+  * @brief Writes the pending error log entries from the RAM ring to flash
+  *
+  * @param deferToStream Stop early (leaving the rest of the entries queued) if a stream starts
+  *
+  * @return void
+  *
+  * The flash lock is held for the whole flush, so only one flush runs at a time, and each entry is
+  * only removed from the ring once it has been written.
+ **/
+static void FlushPendingLogs(CyBool_t deferToStream)
+{
+	ErrorMsg msg;
+	uint32_t intrMask, dropped;
+
+	AdiFlashLock();
+	if(!LogHeadValid)
+		FindLogHead();
+	while(PendingTail != PendingHead)
+	{
+		if(deferToStream && StreamThreadState.StreamActive)
+			break;
+
+		/* AdiLogError never writes the tail slot while it holds an entry */
+		msg = PendingLogs[PendingTail & (LOG_RAM_ENTRIES - 1)];
+		WriteLogToFlash(&msg);
+		PendingTail++;
+	}
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	dropped = DroppedLogs;
+	DroppedLogs = 0;
+	CyU3PVicEnableInterrupts(intrMask);
+	AdiFlashUnlock();
+
+	if(dropped)
+	{
+		CyU3PDebugPrint (4, "%d errors not logged to flash (error log RAM buffer full)\r\n", dropped);
+	}
 }
 
 /**
@@ -120,43 +259,31 @@ static void FindFirmwareVersion(uint8_t* outBuf)
   *
   * @return void
   *
-  * This function first gets the address for the new buffer entry
-  * from the flash error log ring buffer. It then clears the 32 bytes
-  * which have been allocated in flash for the current error log. The
-  * passed log is then copied byte-wise into the LogBuffer, array,
-  * then written to flash. Finally, the LOG_COUNT variable in flash
-  * is incremented.
+  * The entry is stamped with the next sequence number and written to the head
+  * slot of the flash ring buffer in a single (32 byte, single page) write. The
+  * head and sequence number are only tracked in RAM, so there is no count word
+  * to update. Once the ring is full, newer entries overwrite the oldest entry.
+  * Must be called with the flash lock held, after FindLogHead.
  **/
 static void WriteLogToFlash(ErrorMsg* msg)
 {
-	uint32_t logAddr, logCount;
-	uint8_t* memPtr;
-
-	/* Get the starting address of the next record based on the number of logs stored */
-	logAddr = GetNewLogAddress(&logCount);
-
-	/* Set log buffer to 0xFF*/
-	for(int i = 0; i < 32; i++)
-	{
-		LogBuffer[i] = 0xFF;
-	}
+	uint32_t logAddr;
 
-	/* Apply clear to flash flash */
-	AdiFlashWrite(logAddr, 32, LogBuffer);
+	/* Each entry is 32 bytes, and never crosses a page */
+	logAddr = LOG_BASE_ADDR + (LogHead * sizeof(ErrorMsg));
 
-	/* Copy the error message to the Log Buffer */
-	memPtr = (uint8_t *) msg;
-	for(int i = 0; i < 32; i++)
-	{
-		LogBuffer[i] = memPtr[i];
-	}
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "New log address: 0x%x, sequence: 0x%x\r\n", logAddr, NextLogSequence);
+#endif
 
-	/* Transfer log to flash */
-	AdiFlashWrite(logAddr, 32, LogBuffer);
+	msg->Sequence = NextLogSequence;
+	CyU3PMemCopy(LogBuffer, (uint8_t *) msg, sizeof(ErrorMsg));
+	AdiFlashWrite(logAddr, sizeof(ErrorMsg), LogBuffer);
 
-	/* Increment log count and store back to flash */
-	logCount++;
-	WriteErrorLogCount(logCount);
+	NextLogSequence++;
+	LogHead++;
+	if(LogHead >= LOG_CAPACITY)
+		LogHead = 0;
 }
 
 /**
@@ -172,77 +299,73 @@ static void WriteLogToDebug(ErrorMsg* msg)
 }
 
 /**
-  * @brief Gets address (in flash memory) for a new error log entry
+  * @brief Finds the head of the flash error log, and the next sequence number, from the stored entries
   *
-  * @param TotalLogCount Return by reference for the total number of error log entries stored in flash
-  *
-  * @return The flash address of the new error log entry
+  * @return void
   *
-  * This function implements the error log circular buffer logic
-  * by mod-ing the count with the capacity (newer entries will overwrite
-  * the oldest error log once the buffer is full).
+  * Entries are written to the ring in order, with increasing sequence numbers. So the slots before
+  * the head all hold a sequence number at least as large as slot 0, and the slots from the head on
+  * are empty, older, or were stored by older firmware. That makes the head the first slot which fails
+  * the check, which is found by a binary search (11 sequence number reads for 1500 entries). The
+  * result is cached in RAM. Must be called with the flash lock held.
  **/
-static uint32_t GetNewLogAddress(uint32_t* TotalLogCount)
+static void FindLogHead()
 {
-	/* Get the total lifetime log count from flash */
-	uint32_t count = GetLogCount();
-
-#ifdef VERBOSE_MODE
-	CyU3PDebugPrint (4, "Current error log count: 0x%x\r\n", count);
-#endif
+	uint32_t first, seq, low, high, mid, floor;
 
-	/* Find location of "front" */
-	uint32_t logFlashCount = count % LOG_CAPACITY;
-
-	/* 32 bytes per log */
-	uint32_t addr = logFlashCount * 32;
+	first = ReadLogWord(LOG_BASE_ADDR + LOG_SEQ_OFFSET);
+	if((first == LOG_SEQ_EMPTY) || (first < LOG_SEQ_BASE))
+	{
+		/* No entries in the current format */
+		LogHead = 0;
+		NextLogSequence = LOG_SEQ_BASE;
+	}
+	else
+	{
+		low = 1;
+		high = LOG_CAPACITY;
+		while(low < high)
+		{
+			mid = (low + high) / 2;
+			seq = ReadLogWord(LOG_BASE_ADDR + (mid * sizeof(ErrorMsg)) + LOG_SEQ_OFFSET);
+			if((seq != LOG_SEQ_EMPTY) && (seq >= first))
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		NextLogSequence = ReadLogWord(LOG_BASE_ADDR + ((low - 1) * sizeof(ErrorMsg)) + LOG_SEQ_OFFSET) + 1;
+		LogHead = low;
+		if(LogHead >= LOG_CAPACITY)
+			LogHead = 0;
+	}
 
-	/* Add offset */
-	addr += LOG_BASE_ADDR;
+	/* Sequence numbers must keep increasing past a clear */
+	floor = ReadLogWord(LOG_FLOOR_ADDR);
+	if((floor != LOG_SEQ_EMPTY) && (floor > NextLogSequence))
+		NextLogSequence = floor;
 
-	/* Return total count by reference */
-	*TotalLogCount = count;
+	LogHeadValid = CyTrue;
 
 #ifdef VERBOSE_MODE
-	CyU3PDebugPrint (4, "New Log Address: 0x%x\r\n", addr);
+	CyU3PDebugPrint (4, "Error log head: %d, next sequence: 0x%x\r\n", LogHead, NextLogSequence);
 #endif
-
-	/* Return address to write the new log to */
-	return addr;
 }
 
 /**
-  * @brief Gets the log count from flash
+  * @brief Reads a little endian 32-bit word from flash
+  *
+  * @param Address The flash byte address to read from
   *
-  * @return The current logged error count (from LOG_COUNT)
+  * @return The word read
  **/
-static uint32_t GetLogCount()
+static uint32_t ReadLogWord(uint32_t Address)
 {
-	uint32_t count;
-
-	/* Perform DMA flash read (4 bytes) */
-	AdiFlashRead(LOG_COUNT_ADDR, 4, LogBuffer);
-
-	/* Count values are stored little endian in flash */
-	count = LogBuffer[0];
-	count |= (LogBuffer[1] << 8);
-	count |= (LogBuffer[2] << 16);
-	count |= (LogBuffer[3] << 24);
-
-	/* If count reads as 0 start a single retry */
-	if(count == 0)
-	{
-		AdiFlashRead(LOG_COUNT_ADDR, 4, LogBuffer);
-		count = LogBuffer[0];
-		count |= (LogBuffer[1] << 8);
-		count |= (LogBuffer[2] << 16);
-		count |= (LogBuffer[3] << 24);
-	}
-
-	/* Handle un-initialized log */
-	if(count == 0xFFFFFFFF)
-	{
-		count = 0;
-	}
-	return count;
+	uint32_t value;
+
+	AdiFlashRead(Address, 4, LogBuffer);
+	value = LogBuffer[0];
+	value |= (LogBuffer[1] << 8);
+	value |= (LogBuffer[2] << 16);
+	value |= (LogBuffer[3] << 24);
+	return value;
 }
@@ -29,8 +29,32 @@
 /** The max log capacity for the ring buffer (32 bytes per entry) */
 #define LOG_CAPACITY							1500
 
-/** The flash address of the current log count. This is used to track the head of the error log  */
-#define LOG_COUNT_ADDR							(0x34000)
+/** The flash address of the log floor. Entries with a sequence number below the floor have been cleared. Only written when the log is cleared */
+#define LOG_FLOOR_ADDR							(0x34004)
+
+/** The first sequence number assigned to a log entry. Entries stored by older firmware (with a file code in the sequence field) are always below this */
+#define LOG_SEQ_BASE							(0x100)
+
+/** Sequence number of an empty (erased) log entry */
+#define LOG_SEQ_EMPTY							(0xFFFFFFFF)
+
+/** Byte offset of the sequence number within an ErrorMsg */
+#define LOG_SEQ_OFFSET							(16)
+
+/** Number of error log entries which can be held in RAM while waiting to be written to flash. Must be a power of 2 */
+#define LOG_RAM_ENTRIES							(16)
+
+/** Period (ms) at which the LogThread checks for pending error log entries */
+#define LOG_FLUSH_PERIOD_MS						(100)
+
+/** Max time (ms) a flush before reset waits for the flash lock */
+#define LOG_STOP_FLUSH_WAIT_MS					(100)
+
+/** LogThread allocated stack size (2KB) */
+#define LOGTHREAD_STACK							(0x0800)
+
+/** LogThread execution priority. Lowest of all the ADI threads, so flash writes only happen when the FX3 is otherwise idle */
+#define LOGTHREAD_PRIORITY						(15)
 
 /** Enum to identify the source file which threw an error. More RAM efficient than the __FILE__ directive (gives full path as string) */
 typedef enum FileIdentifier
@@ -66,7 +90,22 @@ typedef enum FileIdentifier
 	I2cFunctions_c = 9,
 
 	/** Error originating from HelperFunctions.c */
-	HelperFunctions_c = 10
+	HelperFunctions_c = 10,
+
+	/** Error originating from RegCache.c */
+	RegCache_c = 11,
+
+	/** Error originating from SpiSequencer.c */
+	SpiSequencer_c = 12,
+
+	/** Error originating from BulkCommand.c */
+	BulkCommand_c = 13,
+
+	/** Error originating from PinJob.c */
+	PinJob_c = 14,
+
+	/** Error originating from GpioRouter.c */
+	GpioRouter_c = 15
 
 }FileIdentifier;
 
@@ -75,15 +114,19 @@ typedef enum FileIdentifier
   *
   * This struct contains all pertinent information about a given hard crash event. This struct is
   * generated By AdiLogError, and stored to flash in a ring buffer. The total size of this
-  * struct is 32 bytes
+  * struct is 32 bytes. There is no separate count word in flash. The head of the ring is the
+  * slot after the entry with the highest sequence number.
  **/
 typedef struct __attribute__((__packed__)) ErrorMsg
 {
 	/** FX3 ThreadX RTOS uptime, in milliseconds (0-3) */
 	uint32_t Uptime;
 
-	/** The line which caused the error. Should be set by __LINE__ macro in AdiLogError call (4-7) */
-	uint32_t Line;
+	/** The line which caused the error. Should be set by __LINE__ macro in AdiLogError call (4-5) */
+	uint16_t Line;
+
+	/** The file which originated the error. Is file identifier casted into uint (6-7) */
+	uint16_t File;
 
 	/** The error code from the set of cypress defined error codes (8 - 11) */
 	uint32_t ErrorCode;
@@ -91,8 +134,8 @@ typedef struct __attribute__((__packed__)) ErrorMsg
 	/** The Unix time stamp for when the instance of the FX3 booted. Set by the host PC (12 - 15) */
 	uint32_t BootTimeCode;
 
-	/** The file which originated the error. Is file identifier casted into uint (16 - 19) */
-	uint32_t File;
+	/** Log entry sequence number. Increases by one for each entry written to flash, and is used to find the head of the log (16 - 19) */
+	uint32_t Sequence;
 
 	/** The firmware version number string (20 - 31) */
 	uint8_t FirmwareVersion[12];
@@ -100,6 +143,8 @@ typedef struct __attribute__((__packed__)) ErrorMsg
 
 /* External functions */
 void AdiLogError(FileIdentifier File, uint32_t Line, uint32_t ErrorCode);
-void WriteErrorLogCount(uint32_t count);
+void AdiLogThreadEntry(uint32_t input);
+void AdiErrorLogFlush();
+void AdiErrorLogClear();
 
 #endif /* ERRORLOG_H_ */
@@ -24,14 +24,64 @@ static CyU3PReturnStatus_t FlashTransfer(uint32_t Address, uint16_t NumBytes, ui
 /** Global USB Buffer, from main */
 extern uint8_t USBBuffer[4096];
 
+/** Global bulk endpoint buffer, from main */
+extern uint8_t BulkBuffer[12288];
+
 /** FX3 state (from main) */
 extern BoardState FX3State;
 
-/** I2C Tx DMA channel handle */
-static CyU3PDmaChannel flashTxHandle;
+/** Serializes flash transfers, and holds them off while the I2C block is in use by other commands */
+static CyU3PMutex FlashLock;
 
-/** I2C Rx DMA channel handle */
-static CyU3PDmaChannel flashRxHandle;
+/**
+  * @brief Creates the flash lock
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Called from CyFxApplicationDefine, before any of the threads which use the flash or I2C block are created.
+ **/
+CyU3PReturnStatus_t AdiFlashCreateLock()
+{
+	return CyU3PMutexCreate(&FlashLock, CYU3P_INHERIT);
+}
+
+/**
+  * @brief Takes the flash lock
+  *
+  * @return void
+  *
+  * Each flash transfer re-configures the I2C block in register mode at FLASH_BIT_RATE, so any other code
+  * which uses the I2C block holds the lock to keep a background error log flush from interleaving with it.
+  * The lock can be nested by the owning thread.
+ **/
+void AdiFlashLock()
+{
+	CyU3PMutexGet(&FlashLock, CYU3P_WAIT_FOREVER);
+}
+
+/**
+  * @brief Takes the flash lock, giving up if it is not free within a bounded time
+  *
+  * @param waitMs The max time (ms) to wait for the lock
+  *
+  * @return CyTrue if the lock was taken (release with AdiFlashUnlock), CyFalse otherwise
+  *
+  * Used by callers which must not block indefinitely, such as the USB driver thread during shut down.
+ **/
+CyBool_t AdiFlashTryLock(uint32_t waitMs)
+{
+	return (CyU3PMutexGet(&FlashLock, waitMs) == CY_U3P_SUCCESS);
+}
+
+/**
+  * @brief Releases the flash lock
+  *
+  * @return void
+ **/
+void AdiFlashUnlock()
+{
+	CyU3PMutexPut(&FlashLock);
+}
 
 /**
   * @brief Initializes flash memory interface module
@@ -39,15 +89,15 @@ static CyU3PDmaChannel flashRxHandle;
   * @return Status code indication the success of the flash init operation
   *
   * The FX3 board features a ST m24m02-dr I2C EEPROM. This function
-  * initializes the FX3 I2C block to operate in DMA mode with the max
-  * supported I2C clock. It then configures the I2C Rx and Tx channels
-  * to perform a transfer
+  * initializes the FX3 I2C block to operate in register mode with the max
+  * supported I2C clock. Register mode allows a single read transaction of
+  * any length, so sequential reads are not split at the EEPROM page size.
  **/
 CyU3PReturnStatus_t AdiFlashInit()
 {
     CyU3PI2cConfig_t i2cConfig = {0};
-    CyU3PDmaChannelConfig_t i2cDmaConfig = {0};
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+    uint32_t timeout;
 
     /* Initialize and configure the I2C master module. */
     CyU3PI2cDeInit();
@@ -60,12 +110,12 @@ CyU3PReturnStatus_t AdiFlashInit()
         return status;
     }
 
-    /* Start the I2C master block. Set i2c clock of 100KHz, DMA mode */
+    /* Start the I2C master block. Set i2c clock of 1MHz, register mode */
     CyU3PMemSet ((uint8_t *)&i2cConfig, 0, sizeof(i2cConfig));
-    i2cConfig.bitRate    = 1000000;
+    i2cConfig.bitRate    = FLASH_BIT_RATE;
     i2cConfig.busTimeout = 0xFFFFFFFF;
     i2cConfig.dmaTimeout = 0xFFFF;
-    i2cConfig.isDma      = CyTrue;
+    i2cConfig.isDma      = CyFalse;
 
     status = CyU3PI2cSetConfig (&i2cConfig, NULL);
     if (status != CY_U3P_SUCCESS)
@@ -76,41 +126,9 @@ CyU3PReturnStatus_t AdiFlashInit()
         return status;
     }
 
-    /* Now create the DMA channels required for read and write. */
-    CyU3PMemSet ((uint8_t *)&i2cDmaConfig, 0, sizeof(i2cDmaConfig));
-    i2cDmaConfig.size           = FLASH_PAGE_SIZE;
-    i2cDmaConfig.count          = 0;
-    i2cDmaConfig.prodAvailCount = 0;
-    i2cDmaConfig.dmaMode        = CY_U3P_DMA_MODE_BYTE;
-    i2cDmaConfig.prodHeader     = 0;
-    i2cDmaConfig.prodFooter     = 0;
-    i2cDmaConfig.consHeader     = 0;
-    i2cDmaConfig.notification   = 0;
-    i2cDmaConfig.cb             = NULL;
-
-    /* Create a channel to write to the EEPROM. */
-    i2cDmaConfig.prodSckId = CY_U3P_CPU_SOCKET_PROD;
-    i2cDmaConfig.consSckId = CY_U3P_LPP_SOCKET_I2C_CONS;
-    status = CyU3PDmaChannelCreate(&flashTxHandle, CY_U3P_DMA_TYPE_MANUAL_OUT, &i2cDmaConfig);
-    if (status != CY_U3P_SUCCESS)
-    {
-#ifdef VERBOSE_MODE
-    	CyU3PDebugPrint (4, "Setting I2C Tx DMA channel failed! 0x%x\r\n", status);
-#endif
-        return status;
-    }
-
-    /* Create a channel to read from the EEPROM. */
-    i2cDmaConfig.prodSckId = CY_U3P_LPP_SOCKET_I2C_PROD;
-    i2cDmaConfig.consSckId = CY_U3P_CPU_SOCKET_CONS;
-    status = CyU3PDmaChannelCreate (&flashRxHandle, CY_U3P_DMA_TYPE_MANUAL_IN, &i2cDmaConfig);
-    if (status != CY_U3P_SUCCESS)
-    {
-#ifdef VERBOSE_MODE
-    	CyU3PDebugPrint (4, "Setting I2C Rx DMA channel failed! 0x%x\r\n", status);
-#endif
-        return status;
-    }
+    /* Apply flash timeout (arguments are in microseconds) */
+    timeout = FLASH_TIMEOUT_MS * 1000;
+    CyU3PI2cSetTimeout(timeout, timeout, timeout);
 
     /* Return status code */
     return status;
@@ -121,15 +139,11 @@ CyU3PReturnStatus_t AdiFlashInit()
   *
   * @return void
   *
-  * This functions destroys the DMA channels used for interfacing
-  * with the I2C module, and re-inits the I2C controller to operate
-  * in register mode, with the previously selected bitrate.
+  * This function re-inits the I2C controller to operate in register mode,
+  * with the previously selected (user) bitrate.
  **/
 void AdiFlashDeInit()
 {
-	CyU3PI2cDeInit();
-	CyU3PDmaChannelDestroy(&flashTxHandle);
-	CyU3PDmaChannelDestroy(&flashRxHandle);
 	/* Re-init I2C for use in register mode */
 	AdiI2CInit(FX3State.I2CBitRate, CyFalse);
 }
@@ -181,7 +195,7 @@ void AdiFlashRead(uint32_t Address, uint16_t NumBytes, uint8_t* ReadBuf)
 }
 
 /**
-  * @brief Handles flash read requests from control endpoint
+  * @brief Handles flash read requests from control endpoint, returning the data over the control endpoint
   *
   * @param Address The byte address in flash to start reading at
   *
@@ -206,6 +220,62 @@ void AdiFlashReadHandler(uint32_t Address, uint16_t NumBytes)
 	CyU3PUsbSendEP0Data(NumBytes, USBBuffer);
 }
 
+/**
+  * @brief Handles flash read requests which return the data over the bulk endpoint
+  *
+  * @param Address The byte address in flash to start reading at
+  *
+  * @param transferLength The number of bytes in the request data phase
+  *
+  * @return A status code indicating if the request data could be read.
+  *
+  * The request data is the number of bytes to read[0-3] (max FLASH_BULK_READ_MAX). The response is
+  * status[0-3], then the data read. This allows the whole error log region to be read in a few
+  * transfers, instead of one control transfer per 4KB.
+ **/
+CyU3PReturnStatus_t AdiFlashBulkReadHandler(uint32_t Address, uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status;
+	uint32_t numBytes;
+
+	if(transferLength < 4)
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(Flash_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(Flash_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	numBytes = USBBuffer[0];
+	numBytes |= (USBBuffer[1] << 8);
+	numBytes |= (USBBuffer[2] << 16);
+	numBytes |= (USBBuffer[3] << 24);
+
+	/* Validate read range */
+	if((numBytes > FLASH_BULK_READ_MAX) || ((Address + numBytes) > FLASH_SIZE))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(Flash_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Read data is placed after the status */
+	status = FlashTransfer(Address, numBytes, BulkBuffer + 4, CyTrue);
+	AdiReturnBulkEndpointData(status, numBytes + 4);
+
+	/* Flash failures are reported in the response */
+	return CY_U3P_SUCCESS;
+}
+
 /**
   * @brief Performs a transfer from the I2C flash memory
   *
@@ -221,60 +291,48 @@ void AdiFlashReadHandler(uint32_t Address, uint16_t NumBytes)
   *
   * This function performs all interfacing with the ST m24m02-dr I2C EEPROM which is
   * included on the iSensor FX3 board (and FX3 explorer kit). Before each transaction,
-  * AdiFlashInit is called to ensure the flash and DMA are configured properly. Then, for
-  * each transaction, the read/write is split into 64 byte (or less) chunks, which are
-  * each performed using a single I2C<->Mem DMA transfer. Once all required transfers have
-  * been performed, the flash is de-initialized.
+  * the flash lock is taken and AdiFlashInit is called to ensure the I2C block is configured
+  * properly.
+  *
+  * Reads are performed as a single sequential read for each 64KB block (the upper
+  * address bits are part of the device address), with no delay. Writes are split on
+  * page boundaries. After each page write, the EEPROM is ACK polled (it NAKs its
+  * device address until the internal write cycle is done), so each page only takes as
+  * long as the write cycle actually needs, instead of a fixed sleep. Once all required
+  * transfers have been performed, the flash is de-initialized.
  **/
 static CyU3PReturnStatus_t FlashTransfer(uint32_t Address, uint16_t NumBytes, uint8_t* Buf, CyBool_t isRead)
 {
-    CyU3PDmaBuffer_t buf_p = {0};
     CyU3PI2cPreamble_t preamble = {.buffer = {0}};
+    CyU3PI2cPreamble_t ackPoll = {.buffer = {0}};
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-    uint16_t dmaCount;
-    uint16_t lastCount;
+    uint32_t count;
 
     /* device address (upper two address bits encoded into device address) */
     uint16_t device_address;
 
-    /* Calculate page count */
-    uint16_t pageCount = (NumBytes / FLASH_PAGE_SIZE);
-
     /* Return for zero length transfer */
     if(NumBytes == 0)
         return CY_U3P_SUCCESS;
 
-    /* Check if extra bytes which fall onto another page */
-    lastCount = (NumBytes % FLASH_PAGE_SIZE);
-    if(lastCount != 0)
-        pageCount ++;
-    else
-    	lastCount = FLASH_PAGE_SIZE;
+    /* Hold off other users of the I2C block */
+    AdiFlashLock();
 
     /* Init flash */
     AdiFlashInit();
 
-    /* Update the buffer status. */
-    buf_p.status = 0;
-	/* Update buffer address */
-	buf_p.buffer = Buf;
-
-    while (pageCount != 0)
+    while (NumBytes != 0)
     {
     	/* Get device addr */
     	device_address = GetFlashDeviceAddress(Address);
-    	/* Get transfer count */
-    	if(pageCount > 1)
-    		dmaCount = FLASH_PAGE_SIZE;
-    	else
-    		dmaCount = lastCount;
-
-#ifdef VERBOSE_MODE
-    	CyU3PDebugPrint (4, "I2C access: Dev addr: 0x%x Byte Addr: 0x%x, size: 0x%x, pages: 0x%x read: %d\r\n", device_address, Address, dmaCount, pageCount, isRead);
-#endif
 
     	if(isRead)
     	{
+    		/* Sequential read to the end of the 64KB block */
+    		count = 0x10000 - (Address & 0xFFFF);
+    		if(count > NumBytes)
+    			count = NumBytes;
+
             /* Update the preamble information. */
             preamble.length    = 4;
             preamble.buffer[0] = device_address;
@@ -283,24 +341,19 @@ static CyU3PReturnStatus_t FlashTransfer(uint32_t Address, uint16_t NumBytes, ui
             preamble.buffer[3] = (device_address | 0x01);
             preamble.ctrlMask  = 0x0004;
 
-            buf_p.size = FLASH_PAGE_SIZE;
-            buf_p.count = dmaCount;
-
-            /* Send read command */
-            status = CyU3PI2cSendCommand(&preamble, dmaCount, CyTrue);
-#ifdef VERBOSE_MODE
-            if(status != CY_U3P_SUCCESS)
-            	CyU3PDebugPrint (4, "I2C send read command failed: 0x%x\r\n", status);
-#endif
-            /* Set up DMA to receive read data */
-            status = CyU3PDmaChannelSetupRecvBuffer (&flashRxHandle, &buf_p);
+            status = CyU3PI2cReceiveBytes(&preamble, Buf, count, 0);
 #ifdef VERBOSE_MODE
             if(status != CY_U3P_SUCCESS)
-            	CyU3PDebugPrint (4, "I2C DMA Rx channel setup failed: 0x%x\r\n", status);
+            	CyU3PDebugPrint (4, "I2C flash read failed: 0x%x\r\n", status);
 #endif
     	}
     	else
     	{
+    		/* Page write, up to the end of the page */
+    		count = FLASH_PAGE_SIZE - (Address & (FLASH_PAGE_SIZE - 1));
+    		if(count > NumBytes)
+    			count = NumBytes;
+
             /* Update the preamble information. */
             preamble.length    = 3;
             preamble.buffer[0] = device_address;
@@ -308,36 +361,37 @@ static CyU3PReturnStatus_t FlashTransfer(uint32_t Address, uint16_t NumBytes, ui
             preamble.buffer[2] = (uint8_t)(Address & 0xFF);
             preamble.ctrlMask  = 0x0000;
 
-            buf_p.size = FLASH_PAGE_SIZE;
-            buf_p.count = dmaCount;
-
-            /* Setup DMA transmit buffer */
-            status = CyU3PDmaChannelSetupSendBuffer (&flashTxHandle, &buf_p);
+            status = CyU3PI2cTransmitBytes(&preamble, Buf, count, 0);
 #ifdef VERBOSE_MODE
             if(status != CY_U3P_SUCCESS)
-            	CyU3PDebugPrint (4, "I2C DMA Tx channel setup failed: 0x%x\r\n", status);
+            	CyU3PDebugPrint (4, "I2C flash write failed: 0x%x\r\n", status);
 #endif
-            /* Send write command */
-            status = CyU3PI2cSendCommand (&preamble, dmaCount, CyFalse);
+            if(status == CY_U3P_SUCCESS)
+            {
+            	/* Wait for the write cycle to finish */
+            	ackPoll.length    = 1;
+            	ackPoll.buffer[0] = device_address;
+            	ackPoll.ctrlMask  = 0x0000;
+            	status = CyU3PI2cWaitForAck(&ackPoll, FLASH_ACK_POLL_RETRIES);
 #ifdef VERBOSE_MODE
-            if(status != CY_U3P_SUCCESS)
-            	CyU3PDebugPrint (4, "I2C send write command failed: 0x%x\r\n", status);
+            	if(status != CY_U3P_SUCCESS)
+            		CyU3PDebugPrint (4, "I2C flash write cycle ACK poll failed: 0x%x\r\n", status);
 #endif
+            }
     	}
-        /* Stall for 20ms */
-        CyU3PThreadSleep(20);
-        /* Wait for finish */
-        status = CyU3PI2cWaitForBlockXfer(isRead);
+
 #ifdef VERBOSE_MODE
-        if(status != CY_U3P_SUCCESS)
-        	CyU3PDebugPrint (4, "I2C DMA wait for completion failed: 0x%x\r\n", status);
+    	CyU3PDebugPrint (4, "I2C access: Dev addr: 0x%x Byte Addr: 0x%x, size: 0x%x, read: %d\r\n", device_address, Address, count, isRead);
 #endif
 
-        /* decrement page count */
-        pageCount --;
+        /* Flash errors are not logged, since the error log is stored in flash */
+        if(status != CY_U3P_SUCCESS)
+        	break;
+
         /* Increment address */
-        Address += dmaCount;
-        buf_p.buffer += dmaCount;
+        NumBytes -= count;
+        Address += count;
+        Buf += count;
     }
 
 #ifdef VERBOSE_MODE
@@ -347,6 +401,8 @@ static CyU3PReturnStatus_t FlashTransfer(uint32_t Address, uint16_t NumBytes, ui
     /* De-Init flash */
     AdiFlashDeInit();
 
+    AdiFlashUnlock();
+
     /* Return the status code */
     return status;
 }
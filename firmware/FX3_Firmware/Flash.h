@@ -30,6 +30,11 @@ void AdiFlashDeInit();
 void AdiFlashWrite(uint32_t Address, uint16_t NumBytes, uint8_t* WriteBuf);
 void AdiFlashRead(uint32_t Address, uint16_t NumBytes, uint8_t* ReadBuf);
 void AdiFlashReadHandler(uint32_t Address, uint16_t NumBytes);
+CyU3PReturnStatus_t AdiFlashBulkReadHandler(uint32_t Address, uint16_t transferLength);
+CyU3PReturnStatus_t AdiFlashCreateLock();
+void AdiFlashLock();
+CyBool_t AdiFlashTryLock(uint32_t waitMs);
+void AdiFlashUnlock();
 
 /** Page size for attached i2c flash memory (64 bytes)  */
 #define FLASH_PAGE_SIZE		0x40
@@ -37,4 +42,16 @@ void AdiFlashReadHandler(uint32_t Address, uint16_t NumBytes);
 /** Flash operation timeout  */
 #define FLASH_TIMEOUT_MS	5000
 
+/** I2C bit rate used for flash transfers (max supported by the EEPROM) */
+#define FLASH_BIT_RATE		1000000
+
+/** Flash size, in bytes (256KB) */
+#define FLASH_SIZE			0x40000
+
+/** Number of ACK polls after a page write before giving up. Each poll is a single address byte (~10us at 1MHz) */
+#define FLASH_ACK_POLL_RETRIES	2000
+
+/** Max number of bytes in a single bulk flash read (bulk buffer, less the status) */
+#define FLASH_BULK_READ_MAX	12284
+
 #endif /* FLASH_H_ */
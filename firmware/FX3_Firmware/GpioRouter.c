@@ -0,0 +1,429 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		GpioRouter.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		GPIO interrupt router, with per-pin edge counters.
+  *
+  * Every GPIO interrupt (other than the timer rollover) is dispatched through a table indexed by
+  * the GPIO number. Each route counts the edges on its pin, records the extended timer value of the
+  * last edge, sets the pin's GpioHandler event flag (for the mapped DIO / GPIO pins) and calls an
+  * optional firmware callback. The host can start counting edges on any pin, and read back every
+  * counter in a single control transfer, without running a dedicated measurement command.
+  *
+  * The GPIO interrupt vector is masked while a stream or a polled pin measurement is running, since
+  * those poll the pin interrupt bits directly (and the SDK GPIO ISR clears the bits it handles). All
+  * masking goes through AdiGpioRouterMask / AdiGpioRouterUnmask, which count the holders, so one user
+  * finishing never unmasks the vector under another. The workers count each data ready edge they consume through
+  * AdiGpioRouterCountEdge, so the data ready counter stays valid during streams. Edges on any other pin are
+  * only latched by the GPIO block while the vector is masked, so a stream can't start while another pin is
+  * monitored (AdiGpioRouterStreamConflict).
+ **/
+
+#include "GpioRouter.h"
+
+/* Tell the compiler where to find the needed globals */
+extern BoardState FX3State;
+extern CyU3PEvent GpioHandler;
+extern uint8_t USBBuffer[4096];
+
+extern StreamState StreamThreadState;
+
+/** Route table, indexed by GPIO number */
+static GpioRoute Routes[ADI_GPIO_ROUTER_NUM_PINS];
+
+/** Number of holders of the GPIO / VBUS interrupt vector mask */
+static volatile uint32_t MaskCount = 0;
+
+/** Mask is held on behalf of a data stream */
+static volatile CyBool_t StreamMaskHeld = CyFalse;
+
+/**
+  * @brief Records a single edge on a route.
+  *
+  * @param gpioId The pin which saw the edge
+  *
+  * @return void
+ **/
+static inline void AdiGpioRouterRecord(uint8_t gpioId)
+{
+	GpioRoute * route = &Routes[gpioId];
+	uint64_t timestamp;
+
+	timestamp = AdiGetTicks64();
+	route->EdgeCount++;
+	route->LastEdgeTime = timestamp;
+
+	if(route->EventFlag)
+		CyU3PEventSet(&GpioHandler, route->EventFlag, CYU3P_EVENT_OR);
+
+	if(route->Callback)
+		route->Callback(gpioId, timestamp);
+}
+
+/**
+  * @brief Clears the route table and assigns the GpioHandler event flags for the mapped pins.
+  *
+  * @return void
+  *
+  * Must be called after the board pin map is set, and before the GPIO interrupt can fire.
+ **/
+void AdiGpioRouterInit()
+{
+	CyU3PMemSet((uint8_t *) Routes, 0, sizeof(Routes));
+
+	Routes[FX3State.PinMap.ADI_PIN_DIO1].EventFlag = ADI_DIO1_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.ADI_PIN_DIO2].EventFlag = ADI_DIO2_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.ADI_PIN_DIO3].EventFlag = ADI_DIO3_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.ADI_PIN_DIO4].EventFlag = ADI_DIO4_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.FX3_PIN_GPIO1].EventFlag = FX3_GPIO1_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.FX3_PIN_GPIO2].EventFlag = FX3_GPIO2_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.FX3_PIN_GPIO3].EventFlag = FX3_GPIO3_INTERRUPT_FLAG;
+	Routes[FX3State.PinMap.FX3_PIN_GPIO4].EventFlag = FX3_GPIO4_INTERRUPT_FLAG;
+}
+
+/**
+  * @brief Dispatches a GPIO interrupt to its route. Called from the GPIO ISR.
+  *
+  * @param gpioId The pin number of the pin which generated the interrupt
+  *
+  * @return void
+ **/
+void AdiGpioRouterDispatch(uint8_t gpioId)
+{
+	if(gpioId >= ADI_GPIO_ROUTER_NUM_PINS)
+		return;
+
+	AdiGpioRouterRecord(gpioId);
+}
+
+/**
+  * @brief Counts an edge which was consumed by polling, instead of through the GPIO ISR.
+  *
+  * @param gpioId The pin which saw the edge
+  *
+  * @return void
+  *
+  * Used by the stream workers for the data ready edges they wait on. Interrupts are held off
+  * so the update can't be split by a snapshot and clear.
+ **/
+void AdiGpioRouterCountEdge(uint8_t gpioId)
+{
+	uint32_t intrMask;
+
+	if(gpioId >= ADI_GPIO_ROUTER_NUM_PINS)
+		return;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	AdiGpioRouterRecord(gpioId);
+	CyU3PVicEnableInterrupts(intrMask);
+}
+
+/**
+  * @brief Attaches a firmware callback to a pin route.
+  *
+  * @param gpioId The pin to attach the callback to
+  *
+  * @param callback The function to call on each edge (NULL to remove)
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The callback only sees the edges which the pin is configured to interrupt on.
+ **/
+CyU3PReturnStatus_t AdiGpioRouterSetCallback(uint8_t gpioId, AdiGpioEdgeCallback callback)
+{
+	if(gpioId >= ADI_GPIO_ROUTER_NUM_PINS)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	Routes[gpioId].Callback = callback;
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Checks if the host has any pins being monitored.
+  *
+  * @return CyTrue if the GPIO interrupt must stay enabled for the edge counters
+ **/
+CyBool_t AdiGpioRouterActive()
+{
+	int i;
+
+	for(i = 0; i < ADI_GPIO_ROUTER_NUM_PINS; i++)
+	{
+		if(Routes[i].Monitored)
+			return CyTrue;
+	}
+	return CyFalse;
+}
+
+/**
+  * @brief Checks if the monitored pins can't be counted while a stream is running.
+  *
+  * @param bRequest The stream start vendor command
+  *
+  * @return CyTrue if a pin other than the data ready pin is monitored
+  *
+  * A stream masks the GPIO vector, and only counts the data ready edges it consumes (the SPI, I2C, bit bang and
+  * sequencer streams, when DrActive is set). The edge and logic capture streams don't wait on data ready. Every
+  * edge on any other monitored pin would be merged into a single count, so the stream start is rejected.
+ **/
+CyBool_t AdiGpioRouterStreamConflict(uint8_t bRequest)
+{
+	CyBool_t countsDr;
+	int i;
+
+	countsDr = (CyBool_t) (FX3State.DrActive && (bRequest != ADI_EDGE_CAPTURE_STREAM) && (bRequest != ADI_LOGIC_CAPTURE_STREAM));
+	for(i = 0; i < ADI_GPIO_ROUTER_NUM_PINS; i++)
+	{
+		if(Routes[i].Monitored && !(countsDr && (i == FX3State.DrPin)))
+			return CyTrue;
+	}
+	return CyFalse;
+}
+
+/**
+  * @brief Masks the GPIO and VBUS interrupt vectors, for code which polls the pin interrupt bits.
+  *
+  * @return void
+  *
+  * Each call must be paired with a call to AdiGpioRouterUnmask. The vectors are masked by the first
+  * holder, and are unmasked when the last holder releases them.
+ **/
+void AdiGpioRouterMask()
+{
+	uint32_t intrMask;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	if(MaskCount == 0)
+	{
+		CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+		CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	}
+	MaskCount++;
+	CyU3PVicEnableInterrupts(intrMask);
+}
+
+/**
+  * @brief Releases one hold on the GPIO and VBUS interrupt vector mask.
+  *
+  * @return void
+ **/
+void AdiGpioRouterUnmask()
+{
+	uint32_t intrMask;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	if(MaskCount > 0)
+	{
+		MaskCount--;
+		if(MaskCount == 0)
+		{
+			CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+			CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+		}
+	}
+	CyU3PVicEnableInterrupts(intrMask);
+}
+
+/**
+  * @brief Takes or releases the interrupt vector mask held for a data stream.
+  *
+  * @param mask CyTrue when a stream starts, CyFalse when it is cleaned up
+  *
+  * @return void
+  *
+  * Stream start and cleanup are not always paired (a stream may be restarted, or cleaned up twice),
+  * so the stream holds at most one count.
+ **/
+void AdiGpioRouterStreamMask(CyBool_t mask)
+{
+	uint32_t intrMask;
+	CyBool_t changed;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	changed = (StreamMaskHeld != mask);
+	StreamMaskHeld = mask;
+	CyU3PVicEnableInterrupts(intrMask);
+
+	if(!changed)
+		return;
+
+	if(mask)
+		AdiGpioRouterMask();
+	else
+		AdiGpioRouterUnmask();
+}
+
+/**
+  * @brief Checks if a data stream is holding the GPIO interrupt vector mask.
+  *
+  * @return CyTrue from stream start until the stream is cleaned up
+ **/
+CyBool_t AdiGpioRouterStreamMasked()
+{
+	return StreamMaskHeld;
+}
+
+/**
+  * @brief Checks if the GPIO interrupt vector is masked.
+  *
+  * @return CyTrue if a stream or pin measurement is holding the vector mask
+ **/
+CyBool_t AdiGpioRouterMasked()
+{
+	return (MaskCount != 0);
+}
+
+/**
+  * @brief Starts or stops counting edges on a pin.
+  *
+  * @param pin The pin to monitor
+  *
+  * @param edge The edge(s) to count. 0 falling, 1 rising, 2 both, 0xFF to stop monitoring
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Monitoring can't be changed while a stream or pin measurement is running. Those poll the pin
+  * interrupt bits with the GPIO vector masked, and re-configuring a pin (or unmasking the vector)
+  * under them would drop the edges they are waiting on.
+ **/
+static CyU3PReturnStatus_t AdiGpioRouterMonitor(uint16_t pin, uint8_t edge)
+{
+	CyU3PReturnStatus_t status;
+	CyU3PGpioIntrMode_t intrMode;
+
+	if(!AdiIsValidGPIO(pin))
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	if(AdiGpioRouterMasked() || StreamThreadState.StreamActive || AdiPinJobBusy())
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+
+	if(edge == 0)
+		intrMode = CY_U3P_GPIO_INTR_NEG_EDGE;
+	else if(edge == 1)
+		intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
+	else if(edge == 2)
+		intrMode = CY_U3P_GPIO_INTR_BOTH_EDGE;
+	else
+		intrMode = CY_U3P_GPIO_NO_INTR;
+
+	status = AdiConfigurePinEdgeInterrupt(pin, intrMode);
+	if(status != CY_U3P_SUCCESS)
+		return status;
+
+	/* Clear any edge latched before monitoring started */
+	GPIO->lpp_gpio_simple[pin] |= CY_U3P_LPP_GPIO_INTR;
+
+	Routes[pin].Monitored = (intrMode != CY_U3P_GPIO_NO_INTR);
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "GPIO router monitor pin %d, edge %d\r\n", pin, edge);
+#endif
+
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Sends a snapshot of the edge counters to the PC over the control endpoint.
+  *
+  * @param clear Clear the counters once they are copied
+  *
+  * @param transferLength The number of bytes requested by the PC
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * All counters are copied with interrupts held off, so every entry in the snapshot lines up with
+  * the snapshot time. Only the mapped pins, monitored pins, and pins which have counted edges are
+  * reported. Each entry is pin[0], edge count[1-4], last edge time[5-12].
+ **/
+static CyU3PReturnStatus_t AdiGpioRouterSnapshot(CyBool_t clear, uint16_t transferLength)
+{
+	uint8_t * entry = USBBuffer + ADI_GPIO_ROUTER_HEADER_LEN;
+	uint32_t intrMask, count;
+	uint64_t now;
+	uint8_t numEntries = 0;
+	int i;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+	now = AdiGetTicks64();
+	for(i = 0; i < ADI_GPIO_ROUTER_NUM_PINS; i++)
+	{
+		count = Routes[i].EdgeCount;
+		if(Routes[i].EventFlag || Routes[i].Monitored || count)
+		{
+			entry[0] = i;
+			entry[1] = count & 0xFF;
+			entry[2] = (count & 0xFF00) >> 8;
+			entry[3] = (count & 0xFF0000) >> 16;
+			entry[4] = (count & 0xFF000000) >> 24;
+			AdiTicks64ToBuffer(Routes[i].LastEdgeTime, entry + 5);
+			entry += ADI_GPIO_ROUTER_ENTRY_LEN;
+			numEntries++;
+		}
+		if(clear)
+		{
+			Routes[i].EdgeCount = 0;
+		}
+	}
+	CyU3PVicEnableInterrupts(intrMask);
+
+	USBBuffer[0] = 0;
+	USBBuffer[1] = 0;
+	USBBuffer[2] = 0;
+	USBBuffer[3] = 0;
+	AdiTicks64ToBuffer(now, USBBuffer + 4);
+	USBBuffer[12] = numEntries;
+
+	count = ADI_GPIO_ROUTER_HEADER_LEN + (numEntries * ADI_GPIO_ROUTER_ENTRY_LEN);
+	if(transferLength > count)
+		transferLength = count;
+	return CyU3PUsbSendEP0Data(transferLength, USBBuffer);
+}
+
+/**
+  * @brief Handles the ADI_GPIO_ROUTER vendor command.
+  *
+  * @param action The router action (wIndex)
+  *
+  * @param value The action argument (wValue)
+  *
+  * @param transferLength The number of bytes requested by the PC (wLength)
+  *
+  * @return A status code indicating the success of the function.
+ **/
+CyU3PReturnStatus_t AdiGpioRouterHandler(uint16_t action, uint16_t value, uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status;
+
+	switch(action)
+	{
+	case ADI_GPIO_ROUTER_SNAPSHOT:
+		return AdiGpioRouterSnapshot(CyFalse, transferLength);
+	case ADI_GPIO_ROUTER_SNAPSHOT_CLEAR:
+		return AdiGpioRouterSnapshot(CyTrue, transferLength);
+	case ADI_GPIO_ROUTER_MONITOR:
+		status = AdiGpioRouterMonitor(value & 0xFF, (value & 0xFF00) >> 8);
+		break;
+	case ADI_GPIO_ROUTER_UNMONITOR:
+		status = AdiGpioRouterMonitor(value & 0xFF, 0xFF);
+		break;
+	default:
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(GpioRouter_c, __LINE__, status);
+	}
+	AdiSendStatus(status, 4, CyTrue);
+	return CY_U3P_SUCCESS;
+}
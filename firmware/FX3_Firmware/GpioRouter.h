@@ -0,0 +1,81 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		GpioRouter.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the GPIO interrupt router and per-pin edge counters
+ **/
+
+#ifndef GPIOROUTER_H_
+#define GPIOROUTER_H_
+
+/* Include main */
+#include "main.h"
+
+/** Number of GPIO routes (one per FX3 GPIO) */
+#define ADI_GPIO_ROUTER_NUM_PINS				(64)
+
+/** Router action (wIndex): read the edge counters. Returns status[0-3], time[4-11], entry count[12], then the entries */
+#define ADI_GPIO_ROUTER_SNAPSHOT				(0)
+
+/** Router action (wIndex): read the edge counters, then clear them. Same response as ADI_GPIO_ROUTER_SNAPSHOT */
+#define ADI_GPIO_ROUTER_SNAPSHOT_CLEAR			(1)
+
+/** Router action (wIndex): start counting edges on a pin. wValue is pin[7:0], edge[15:8] (0 falling, 1 rising, 2 both). Returns status[0-3] */
+#define ADI_GPIO_ROUTER_MONITOR					(2)
+
+/** Router action (wIndex): stop counting edges on a pin. wValue is the pin. Returns status[0-3] */
+#define ADI_GPIO_ROUTER_UNMONITOR				(3)
+
+/** Length of the snapshot response header */
+#define ADI_GPIO_ROUTER_HEADER_LEN				(13)
+
+/** Length of each snapshot entry. Formatted as pin[0], edge count[1-4], last edge time[5-12] */
+#define ADI_GPIO_ROUTER_ENTRY_LEN				(13)
+
+/** Edge callback. Runs in the GPIO ISR (or the stream thread, for data ready edges consumed by a stream), so keep it short */
+typedef void (*AdiGpioEdgeCallback)(uint8_t gpioId, uint64_t timestamp);
+
+/** Structure to track the edges seen on a single GPIO */
+typedef struct GpioRoute
+{
+	/** GpioHandler event flag to set on each edge (0 for none) */
+	uint32_t EventFlag;
+
+	/** Number of edges seen since the counters were last cleared */
+	volatile uint32_t EdgeCount;
+
+	/** Extended timer value (10MHz ticks) of the last edge */
+	volatile uint64_t LastEdgeTime;
+
+	/** Optional firmware callback, called on each edge */
+	AdiGpioEdgeCallback Callback;
+
+	/** Pin edge interrupt was configured by the host with ADI_GPIO_ROUTER_MONITOR */
+	CyBool_t Monitored;
+}GpioRoute;
+
+/* Public function prototypes */
+void AdiGpioRouterInit();
+void AdiGpioRouterDispatch(uint8_t gpioId);
+void AdiGpioRouterCountEdge(uint8_t gpioId);
+CyU3PReturnStatus_t AdiGpioRouterSetCallback(uint8_t gpioId, AdiGpioEdgeCallback callback);
+CyBool_t AdiGpioRouterActive();
+CyBool_t AdiGpioRouterStreamConflict(uint8_t bRequest);
+void AdiGpioRouterMask();
+void AdiGpioRouterUnmask();
+void AdiGpioRouterStreamMask(CyBool_t mask);
+CyBool_t AdiGpioRouterMasked();
+CyBool_t AdiGpioRouterStreamMasked();
+CyU3PReturnStatus_t AdiGpioRouterHandler(uint16_t action, uint16_t value, uint16_t transferLength);
+
+#endif /* GPIOROUTER_H_ */
@@ -24,7 +24,6 @@
 static void WatchDogTimerCb (uint32_t nParam);
 
 /* Tell compiler where to find needed globals */
-extern CyU3PDmaChannel ChannelToPC;
 extern CyU3PDmaBuffer_t ManualDMABuffer;
 extern BoardState FX3State;
 extern uint8_t USBBuffer[4096];
@@ -45,9 +44,18 @@ static CyU3PTimer WatchdogTimer = {0};
   * This function is used to allow early returns out of long functions in the
   * case where an invalid setting or operation is detected. Once this function
   * is called, and the result sent to the PC, the function can be safely exited.
+  * When a command is being serviced from the bulk command channel, the data
+  * (BulkBuffer[4] onwards) is sent as that command's response frame instead.
  **/
 void AdiReturnBulkEndpointData(CyU3PReturnStatus_t status, uint16_t length)
 {
+	/* Route to the bulk command response frame */
+	if(AdiBulkCmdActive())
+	{
+		AdiBulkCmdRespond(status, BulkBuffer + 4, (length > 4) ? (length - 4) : 0);
+		return;
+	}
+
 	/* Load status to BulkBuffer */
 	BulkBuffer[0] = status & 0xFF;
 	BulkBuffer[1] = (status & 0xFF00) >> 8;
@@ -59,8 +67,30 @@ void AdiReturnBulkEndpointData(CyU3PReturnStatus_t status, uint16_t length)
 	ManualDMABuffer.size = sizeof(BulkBuffer);
 	ManualDMABuffer.count = length;
 
-	/* Send the data to PC */
-	CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, &ManualDMABuffer);
+	/* Send the data to PC (waits behind any queued bulk command response) */
+	AdiBulkCmdSendData(&ManualDMABuffer);
+}
+
+/**
+  * @brief Gets the data phase of the command currently being handled.
+  *
+  * @param length The number of bytes to get
+  *
+  * @param outBuf The buffer to place the data in
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Reads the data from the control endpoint, or from the command payload when the command was
+  * received over the bulk command channel. This allows the same handler to service both.
+ **/
+CyU3PReturnStatus_t AdiGetRequestData(uint16_t length, uint8_t * outBuf)
+{
+	uint16_t bytesRead = 0;
+
+	if(AdiBulkCmdActive())
+		return AdiBulkCmdGetPayload(length, outBuf);
+
+	return CyU3PUsbGetEP0Data(length, outBuf, &bytesRead);
 }
 
 /**
@@ -107,6 +137,9 @@ CyU3PReturnStatus_t AdiSetDutSupply(DutVoltage SupplyMode)
 	CyU3PDebugPrint (4, "Setting power supply mode %d\r\n", SupplyMode);
 #endif
 
+	/* DUT power cycle invalidates the register cache */
+	AdiRegCacheInvalidate();
+
 	/* Check the DutVoltage value */
 	switch(SupplyMode)
 	{
@@ -186,10 +219,18 @@ void AdiGetBuildDate(uint8_t * outBuf)
   * @returns void
   *
   * This function will overwrite the data in USBBuffer[0-3]. If you need to send extra
-  * data along with the status, it must be placed starting at USBBuffer[4].
+  * data along with the status, it must be placed starting at USBBuffer[4]. Bulk endpoint
+  * status for a command from the bulk command channel is sent as its response frame.
  **/
 void AdiSendStatus(uint32_t status, uint16_t count, CyBool_t isControlEndpoint)
 {
+	/* Route to the bulk command response frame */
+	if(!isControlEndpoint && AdiBulkCmdActive())
+	{
+		AdiBulkCmdRespond(status, USBBuffer + 4, (count > 4) ? (count - 4) : 0);
+		return;
+	}
+
 	/* Clamp count */
 	if(count < 4)
 		count = 4;
@@ -210,7 +251,7 @@ void AdiSendStatus(uint32_t status, uint16_t count, CyBool_t isControlEndpoint)
 		ManualDMABuffer.buffer = USBBuffer;
 		ManualDMABuffer.size = 4096;
 		ManualDMABuffer.count = count;
-		CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, &ManualDMABuffer);
+		AdiBulkCmdSendData(&ManualDMABuffer);
 	}
 }
 
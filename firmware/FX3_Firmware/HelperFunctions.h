@@ -41,5 +41,6 @@ void AdiSendStatus(uint32_t status, uint16_t count, CyBool_t isControlEndpoint);
 CyU3PReturnStatus_t AdiSetDutSupply(DutVoltage SupplyMode);
 CyU3PReturnStatus_t AdiSleepForMicroSeconds(uint32_t numMicroSeconds);
 void AdiReturnBulkEndpointData(CyU3PReturnStatus_t status, uint16_t length);
+CyU3PReturnStatus_t AdiGetRequestData(uint16_t length, uint8_t * outBuf);
 
 #endif /* HELPERFUNCTIONS_H_ */
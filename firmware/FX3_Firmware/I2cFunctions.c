@@ -21,7 +21,6 @@
 extern uint8_t USBBuffer[4096];
 extern uint8_t BulkBuffer[12288];
 extern CyU3PDmaBuffer_t ManualDMABuffer;
-extern CyU3PDmaChannel ChannelToPC;
 extern BoardState FX3State;
 
 /**
@@ -54,12 +53,16 @@ CyU3PReturnStatus_t AdiI2CReadHandler(uint16_t RequestLength)
 	if(numBytes > 12288)
 		numBytes = 12288;
 
+	/* Hold off error log flash writes (re-configure the I2C block) */
+	AdiFlashLock();
+
 	/* Apply I2C timeout (arguments are in microseconds) */
 	timeout = timeout * 1000;
 	CyU3PI2cSetTimeout(timeout, timeout, timeout);
 
 	/* Perform transfer, starting at offset 4 in bulk buffer */
 	status = CyU3PI2cReceiveBytes(&preamble, BulkBuffer, numBytes, FX3State.I2CRetryCount);
+	AdiFlashUnlock();
 
 	/* Put status in first 4 bytes sent back */
 	BulkBuffer[0] = status & 0xFF;
@@ -71,7 +74,7 @@ CyU3PReturnStatus_t AdiI2CReadHandler(uint16_t RequestLength)
 	ManualDMABuffer.buffer = BulkBuffer;
 	ManualDMABuffer.size = 12288;
 	ManualDMABuffer.count = numBytes;
-	CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, &ManualDMABuffer);
+	AdiBulkCmdSendData(&ManualDMABuffer);
 
 	/* Return status code */
 	return status;
@@ -107,11 +110,15 @@ CyU3PReturnStatus_t AdiI2CWriteHandler(uint16_t RequestLength)
 	/* Get index within USB buffer where write data starts */
 	bufIndex = USBBuffer + index;
 
+	/* Hold off error log flash writes (re-configure the I2C block) */
+	AdiFlashLock();
+
 	/* Apply I2C timeout (arguments are in microseconds) */
 	timeout = timeout * 1000;
 	CyU3PI2cSetTimeout(timeout, timeout, timeout);
 
 	status = CyU3PI2cTransmitBytes(&preamble, bufIndex, numBytes, FX3State.I2CRetryCount);
+	AdiFlashUnlock();
 	if(status != CY_U3P_SUCCESS)
 		AdiLogError(I2cFunctions_c, __LINE__, status);
 
@@ -177,29 +184,51 @@ CyU3PReturnStatus_t AdiI2CInit(uint32_t BitRate, CyBool_t isDMA)
   * @return Index for the start of the I2C transmit data (if it exists)
  **/
 uint32_t I2CParseUSBBuffer(uint32_t * timeout, uint32_t * numBytes, CyU3PI2cPreamble_t * preamble)
+{
+	return I2CParseBuffer(USBBuffer, timeout, numBytes, preamble);
+}
+
+/**
+  * @brief Parses a single I2C transaction request (num bytes, timeout, preamble) from a buffer
+  *
+  * @param buf The buffer holding the request
+  *
+  * @param timeout Timeout value for I2C transaction. Return by reference.
+  *
+  * @param numBytes Number of bytes field in the request. Return by reference
+  *
+  * @param preamble I2C preamble struct stored in the request. Return by reference
+  *
+  * @return Index (relative to buf) for the start of the I2C transmit data (if it exists)
+  *
+  * The preamble length is clamped to the 8 byte preamble buffer.
+ **/
+uint32_t I2CParseBuffer(uint8_t * buf, uint32_t * timeout, uint32_t * numBytes, CyU3PI2cPreamble_t * preamble)
 {
 	uint32_t index = 0;
 
 	/* Parse num bytes */
-	*numBytes = USBBuffer[0];
-	*numBytes |= (USBBuffer[1] << 8);
-	*numBytes |= (USBBuffer[2] << 16);
-	*numBytes |= (USBBuffer[3] << 24);
+	*numBytes = buf[0];
+	*numBytes |= (buf[1] << 8);
+	*numBytes |= (buf[2] << 16);
+	*numBytes |= (buf[3] << 24);
 
 	/* Parse timeout */
-	*timeout = USBBuffer[4];
-	*timeout |= (USBBuffer[5] << 8);
-	*timeout |= (USBBuffer[6] << 16);
-	*timeout |= (USBBuffer[7] << 24);
+	*timeout = buf[4];
+	*timeout |= (buf[5] << 8);
+	*timeout |= (buf[6] << 16);
+	*timeout |= (buf[7] << 24);
 
 	/* Parse pre-amble */
-	preamble->length = USBBuffer[8];
-	preamble->ctrlMask = USBBuffer[9];
-	preamble->ctrlMask |= (USBBuffer[10] << 8);
+	preamble->length = buf[8];
+	if(preamble->length > sizeof(preamble->buffer))
+		preamble->length = sizeof(preamble->buffer);
+	preamble->ctrlMask = buf[9];
+	preamble->ctrlMask |= (buf[10] << 8);
 	for(int i = 0; i < preamble->length; i++)
 	{
 		index = 11 + i;
-		preamble->buffer[i] = USBBuffer[index];
+		preamble->buffer[i] = buf[index];
 	}
 	/* Increment index to point at first write data */
 	index++;
@@ -207,6 +236,287 @@ uint32_t I2CParseUSBBuffer(uint32_t * timeout, uint32_t * numBytes, CyU3PI2cPrea
 	return index;
 }
 
+/**
+  * @brief Handler for the I2C batch command. Runs a list of I2C transactions back to back.
+  *
+  * @param transferLength The number of bytes in the request data phase
+  *
+  * @param options Batch options (ADI_I2C_BATCH_STOP_ON_ERROR)
+  *
+  * @return A status code indicating if the request was accepted. I2C failures are only reported in the response
+  *
+  * Each operation in the request is a type byte (ADI_I2C_BATCH_READ or ADI_I2C_BATCH_WRITE) followed
+  * by a single transaction request, in the same format as the I2C read / write commands: num bytes[0-3],
+  * timeout[4-7], preamble, then the write data for writes. The whole list is validated before any bus
+  * traffic. The operations are run in register mode with FX3State.I2CRetryCount.
+  *
+  * The response (sent over the bulk endpoint) is status[0-3] (first failed operation, if any),
+  * operations run[4-5], the status of each operation (4 bytes each), then the read data of every
+  * read operation which was run, in order. Failed reads still take their full length in the read data.
+ **/
+CyU3PReturnStatus_t AdiI2CBatchHandler(uint16_t transferLength, uint16_t options)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t opStatus;
+	CyU3PI2cPreamble_t preamble = {.buffer = {0}};
+	uint32_t timeout, numBytes, index, opIndex, numOps, numRun, readBytes;
+	uint8_t * opPtr;
+	uint8_t * outPtr;
 
+	/* Validate that the op list fits in the USB buffer */
+	if(transferLength > sizeof(USBBuffer))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Read the op list into USBBuffer */
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Validate the op list, and count the ops and read bytes */
+	numOps = 0;
+	readBytes = 0;
+	index = 0;
+	while(index < transferLength)
+	{
+		if(((index + ADI_I2C_BATCH_OP_HEADER_LEN) > transferLength) || (numOps >= ADI_I2C_BATCH_MAX_OPS))
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			break;
+		}
+		opPtr = USBBuffer + index;
+		index += 1 + I2CParseBuffer(opPtr + 1, &timeout, &numBytes, &preamble);
+		if(index > transferLength)
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			break;
+		}
+		/* Bound each length before it is accumulated, so the totals can't wrap */
+		if((opPtr[0] == ADI_I2C_BATCH_WRITE) && (numBytes <= (transferLength - index)))
+		{
+			index += numBytes;
+		}
+		else if((opPtr[0] == ADI_I2C_BATCH_READ) && (numBytes <= sizeof(BulkBuffer)))
+		{
+			readBytes += numBytes;
+		}
+		else
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			break;
+		}
+		numOps++;
+	}
+	if((index > transferLength) || ((ADI_I2C_BATCH_RESP_HEADER_LEN + (numOps * 4) + readBytes) > sizeof(BulkBuffer)))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Read data is placed after the status of each op */
+	outPtr = BulkBuffer + ADI_I2C_BATCH_RESP_HEADER_LEN + (numOps * 4);
+
+	/* Hold off error log flash writes (re-configure the I2C block) */
+	AdiFlashLock();
+
+	index = 0;
+	numRun = 0;
+	for(opIndex = 0; opIndex < numOps; opIndex++)
+	{
+		opPtr = USBBuffer + index;
+		index += 1 + I2CParseBuffer(opPtr + 1, &timeout, &numBytes, &preamble);
+
+		/* Apply I2C timeout (arguments are in microseconds) */
+		timeout = timeout * 1000;
+		CyU3PI2cSetTimeout(timeout, timeout, timeout);
+
+		if(opPtr[0] == ADI_I2C_BATCH_WRITE)
+		{
+			opStatus = CyU3PI2cTransmitBytes(&preamble, USBBuffer + index, numBytes, FX3State.I2CRetryCount);
+			index += numBytes;
+		}
+		else
+		{
+			opStatus = CyU3PI2cReceiveBytes(&preamble, outPtr, numBytes, FX3State.I2CRetryCount);
+			outPtr += numBytes;
+		}
+
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4)] = opStatus & 0xFF;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 1] = (opStatus & 0xFF00) >> 8;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 2] = (opStatus & 0xFF0000) >> 16;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 3] = (opStatus & 0xFF000000) >> 24;
+		numRun++;
+
+		if(opStatus != CY_U3P_SUCCESS)
+		{
+			AdiLogError(I2cFunctions_c, __LINE__, opStatus);
+			if(status == CY_U3P_SUCCESS)
+				status = opStatus;
+			if(options & ADI_I2C_BATCH_STOP_ON_ERROR)
+				break;
+		}
+	}
 
+	AdiFlashUnlock();
 
+	/* Report the ops which were not run as not started */
+	for(opIndex = numRun; opIndex < numOps; opIndex++)
+	{
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4)] = CY_U3P_ERROR_NOT_STARTED & 0xFF;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 1] = (CY_U3P_ERROR_NOT_STARTED & 0xFF00) >> 8;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 2] = 0;
+		BulkBuffer[ADI_I2C_BATCH_RESP_HEADER_LEN + (opIndex * 4) + 3] = 0;
+	}
+
+	BulkBuffer[4] = numRun & 0xFF;
+	BulkBuffer[5] = (numRun & 0xFF00) >> 8;
+
+	/* Send status, op status and read data to the PC */
+	AdiReturnBulkEndpointData(status, outPtr - BulkBuffer);
+
+	/* I2C failures are reported in the response, not by stalling the request */
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Handler for the I2C bus scan command. Finds every device which ACKs its address.
+  *
+  * @param transferLength The number of bytes in the request data phase
+  *
+  * @param range The 7-bit address range to scan (wValue). First address[6:0], last address[14:8]
+  *
+  * @return A status code indicating if the request was accepted. ID read failures are only reported in the response
+  *
+  * Each address is probed with a single address-only write (no retries) at the configured I2C bit
+  * rate. A device which is not present NAKs the address byte, so a probe costs one address byte on
+  * the bus instead of a full I2C read round trip from the PC. Optionally, an ID register is read
+  * from each device found (1 or 2 byte register address, then a repeated start and up to
+  * ADI_I2C_SCAN_MAX_ID_LEN bytes read, using FX3State.I2CRetryCount).
+  *
+  * The response (sent over the bulk endpoint) is status[0-3] (first failed ID read, if any), address
+  * bitmap[4-19] (bit n of the bitmap is set if address n ACKed), device count[20], then an entry per
+  * device found, in address order. Each entry is address[0], ID read status[1-4], ID data.
+ **/
+CyU3PReturnStatus_t AdiI2CScanHandler(uint16_t transferLength, uint16_t range)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t idStatus;
+	CyU3PI2cPreamble_t probe = {.buffer = {0}};
+	CyU3PI2cPreamble_t idPreamble = {.buffer = {0}};
+	uint32_t timeout;
+	uint8_t firstAddr, lastAddr, idRegLen, idReadLen, numFound, addr;
+	uint8_t * outPtr;
+
+	firstAddr = range & 0x7F;
+	lastAddr = (range & 0x7F00) >> 8;
+
+	/* Validate the request */
+	if((transferLength != ADI_I2C_SCAN_REQUEST_LEN) || (firstAddr > lastAddr))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Parse the timeout and ID register read */
+	timeout = USBBuffer[0];
+	timeout |= (USBBuffer[1] << 8);
+	timeout |= (USBBuffer[2] << 16);
+	timeout |= (USBBuffer[3] << 24);
+	idRegLen = USBBuffer[4];
+	idReadLen = USBBuffer[7];
+	if((idRegLen > 2) || (idReadLen > ADI_I2C_SCAN_MAX_ID_LEN) || ((idRegLen != 0) && (idReadLen == 0)))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(I2cFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Hold off error log flash writes (re-configure the I2C block) */
+	AdiFlashLock();
+
+	/* Apply I2C timeout (arguments are in microseconds) */
+	timeout = timeout * 1000;
+	CyU3PI2cSetTimeout(timeout, timeout, timeout);
+
+	/* ID read preamble is address (write), register address, repeated start, address (read) */
+	idPreamble.length = idRegLen + 1;
+	if(idRegLen)
+	{
+		idPreamble.buffer[1] = USBBuffer[5];
+		idPreamble.buffer[2] = USBBuffer[6];
+		idPreamble.length++;
+		idPreamble.ctrlMask = (1 << idRegLen);
+	}
+
+	CyU3PMemSet(BulkBuffer + 4, 0, ADI_I2C_SCAN_BITMAP_LEN);
+	outPtr = BulkBuffer + ADI_I2C_SCAN_RESP_HEADER_LEN;
+	numFound = 0;
+	probe.length = 1;
+	probe.ctrlMask = 0;
+
+	for(addr = firstAddr; addr <= lastAddr; addr++)
+	{
+		/* Address-only probe. A NAK means no device */
+		probe.buffer[0] = addr << 1;
+		if(CyU3PI2cWaitForAck(&probe, 0) != CY_U3P_SUCCESS)
+			continue;
+
+		BulkBuffer[4 + (addr >> 3)] |= (1 << (addr & 0x7));
+		numFound++;
+
+		idStatus = CY_U3P_SUCCESS;
+		if(idReadLen)
+		{
+			idPreamble.buffer[0] = addr << 1;
+			idPreamble.buffer[idPreamble.length - 1] = (addr << 1) | 0x1;
+			idStatus = CyU3PI2cReceiveBytes(&idPreamble, outPtr + 5, idReadLen, FX3State.I2CRetryCount);
+			if(idStatus != CY_U3P_SUCCESS)
+			{
+				AdiLogError(I2cFunctions_c, __LINE__, idStatus);
+				if(status == CY_U3P_SUCCESS)
+					status = idStatus;
+			}
+		}
+
+		outPtr[0] = addr;
+		outPtr[1] = idStatus & 0xFF;
+		outPtr[2] = (idStatus & 0xFF00) >> 8;
+		outPtr[3] = (idStatus & 0xFF0000) >> 16;
+		outPtr[4] = (idStatus & 0xFF000000) >> 24;
+		outPtr += 5 + idReadLen;
+	}
+
+	AdiFlashUnlock();
+
+	BulkBuffer[20] = numFound;
+
+	/* Send status, bitmap and device entries to the PC */
+	AdiReturnBulkEndpointData(status, outPtr - BulkBuffer);
+
+	/* ID read failures are reported in the response, not by stalling the request */
+	return CY_U3P_SUCCESS;
+}
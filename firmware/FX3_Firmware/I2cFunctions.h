@@ -20,10 +20,43 @@
 
 #include "main.h"
 
+/** Max number of operations in an I2C batch */
+#define ADI_I2C_BATCH_MAX_OPS					(64)
+
+/** I2C batch operation type: read */
+#define ADI_I2C_BATCH_READ						(0)
+
+/** I2C batch operation type: write */
+#define ADI_I2C_BATCH_WRITE						(1)
+
+/** I2C batch option (wValue): stop at the first failed operation */
+#define ADI_I2C_BATCH_STOP_ON_ERROR				(1 << 0)
+
+/** Min length of an I2C batch operation (type, num bytes, timeout, preamble length and control) */
+#define ADI_I2C_BATCH_OP_HEADER_LEN				(12)
+
+/** Length of the I2C batch response header (status, operations run). Followed by the status of each operation */
+#define ADI_I2C_BATCH_RESP_HEADER_LEN			(6)
+
+/** Length of the I2C bus scan request. Formatted as timeout[0-3], ID register address length[4], ID register address[5-6], ID read length[7] */
+#define ADI_I2C_SCAN_REQUEST_LEN				(8)
+
+/** Max number of ID register bytes read from each device found by an I2C bus scan */
+#define ADI_I2C_SCAN_MAX_ID_LEN					(16)
+
+/** Length of the I2C bus scan response header. Formatted as status[0-3], address bitmap[4-19], device count[20] */
+#define ADI_I2C_SCAN_RESP_HEADER_LEN			(21)
+
+/** Length of the I2C bus scan address bitmap (one bit per 7-bit address) */
+#define ADI_I2C_SCAN_BITMAP_LEN					(16)
+
 /* Public functions */
 CyU3PReturnStatus_t AdiI2CReadHandler(uint16_t RequestLength);
 CyU3PReturnStatus_t AdiI2CWriteHandler(uint16_t RequestLength);
 CyU3PReturnStatus_t AdiI2CInit(uint32_t BitRate, CyBool_t isDMA);
 uint32_t I2CParseUSBBuffer(uint32_t * timeout, uint32_t * numBytes, CyU3PI2cPreamble_t * preamble);
+uint32_t I2CParseBuffer(uint8_t * buf, uint32_t * timeout, uint32_t * numBytes, CyU3PI2cPreamble_t * preamble);
+CyU3PReturnStatus_t AdiI2CBatchHandler(uint16_t transferLength, uint16_t options);
+CyU3PReturnStatus_t AdiI2CScanHandler(uint16_t transferLength, uint16_t range);
 
 #endif /* I2CFUNCTIONS_H_ */
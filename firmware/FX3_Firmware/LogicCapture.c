@@ -0,0 +1,237 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		LogicCapture.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Logic analyzer capture of the mapped iSensor DIO and FX3 GPIO pins.
+  *
+  * The pins in the board pin map (DIO1 - DIO4, GPIO1 - GPIO4, RESET) are sampled together at a
+  * fixed rate, paced by the extended 10MHz timer. Each sample is packed into a bitfield, and
+  * consecutive identical samples are run length encoded, so idle lines cost almost no bandwidth.
+  * The records are sent to the PC over the streaming endpoint by the pin capture stream. The
+  * tools/logic2vcd decoder converts a saved capture to a VCD file.
+ **/
+
+#include "LogicCapture.h"
+
+/* Tell the compiler where to find the needed globals */
+extern BoardState FX3State;
+extern volatile CyBool_t KillStreamEarly;
+
+/**
+  * @brief Samples all the logic capture channels at once.
+  *
+  * @param state The logic capture state, with the channel register map
+  *
+  * @return The channel values, packed with channel 0 in bit 0
+ **/
+static uint32_t AdiLogicSample(LogicCaptureState * state)
+{
+	uint32_t inValue[2];
+	uint32_t value = 0;
+	int i;
+
+	/* Both input value registers hold a snapshot of every GPIO */
+	CyU3PGpioGetIOValues(&inValue[0], &inValue[1]);
+	for(i = 0; i < ADI_LOGIC_NUM_CHANNELS; i++)
+	{
+		if(inValue[state->ChannelReg[i]] & state->ChannelMask[i])
+		{
+			value |= (1 << i);
+		}
+	}
+	return value;
+}
+
+/**
+  * @brief Writes the current run to a record, and starts a new (empty) run with the same value.
+  *
+  * @param state The logic capture state
+  *
+  * @param outBuf Buffer to write the record to
+  *
+  * @return void
+ **/
+static void AdiLogicEmitRun(LogicCaptureState * state, uint8_t * outBuf)
+{
+	uint32_t record;
+
+	record = state->RunLength | (state->RunValue << ADI_LOGIC_VALUE_POS);
+	outBuf[0] = record & 0xFF;
+	outBuf[1] = (record & 0xFF00) >> 8;
+	outBuf[2] = (record & 0xFF0000) >> 16;
+	outBuf[3] = (record & 0xFF000000) >> 24;
+
+	state->RunStart += state->RunLength;
+	state->RunLength = 0;
+}
+
+/**
+  * @brief Sets up a logic capture.
+  *
+  * @param state The logic capture state to initialize
+  *
+  * @param samplePeriod The sample period, in 10MHz timer ticks
+  *
+  * @param flushMs The max time to hold a partially filled packet, in ms (0 = only send full packets)
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Builds the register map for each channel from the board pin map. The input stage is enabled on
+  * any of the pins configured as a simple GPIO output, so driven pins are sampled at their actual level.
+ **/
+CyU3PReturnStatus_t AdiLogicCaptureInit(LogicCaptureState * state, uint32_t samplePeriod, uint32_t flushMs)
+{
+	uint16_t pins[ADI_LOGIC_NUM_CHANNELS];
+	uint32_t pinConfig;
+	int i;
+
+	if(samplePeriod < ADI_LOGIC_MIN_SAMPLE_TICKS)
+	{
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	pins[0] = FX3State.PinMap.ADI_PIN_DIO1;
+	pins[1] = FX3State.PinMap.ADI_PIN_DIO2;
+	pins[2] = FX3State.PinMap.ADI_PIN_DIO3;
+	pins[3] = FX3State.PinMap.ADI_PIN_DIO4;
+	pins[4] = FX3State.PinMap.FX3_PIN_GPIO1;
+	pins[5] = FX3State.PinMap.FX3_PIN_GPIO2;
+	pins[6] = FX3State.PinMap.FX3_PIN_GPIO3;
+	pins[7] = FX3State.PinMap.FX3_PIN_GPIO4;
+	pins[8] = FX3State.PinMap.ADI_PIN_RESET;
+
+	for(i = 0; i < ADI_LOGIC_NUM_CHANNELS; i++)
+	{
+		state->ChannelReg[i] = pins[i] >> 5;
+		state->ChannelMask[i] = 1 << (pins[i] & 0x1F);
+
+		/* Don't write back a pending interrupt, it would be cleared */
+		pinConfig = GPIO->lpp_gpio_simple[pins[i]];
+		if(pinConfig & CY_U3P_LPP_GPIO_ENABLE)
+		{
+			GPIO->lpp_gpio_simple[pins[i]] = (pinConfig & ~CY_U3P_LPP_GPIO_INTR) | CY_U3P_LPP_GPIO_INPUT_EN;
+		}
+	}
+
+	state->SamplePeriod = samplePeriod;
+	state->FlushTicks = (uint64_t) flushMs * MS_TO_TICKS_MULT;
+	state->NextSampleTime = AdiGetTicks64();
+	state->RunStart = 0;
+	state->RunValue = 0;
+	state->RunLength = 0;
+	state->MissedSamples = 0;
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "Logic capture started, sample period %d ticks\r\n", samplePeriod);
+#endif
+
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Fills a single USB packet with logic capture records.
+  *
+  * @param state The logic capture state. Carries the open run and sample time across packets.
+  *
+  * @param outBuf Buffer to place the packet in
+  *
+  * @param packetLen The packet size, in bytes
+  *
+  * @return The number of run length records placed in the packet
+  *
+  * Returns when the packet is full, when the flush time passes, or when the stream is stopped. On a
+  * flush, the open run is closed so the PC sees the latest pin state; it continues in the next packet.
+  *
+  * If the capture falls behind, the sample slots which passed are given the value of the next sample,
+  * and counted in the missed samples field. The time base stays exact, but edges in those slots are
+  * only resolved to the late sample.
+ **/
+uint32_t AdiLogicCaptureFill(LogicCaptureState * state, uint8_t * outBuf, uint32_t packetLen)
+{
+	uint8_t * records = outBuf + ADI_LOGIC_HEADER_LEN;
+	uint32_t maxRecords, numRecords, value, missed;
+	uint64_t now, packetStart, firstSample, behind;
+
+	maxRecords = (packetLen - ADI_LOGIC_HEADER_LEN) / ADI_LOGIC_RECORD_LEN;
+	numRecords = 0;
+	firstSample = state->RunStart;
+	packetStart = AdiGetTicks64();
+
+	while(numRecords < maxRecords)
+	{
+		now = AdiGetTicks64();
+
+		/* Send a partial packet once the flush time passes, or the stream is stopped */
+		if(KillStreamEarly || (state->FlushTicks && ((now - packetStart) >= state->FlushTicks)))
+		{
+			if(state->RunLength)
+			{
+				AdiLogicEmitRun(state, records + (numRecords * ADI_LOGIC_RECORD_LEN));
+				numRecords++;
+			}
+			break;
+		}
+
+		if(now < state->NextSampleTime)
+			continue;
+
+		/* Count any whole sample slots which passed since the sample was due */
+		missed = 0;
+		behind = now - state->NextSampleTime;
+		if(behind >= state->SamplePeriod)
+		{
+			behind = behind / state->SamplePeriod;
+			if(behind > (ADI_LOGIC_MAX_RUN - 1))
+				behind = ADI_LOGIC_MAX_RUN - 1;
+			missed = (uint32_t) behind;
+			state->MissedSamples += missed;
+		}
+		state->NextSampleTime += (uint64_t) (missed + 1) * state->SamplePeriod;
+
+		value = AdiLogicSample(state);
+		if((value != state->RunValue) || ((state->RunLength + missed + 1) > ADI_LOGIC_MAX_RUN))
+		{
+			if(state->RunLength)
+			{
+				AdiLogicEmitRun(state, records + (numRecords * ADI_LOGIC_RECORD_LEN));
+				numRecords++;
+			}
+			state->RunValue = value;
+		}
+		state->RunLength += missed + 1;
+	}
+
+	/* Zero fill unused records, so the PC never sees stale data */
+	CyU3PMemSet(records + (numRecords * ADI_LOGIC_RECORD_LEN), 0, (maxRecords - numRecords) * ADI_LOGIC_RECORD_LEN);
+
+	/* Packet header */
+	outBuf[0] = ADI_LOGIC_MAGIC & 0xFF;
+	outBuf[1] = (ADI_LOGIC_MAGIC & 0xFF00) >> 8;
+	outBuf[2] = packetLen & 0xFF;
+	outBuf[3] = (packetLen & 0xFF00) >> 8;
+	outBuf[4] = numRecords & 0xFF;
+	outBuf[5] = (numRecords & 0xFF00) >> 8;
+	outBuf[6] = ADI_LOGIC_NUM_CHANNELS;
+	outBuf[7] = 0;
+	outBuf[8] = state->SamplePeriod & 0xFF;
+	outBuf[9] = (state->SamplePeriod & 0xFF00) >> 8;
+	outBuf[10] = (state->SamplePeriod & 0xFF0000) >> 16;
+	outBuf[11] = (state->SamplePeriod & 0xFF000000) >> 24;
+	outBuf[12] = state->MissedSamples & 0xFF;
+	outBuf[13] = (state->MissedSamples & 0xFF00) >> 8;
+	outBuf[14] = (state->MissedSamples & 0xFF0000) >> 16;
+	outBuf[15] = (state->MissedSamples & 0xFF000000) >> 24;
+	AdiTicks64ToBuffer(firstSample, outBuf + 16);
+
+	return numRecords;
+}
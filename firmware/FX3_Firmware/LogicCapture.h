@@ -0,0 +1,91 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		LogicCapture.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the logic analyzer capture of the mapped iSensor DIO and FX3 GPIO pins
+ **/
+
+#ifndef LOGICCAPTURE_H_
+#define LOGICCAPTURE_H_
+
+/* Include main */
+#include "main.h"
+
+/** Number of pins sampled by the logic analyzer */
+#define ADI_LOGIC_NUM_CHANNELS					(9)
+
+/** Structure to track a logic analyzer capture */
+typedef struct LogicCaptureState
+{
+	/** Input value register (0 or 1) holding each channel */
+	uint8_t ChannelReg[ADI_LOGIC_NUM_CHANNELS];
+
+	/** Bit mask of each channel within its input value register */
+	uint32_t ChannelMask[ADI_LOGIC_NUM_CHANNELS];
+
+	/** Sample period, in 10MHz timer ticks */
+	uint32_t SamplePeriod;
+
+	/** Max time to hold a partially filled packet, in 10MHz timer ticks (0 = only send full packets) */
+	uint64_t FlushTicks;
+
+	/** Extended timer value for the next sample */
+	uint64_t NextSampleTime;
+
+	/** Sample index of the first sample in the current run */
+	uint64_t RunStart;
+
+	/** Channel values for the current run */
+	uint32_t RunValue;
+
+	/** Number of samples in the current run */
+	uint32_t RunLength;
+
+	/** Total number of sample slots which were held from the previous sample because the capture fell behind */
+	uint32_t MissedSamples;
+}LogicCaptureState;
+
+/* Public function prototypes */
+CyU3PReturnStatus_t AdiLogicCaptureInit(LogicCaptureState * state, uint32_t samplePeriod, uint32_t flushMs);
+uint32_t AdiLogicCaptureFill(LogicCaptureState * state, uint8_t * outBuf, uint32_t packetLen);
+
+/*
+ * Logic capture packet format. All multi-byte fields are little endian. Each USB packet is:
+ * magic[0-1], packet length[2-3], record count[4-5], channel count[6-7], sample period in
+ * 10MHz ticks[8-11], missed samples[12-15], sample index of the first record[16-23], then
+ * record count run length records. Unused record slots are zero filled.
+ *
+ * Each record is a 32-bit word. Bits 0-22 are the number of consecutive samples (run length),
+ * and bits 23-31 are the channel values for the run (bit 23 = channel 0). Channel order is
+ * DIO1, DIO2, DIO3, DIO4, GPIO1, GPIO2, GPIO3, GPIO4, RESET.
+ */
+
+/** Logic capture packet header magic ("LA") */
+#define ADI_LOGIC_MAGIC							(0x414C)
+
+/** Number of header bytes at the start of each logic capture packet */
+#define ADI_LOGIC_HEADER_LEN					(24)
+
+/** Size of a single run length record */
+#define ADI_LOGIC_RECORD_LEN					(4)
+
+/** Max run length a single record can hold */
+#define ADI_LOGIC_MAX_RUN						(0x7FFFFF)
+
+/** Bit position of the channel values in a run length record */
+#define ADI_LOGIC_VALUE_POS						(23)
+
+/** Min sample period, in 10MHz timer ticks (approx. 1MHz sample rate) */
+#define ADI_LOGIC_MIN_SAMPLE_TICKS				(10)
+
+#endif /* LOGICCAPTURE_H_ */
@@ -20,10 +20,28 @@
 
 /* Tell the compiler where to find the needed globals */
 extern BoardState FX3State;
-extern CyU3PEvent GpioHandler;
+extern volatile CyBool_t KillStreamEarly;
 extern uint8_t USBBuffer[4096];
 extern uint8_t BulkBuffer[12288];
 
+/* Private function prototypes */
+static inline uint32_t AdiSampleTimerPin();
+
+/** 10MHz timer rollovers since the timer was last released (extended timer high word) */
+static volatile uint32_t TimerRollovers = 0;
+
+/** Extended timer value when the timer was last released */
+static uint64_t TimerBase = 0;
+
+/** Track if the timer hardware has been taken over for stall or SCLK timing */
+static volatile CyBool_t TimerAcquired = CyFalse;
+
+/** Extended timer value when the timer hardware was acquired */
+static uint64_t TimerAcquireTicks = 0;
+
+/** RTOS time (ms) when the timer hardware was acquired */
+static uint32_t TimerAcquireOsTime = 0;
+
 /**
   * @brief Gets the programmed board type and pin mapping info
   *
@@ -271,14 +289,9 @@ CyBool_t AdiIsValidGPIO(uint16_t GpioId)
 CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	uint16_t *bytesRead = 0;
-	uint16_t busyPin, triggerPin;
-	CyBool_t busyInitialValue, busyCurrentValue, triggerDrivePolarity, exitCondition;
-	uint32_t currentTime, lastTime, timeout, rollOverCount;
-	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 
 	/* Read config data into USBBuffer */
-	status = CyU3PUsbGetEP0Data(transferLength, USBBuffer, bytesRead);
+	status = AdiGetRequestData(transferLength, USBBuffer);
 	if(status != CY_U3P_SUCCESS)
 	{
 		AdiLogError(PinFunctions_c, __LINE__, status);
@@ -286,27 +299,51 @@ CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength)
 		return CY_U3P_ERROR_INVALID_SEQUENCE;
 	}
 
+	/* Run the measurement, with the results placed in the bulk buffer */
+	status = AdiMeasurePinDelayRun(USBBuffer, BulkBuffer + 4);
+
+	/* Return pin delay data over ChannelToPC */
+	AdiReturnBulkEndpointData(status, 12);
+
+	return status;
+}
+
+/**
+  * @brief Runs a pin delay measurement (trigger pin edge to busy pin edge).
+  *
+  * @param params The measurement parameters: trigger pin[0-1], trigger drive polarity[2], busy pin[3-4], timeout in ms[5-8]
+  *
+  * @param results Buffer for the measured delay (8 bytes, timer ticks[0-3], timer rollovers[4-7])
+  *
+  * @return A status code indicating the success of the pin delay measure operation
+ **/
+CyU3PReturnStatus_t AdiMeasurePinDelayRun(uint8_t * params, uint8_t * results)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t busyPin, triggerPin;
+	CyBool_t busyInitialValue, busyCurrentValue, triggerDrivePolarity, exitCondition;
+	uint32_t timeoutMs;
+	uint64_t startTime, elapsedTime, timeout;
+	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+
 	/* Parse config */
-	triggerPin = USBBuffer[0];
-	triggerPin = triggerPin + (USBBuffer[1] << 8);
-	triggerDrivePolarity = (CyBool_t) USBBuffer[2];
-	busyPin = USBBuffer[3];
-	busyPin = busyPin + (USBBuffer[4] << 8);
-	timeout = USBBuffer[5];
-	timeout = timeout + (USBBuffer[6] << 8);
-	timeout = timeout + (USBBuffer[7] << 16);
-	timeout = timeout + (USBBuffer[8] << 24);
+	triggerPin = params[0];
+	triggerPin = triggerPin + (params[1] << 8);
+	triggerDrivePolarity = (CyBool_t) params[2];
+	busyPin = params[3];
+	busyPin = busyPin + (params[4] << 8);
+	timeoutMs = params[5];
+	timeoutMs = timeoutMs + (params[6] << 8);
+	timeoutMs = timeoutMs + (params[7] << 16);
+	timeoutMs = timeoutMs + (params[8] << 24);
 
 	/* Convert ms to timer ticks */
-	timeout = timeout * MS_TO_TICKS_MULT;
+	timeout = (uint64_t) timeoutMs * MS_TO_TICKS_MULT;
 
 	/* Verify pins */
 	if(!AdiIsValidGPIO(busyPin) || !AdiIsValidGPIO(triggerPin))
 	{
-		status = CY_U3P_ERROR_BAD_ARGUMENT;
-		/* Send status to the PC (alerting them of invalid GPIO selection) */
-		AdiReturnBulkEndpointData(status, 12);
-		return status;
+		return CY_U3P_ERROR_BAD_ARGUMENT;
 	}
 
 	/* Check that busy pin specified is configured as input */
@@ -327,8 +364,6 @@ CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength)
 		/* If pin setup not successful skip wait operation and return -1 */
 		if(status != CY_U3P_SUCCESS)
 		{
-			/* Send status to PC */
-			AdiReturnBulkEndpointData(status, 12);
 			return status;
 		}
 	}
@@ -341,45 +376,25 @@ CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength)
 	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
 	status = CyU3PGpioSetSimpleConfig(triggerPin, &gpioConfig);
 
-	/* Reset the pin timer register to 0 */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
-	/* Disable interrupts on the timer pin */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
-	/* Set the pin timer period to 0xFFFFFFFF; */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-
-	lastTime = 0;
-	currentTime = 0;
-	rollOverCount = 0;
+	/* Get the start time */
+	startTime = AdiGetTicks64();
+	elapsedTime = 0;
 	exitCondition = CyFalse;
 
 	/* Begin wait operation (for edge transition on busy pin)*/
 	while(!exitCondition)
 	{
-		/* Store previous time */
-		lastTime = currentTime;
-
-		/* Set the pin config for sample now mode */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-		/* wait for sample to finish */
-		while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-		/* read timer value */
-		currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
+		/* Get the elapsed time */
+		elapsedTime = AdiGetTicks64() - startTime;
 
 		/* Read the pin value */
 		busyCurrentValue = ((GPIO->lpp_gpio_simple[busyPin] & CY_U3P_LPP_GPIO_IN_VALUE) >> 1);
 
-		/* Check if rollover occurred */
-		if(currentTime < lastTime)
-		{
-			rollOverCount++;
-		}
-
 		/* update the exit condition */
 		exitCondition = (busyCurrentValue != busyInitialValue);
 		if(timeout)
 		{
-			exitCondition |= (currentTime >= timeout);
+			exitCondition |= (elapsedTime >= timeout);
 		}
 	}
 
@@ -390,28 +405,10 @@ CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength)
 		CyU3PGpioSetValue(triggerPin, CyTrue);
 
 	/*Add 0.5us (calibrated using DSLogic Pro)*/
-	if(currentTime < (0xFFFFFFFF - 5))
-	{
-		currentTime = currentTime + 5;
-	}
-	else
-	{
-		currentTime = 0;
-		rollOverCount++;
-	}
+	elapsedTime += 5;
 
-	/* Populate bulk buffer with result */
-	BulkBuffer[4] = currentTime & 0xFF;
-	BulkBuffer[5] = (currentTime & 0xFF00) >> 8;
-	BulkBuffer[6] = (currentTime & 0xFF0000) >> 16;
-	BulkBuffer[7] = (currentTime & 0xFF000000) >> 24;
-	BulkBuffer[8] = rollOverCount & 0xFF;
-	BulkBuffer[9] = (rollOverCount & 0xFF00) >> 8;
-	BulkBuffer[10] = (rollOverCount & 0xFF0000) >> 16;
-	BulkBuffer[11] = (rollOverCount & 0xFF000000) >> 24;
-
-	/* Return pulse wait data over ChannelToPC */
-	AdiReturnBulkEndpointData(status, 12);
+	/* Populate results (timer ticks, timer rollovers) */
+	AdiTicks64ToBuffer(elapsedTime, results);
 
 	return status;
 }
@@ -435,55 +432,77 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	uint16_t *bytesRead = 0;
+
+	/* Read config data into USBBuffer */
+	status = CyU3PUsbGetEP0Data(transferLength, USBBuffer, bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	/* Run the measurement, with the result placed in the bulk buffer */
+	status = AdiMeasureBusyPulseRun(USBBuffer, BulkBuffer + 4);
+
+	/* Send the data to PC */
+	AdiReturnBulkEndpointData(status, 8);
+
+	return status;
+}
+
+/**
+  * @brief Runs a busy pulse measurement: triggers the DUT, then measures the following pulse on the busy pin.
+  *
+  * @param params The measurement parameters: busy pin[0-1], busy polarity[2], timeout in ms[3-6], SPI trigger mode[7],
+  * then either SPI word count[8-9] and SPI words[10-...], or trigger pin[8-9], trigger polarity[10], drive time in ms[11-14]
+  *
+  * @param results Buffer for the measured pulse width (4 bytes, 10MHz timer ticks)
+  *
+  * @return A status code indicating the success of the measure pulse operation
+ **/
+CyU3PReturnStatus_t AdiMeasureBusyPulseRun(uint8_t * params, uint8_t * results)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	uint8_t * spiBuf;
 	uint16_t busyPin, triggerPin, SpiTriggerWordCount;
 	CyBool_t exitCondition, SpiTriggerMode, busyPolarity, triggerPolarity;
-	uint32_t currentTime, timeout, driveTime, result;
+	uint32_t timeoutMs, driveTimeMs, result;
+	uint64_t startTime, elapsedTime, timeout, driveTime;
 	CyU3PGpioSimpleConfig_t gpioConfig;
 	CyU3PGpioComplexConfig_t busyPinConfig;
 
 	/* Ensure variables are initialized to stop compiler from complainging */
 	driveTime = 0;
+	driveTimeMs = 0;
 	triggerPolarity = CyTrue;
 
-	/* Read config data into USBBuffer */
-	status = CyU3PUsbGetEP0Data(transferLength, USBBuffer, bytesRead);
-	if(status != CY_U3P_SUCCESS)
-	{
-		AdiLogError(PinFunctions_c, __LINE__, status);
-		return status;
-	}
-
-	/* Parse general request data from USBBuffer */
-	busyPin = USBBuffer[0];
-	busyPin |= (USBBuffer[1] << 8);
-	busyPolarity = (CyBool_t) USBBuffer[2];
-	timeout = USBBuffer[3];
-	timeout |= (USBBuffer[4] << 8);
-	timeout |= (USBBuffer[5] << 16);
-	timeout |= (USBBuffer[6] << 24);
+	/* Parse general request data */
+	busyPin = params[0];
+	busyPin |= (params[1] << 8);
+	busyPolarity = (CyBool_t) params[2];
+	timeoutMs = params[3];
+	timeoutMs |= (params[4] << 8);
+	timeoutMs |= (params[5] << 16);
+	timeoutMs |= (params[6] << 24);
 
 	/* Check that busy pin is valid GPIO */
 	if(!AdiIsValidGPIO(busyPin))
 	{
-		status = CY_U3P_ERROR_BAD_ARGUMENT;
-		/* Send status to the PC (alerting them of invalid GPIO selection) */
-		AdiReturnBulkEndpointData(status, 8);
-		return status;
+		return CY_U3P_ERROR_BAD_ARGUMENT;
 	}
 
 	/* Get the trigger mode */
-	SpiTriggerMode = USBBuffer[7];
+	SpiTriggerMode = params[7];
 
 	/* Convert timeout (in ms) to timer ticks */
-	if((timeout == 0) || (timeout > 426000))
+	if((timeoutMs == 0) || (timeoutMs > 426000))
 	{
-		/* Set max timeout */
+		/* Set max timeout (pulse measurement hardware is 32-bit) */
 		timeout = 0xFFFFFFFF;
 	}
 	else
 	{
-		timeout = timeout * MS_TO_TICKS_MULT;
+		timeout = (uint64_t) timeoutMs * MS_TO_TICKS_MULT;
 	}
 
 	/* Set default for trigger pin to invalid value */
@@ -508,7 +527,7 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
     if (status != CY_U3P_SUCCESS)
     {
     	AdiLogError(PinFunctions_c, __LINE__, status);
-    	AdiReturnBulkEndpointData(status, 8);
+    	return status;
     }
 
     /* Start measure operation */
@@ -521,18 +540,21 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
     if (status != CY_U3P_SUCCESS)
     {
     	AdiLogError(PinFunctions_c, __LINE__, status);
-    	AdiReturnBulkEndpointData(status, 8);
+    	return status;
     }
 
 	/* parse the trigger specific data and trigger */
 	if(SpiTriggerMode)
 	{
+		/* SPI trigger bypasses the register cache */
+		AdiRegCacheInvalidate();
+
 		/* Get the SPI trigger word count */
-		SpiTriggerWordCount = USBBuffer[8];
-		SpiTriggerWordCount |= (USBBuffer[9] << 8);
+		SpiTriggerWordCount = params[8];
+		SpiTriggerWordCount |= (params[9] << 8);
 
 		/* Set the SPI buffer */
-		spiBuf = USBBuffer + 10;
+		spiBuf = params + 10;
 
 		/* Transmit the SPI words */
 		CyU3PSpiTransmitWords(spiBuf, SpiTriggerWordCount);
@@ -540,20 +562,26 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
 	else
 	{
 		/* parse parameters from USB Buffer */
-		triggerPin = USBBuffer[8];
-		triggerPin = triggerPin + (USBBuffer[9] << 8);
+		triggerPin = params[8];
+		triggerPin = triggerPin + (params[9] << 8);
 
 		/* Get drive polarity */
-		triggerPolarity = USBBuffer[10];
+		triggerPolarity = params[10];
 
 		/* Get drive time (in ms) */
-		driveTime = USBBuffer[11];
-		driveTime = driveTime + (USBBuffer[12] << 8);
-		driveTime = driveTime + (USBBuffer[13] << 16);
-		driveTime = driveTime + (USBBuffer[14] << 24);
+		driveTimeMs = params[11];
+		driveTimeMs = driveTimeMs + (params[12] << 8);
+		driveTimeMs = driveTimeMs + (params[13] << 16);
+		driveTimeMs = driveTimeMs + (params[14] << 24);
 
 		/* convert drive time (ms) to ticks */
-		driveTime = driveTime * MS_TO_TICKS_MULT;
+		driveTime = (uint64_t) driveTimeMs * MS_TO_TICKS_MULT;
+
+		/* Driving the DUT reset pin invalidates the register cache */
+		if(triggerPin == FX3State.PinMap.ADI_PIN_RESET)
+		{
+			AdiRegCacheInvalidate();
+		}
 
 		/* want to configure the trigger pin to act as an output */
 		status = CyU3PDeviceGpioOverride(triggerPin, CyTrue);
@@ -582,37 +610,26 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
 		}
 	}
 
-	/* Reset the timeout timer register to 0 */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
-	/* Disable interrupts on the timer pin */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
-	/* Set the pin timer period to 0xFFFFFFFF */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-
-	/* Reset state variables */
-	currentTime = 0;
+	/* Get the start time */
+	startTime = AdiGetTicks64();
 	exitCondition = CyFalse;
 
 	/* Wait for the GPIO pin the reach the desired level or timeout */
 	while(!exitCondition)
 	{
-		/* Set the pin config for sample now mode */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-		/* wait for sample to finish */
-		while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-		/* read timer value */
-		currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
+		/* Get the elapsed time */
+		elapsedTime = AdiGetTicks64() - startTime;
 
 		/* Get result from pulse measure hardware */
 		status = CyU3PGpioComplexWaitForCompletion(busyPin, &result, CyFalse);
 
 		/* update the exit condition */
-		exitCondition = ((currentTime >= timeout) || (status == CY_U3P_SUCCESS));
+		exitCondition = ((elapsedTime >= timeout) || (status == CY_U3P_SUCCESS));
 
 		/* Check if the pin drive can stop */
 		if(!SpiTriggerMode)
 		{
-			if(currentTime > driveTime)
+			if(elapsedTime > driveTime)
 			{
 				/* drive the opposite polarity */
 				CyU3PGpioSimpleSetValue(triggerPin, ~triggerPolarity);
@@ -643,14 +660,11 @@ CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength)
 		CyU3PGpioSetSimpleConfig(triggerPin, &gpioConfig);
 	}
 
-	/* Populate buffer with result data */
-	BulkBuffer[4] = result & 0xFF;
-	BulkBuffer[5] = (result & 0xFF00) >> 8;
-	BulkBuffer[6] = (result & 0xFF0000) >> 16;
-	BulkBuffer[7] = (result & 0xFF000000) >> 24;
-
-	/* Send the data to PC */
-	AdiReturnBulkEndpointData(status, 8);
+	/* Populate results */
+	results[0] = result & 0xFF;
+	results[1] = (result & 0xFF00) >> 8;
+	results[2] = (result & 0xFF0000) >> 16;
+	results[3] = (result & 0xFF000000) >> 24;
 
 	return status;
 }
@@ -767,6 +781,186 @@ CyU3PReturnStatus_t AdiConfigurePWM(CyBool_t EnablePWM)
 	return status;
 }
 
+/**
+  * @brief Configures a group of complex GPIO PWM outputs and starts them on the same PWM clock tick.
+  *
+  * @param transferLength The number of bytes sent with the control request
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Request data (little endian): channel count [0], followed by ADI_PWM_GROUP_CHANNEL_LEN
+  * bytes per channel: pin [0-1], period [2-5], threshold [6-9], phase delay [10-13]. The period
+  * and threshold are in PWM clock ticks, and are calculated in the FX3Api, the same as for
+  * AdiConfigurePWM. The phase delay is the number of PWM clock ticks a channel lags the group
+  * start point.
+  *
+  * Each channel must use a different complex GPIO block (pin % 8), and may not use the block
+  * reserved for the 10MHz timer. The complex GPIO blocks have no shared enable bit, so each channel
+  * is first configured and running, then the GPIO fast clock is gated off while every channel timer
+  * is preset to its phase position. Re-enabling the clock (a single register write) releases all the
+  * channels on the same tick. The 10MHz timer is derived from the same clock, so it pauses for the
+  * few register writes the clock is gated.
+  *
+  * Response (bulk endpoint): status [0-3], then for each channel the pin [0-1] and the period [2-5]
+  * and threshold [6-9] read back from the complex GPIO registers, so the host can report the
+  * achieved frequency and duty cycle.
+ **/
+CyU3PReturnStatus_t AdiConfigurePWMGroup(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PGpioComplexConfig_t gpioComplexConfig = {0};
+	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+	uint16_t pins[ADI_PWM_GROUP_MAX_CHANNELS];
+	uint32_t periods[ADI_PWM_GROUP_MAX_CHANNELS];
+	uint32_t thresholds[ADI_PWM_GROUP_MAX_CHANNELS];
+	uint32_t presets[ADI_PWM_GROUP_MAX_CHANNELS];
+	uint32_t phase, intrMask, period, threshold;
+	uint64_t cycleTicks;
+	uint8_t numChannels, numConfigured, block, blockMask;
+	uint8_t * channel;
+	uint8_t * outBuf;
+	int i;
+
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinFunctions_c, __LINE__, status);
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+
+	numChannels = USBBuffer[0];
+	if((numChannels == 0) || (numChannels > ADI_PWM_GROUP_MAX_CHANNELS) || (transferLength < (1 + (numChannels * ADI_PWM_GROUP_CHANNEL_LEN))))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		numChannels = 0;
+	}
+
+	/* Parse and validate each channel before touching any pins */
+	blockMask = 0;
+	for(i = 0; i < numChannels; i++)
+	{
+		channel = USBBuffer + 1 + (i * ADI_PWM_GROUP_CHANNEL_LEN);
+		pins[i] = channel[0];
+		pins[i] |= (channel[1] << 8);
+		periods[i] = channel[2];
+		periods[i] |= (channel[3] << 8);
+		periods[i] |= (channel[4] << 16);
+		periods[i] |= (channel[5] << 24);
+		thresholds[i] = channel[6];
+		thresholds[i] |= (channel[7] << 8);
+		thresholds[i] |= (channel[8] << 16);
+		thresholds[i] |= (channel[9] << 24);
+		phase = channel[10];
+		phase |= (channel[11] << 8);
+		phase |= (channel[12] << 16);
+		phase |= (channel[13] << 24);
+
+		block = pins[i] % 8;
+		if(!AdiIsValidGPIO(pins[i]) || (block == ADI_TIMER_PIN_INDEX) || (blockMask & (1 << block)) || (periods[i] == 0) || (thresholds[i] > periods[i]))
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			numChannels = 0;
+			break;
+		}
+		blockMask |= (1 << block);
+
+		/* Timer counts 0 - period. Starting a channel cycleTicks - phase into its cycle delays it by phase ticks */
+		cycleTicks = (uint64_t) periods[i] + 1;
+		presets[i] = (uint32_t) ((cycleTicks - (phase % cycleTicks)) % cycleTicks);
+	}
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "Starting PWM group with %d channels\r\n", numChannels);
+#endif
+
+	/* Configure each channel in PWM mode */
+	numConfigured = 0;
+	for(i = 0; i < numChannels; i++)
+	{
+		numConfigured = i + 1;
+		status = CyU3PDeviceGpioOverride(pins[i], CyFalse);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(PinFunctions_c, __LINE__, status);
+			numChannels = 0;
+			break;
+		}
+
+		CyU3PMemSet((uint8_t *)&gpioComplexConfig, 0, sizeof (gpioComplexConfig));
+		gpioComplexConfig.outValue = CyFalse;
+		gpioComplexConfig.inputEn = CyFalse;
+		gpioComplexConfig.driveLowEn = CyTrue;
+		gpioComplexConfig.driveHighEn = CyTrue;
+		gpioComplexConfig.pinMode = CY_U3P_GPIO_MODE_PWM;
+		gpioComplexConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+		gpioComplexConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+		gpioComplexConfig.timer = presets[i];
+		gpioComplexConfig.period = periods[i];
+		gpioComplexConfig.threshold = thresholds[i];
+		status = CyU3PGpioSetComplexConfig(pins[i], &gpioComplexConfig);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(PinFunctions_c, __LINE__, status);
+			numChannels = 0;
+			break;
+		}
+	}
+
+	if(numChannels == 0)
+	{
+		/* A channel failed to start. Return every channel touched so far to an undriven input (same as AdiConfigurePWM disable) */
+		gpioConfig.outValue = CyFalse;
+		gpioConfig.inputEn = CyTrue;
+		gpioConfig.driveLowEn = CyFalse;
+		gpioConfig.driveHighEn = CyFalse;
+		gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+		for(i = 0; i < numConfigured; i++)
+		{
+			CyU3PGpioDisable(pins[i]);
+			CyU3PDeviceGpioRestore(pins[i]);
+			if(CyU3PDeviceGpioOverride(pins[i], CyTrue) == CY_U3P_SUCCESS)
+			{
+				CyU3PGpioSetSimpleConfig(pins[i], &gpioConfig);
+			}
+		}
+	}
+	else
+	{
+		/* Freeze all complex GPIO timers, load the phase positions, then release them together */
+		intrMask = CyU3PVicDisableAllInterrupts();
+		GCTL_GPIO_FAST_CLK &= ~GCTL_GPIO_CLK_EN;
+		for(i = 0; i < numChannels; i++)
+		{
+			GPIO->lpp_gpio_pin[pins[i] % 8].timer = presets[i];
+		}
+		GCTL_GPIO_FAST_CLK |= GCTL_GPIO_CLK_EN;
+		CyU3PVicEnableInterrupts(intrMask);
+	}
+
+	/* Report the period and threshold actually loaded for each channel */
+	for(i = 0; i < numChannels; i++)
+	{
+		period = GPIO->lpp_gpio_pin[pins[i] % 8].period;
+		threshold = GPIO->lpp_gpio_pin[pins[i] % 8].threshold;
+		outBuf = BulkBuffer + 4 + (i * ADI_PWM_GROUP_RESPONSE_LEN);
+		outBuf[0] = pins[i] & 0xFF;
+		outBuf[1] = (pins[i] & 0xFF00) >> 8;
+		outBuf[2] = period & 0xFF;
+		outBuf[3] = (period & 0xFF00) >> 8;
+		outBuf[4] = (period & 0xFF0000) >> 16;
+		outBuf[5] = (period & 0xFF000000) >> 24;
+		outBuf[6] = threshold & 0xFF;
+		outBuf[7] = (threshold & 0xFF00) >> 8;
+		outBuf[8] = (threshold & 0xFF0000) >> 16;
+		outBuf[9] = (threshold & 0xFF000000) >> 24;
+	}
+
+	/* Send the data to PC */
+	AdiReturnBulkEndpointData(status, 4 + (numChannels * ADI_PWM_GROUP_RESPONSE_LEN));
+
+	return status;
+}
+
 /**
   * @brief This function drives a GPIO pin for a specified number of milliseconds, then returns it to the starting polarity.
   *
@@ -782,8 +976,9 @@ CyU3PReturnStatus_t AdiPulseDrive()
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	uint16_t pinNumber;
-	CyBool_t polarity, exit;
-	uint32_t timerTicks, timerRollovers, rolloverCount, currentTime, lastTime;
+	CyBool_t polarity;
+	uint32_t timerTicks, timerRollovers;
+	uint64_t startTime, driveTime;
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 
 	/* Parse request data from USBBuffer */
@@ -806,6 +1001,12 @@ CyU3PReturnStatus_t AdiPulseDrive()
 		return CY_U3P_ERROR_BAD_ARGUMENT;
 	}
 
+	/* Driving the DUT reset pin invalidates the register cache */
+	if(pinNumber == FX3State.PinMap.ADI_PIN_RESET)
+	{
+		AdiRegCacheInvalidate();
+	}
+
 	/* Configure the GPIO pin as a driven output */
 	gpioConfig.outValue = polarity;
 	gpioConfig.inputEn = CyFalse;
@@ -814,12 +1015,9 @@ CyU3PReturnStatus_t AdiPulseDrive()
 	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
 	status = CyU3PGpioSetSimpleConfig(pinNumber, &gpioConfig);
 
-	/* Reset the pin timer register to 0 */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
-	/* Disable interrupts on the timer pin */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
-	/* Set the pin timer period to 0xFFFFFFFF */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
+	/* Get the start time */
+	startTime = AdiGetTicks64();
+	driveTime = ((uint64_t) timerRollovers << 32) | timerTicks;
 
 	/* If config fails try to disable and reconfigure */
 	if(status != CY_U3P_SUCCESS)
@@ -834,30 +1032,8 @@ CyU3PReturnStatus_t AdiPulseDrive()
 		}
 	}
 
-	exit = CyFalse;
-	rolloverCount = 0;
-	currentTime = 0;
-	lastTime = 0;
-	while(!exit)
-	{
-		/* Store previous time */
-		lastTime = currentTime;
-
-		/* Set the pin config for sample now mode */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-		/* wait for sample to finish */
-		while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-		/* read timer value */
-		currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
-
-		/* Check if roll over occurred */
-		if(currentTime < lastTime)
-		{
-			rolloverCount++;
-		}
-
-		exit = (currentTime >= timerTicks) && (rolloverCount >= timerRollovers);
-	}
+	/* Wait for the drive time */
+	while((AdiGetTicks64() - startTime) < driveTime);
 
 	/* Set the pin to opposite polarity */
 	CyU3PGpioSetValue(pinNumber, !polarity);
@@ -899,41 +1075,64 @@ CyU3PReturnStatus_t AdiPulseDrive()
 CyU3PReturnStatus_t AdiPulseWait(uint16_t transferLength)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	uint16_t pin;
-    uint16_t *bytesRead = 0;
-	CyBool_t polarity, pinValue, exitCondition;
-	uint32_t currentTime, lastTime, delay, timeoutTicks, timeoutRollover, rollOverCount;
-	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+	uint64_t startTime;
 
-	/* Disable interrupts on the timer pin */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
-	/* Set the pin timer period to 0xFFFFFFFF */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-	/* Reset the pin timer register to 0 */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+	/* Get the start time */
+	startTime = AdiGetTicks64();
 
 	/* Read config data into USBBuffer */
-	CyU3PUsbGetEP0Data(transferLength, USBBuffer, bytesRead);
+	AdiGetRequestData(transferLength, USBBuffer);
 
-	/* Parse request data from USBBuffer */
-	pin = USBBuffer[0];
-	pin = pin + (USBBuffer[1] << 8);
-	polarity = (CyBool_t) USBBuffer[2];
-	delay = USBBuffer[3];
-	delay = delay + (USBBuffer[4] << 8);
-	delay = delay + (USBBuffer[5] << 16);
-	delay = delay + (USBBuffer[6] << 24);
-	timeoutTicks = USBBuffer[7];
-	timeoutTicks = timeoutTicks + (USBBuffer[8] << 8);
-	timeoutTicks = timeoutTicks + (USBBuffer[9] << 16);
-	timeoutTicks = timeoutTicks + (USBBuffer[10] << 24);
-	timeoutRollover = USBBuffer[11];
-	timeoutRollover = timeoutRollover + (USBBuffer[12] << 8);
-	timeoutRollover = timeoutRollover + (USBBuffer[13] << 16);
-	timeoutRollover = timeoutRollover + (USBBuffer[14] << 24);
+	/* Run the wait, with the result placed in the bulk buffer */
+	status = AdiPulseWaitRun(USBBuffer, BulkBuffer + 4, startTime);
+
+	/* Send the data to PC via bulk endpoint */
+	AdiReturnBulkEndpointData(status, 12);
+
+	/* return status code */
+	return status;
+}
+
+/**
+  * @brief Runs a pulse wait: waits for a pin to reach a selected logic level, or time out.
+  *
+  * @param params The wait parameters: pin[0-1], polarity[2], delay in ms[3-6], timeout ticks[7-10], timeout rollovers[11-14]
+  *
+  * @param results Buffer for the time waited (8 bytes, extended 10MHz timer ticks)
+  *
+  * @param startTime Extended timer value the delay and timeout are measured from
+  *
+  * @return A status code indicating the success of the function.
+ **/
+CyU3PReturnStatus_t AdiPulseWaitRun(uint8_t * params, uint8_t * results, uint64_t startTime)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t pin;
+	CyBool_t polarity, pinValue, exitCondition;
+	uint32_t delayMs, timeoutTicks, timeoutRollover;
+	uint64_t elapsedTime, delay, timeout;
+	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+
+	/* Parse request data */
+	pin = params[0];
+	pin = pin + (params[1] << 8);
+	polarity = (CyBool_t) params[2];
+	delayMs = params[3];
+	delayMs = delayMs + (params[4] << 8);
+	delayMs = delayMs + (params[5] << 16);
+	delayMs = delayMs + (params[6] << 24);
+	timeoutTicks = params[7];
+	timeoutTicks = timeoutTicks + (params[8] << 8);
+	timeoutTicks = timeoutTicks + (params[9] << 16);
+	timeoutTicks = timeoutTicks + (params[10] << 24);
+	timeoutRollover = params[11];
+	timeoutRollover = timeoutRollover + (params[12] << 8);
+	timeoutRollover = timeoutRollover + (params[13] << 16);
+	timeoutRollover = timeoutRollover + (params[14] << 24);
 
 	/* Convert ms to timer ticks */
-	delay = delay * MS_TO_TICKS_MULT;
+	delay = (uint64_t) delayMs * MS_TO_TICKS_MULT;
+	timeout = ((uint64_t) timeoutRollover << 32) | timeoutTicks;
 
 	/* Check that input pin specified is configured as input */
 	status = CyU3PGpioSimpleGetValue(pin, &pinValue);
@@ -953,55 +1152,30 @@ CyU3PReturnStatus_t AdiPulseWait(uint16_t transferLength)
 		/* If pin setup not successful skip wait operation and return -1 */
 		if(status != CY_U3P_SUCCESS)
 		{
-			/* Send status code back to PC */
-			AdiReturnBulkEndpointData(status, 12);
 			return status;
 		}
 	}
 
 	/* Wait for the delay, if needed */
-	currentTime = 0;
-	rollOverCount = 0;
-	lastTime = 0;
 	exitCondition = CyFalse;
-	if(delay > 0)
+	elapsedTime = 0;
+	while(elapsedTime < delay)
 	{
-		while(currentTime < delay)
-		{
-			/* Set the pin config for sample now mode */
-			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-			/* wait for sample to finish */
-			while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-			/* read timer value */
-			currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
-		}
+		elapsedTime = AdiGetTicks64() - startTime;
 	}
 
 	/* Wait for the GPIO pin the reach the desired level or timeout */
 	while(!exitCondition)
 	{
-		/* Store previous time */
-		lastTime = currentTime;
-
-		/* Set the pin config for sample now mode */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-		/* wait for sample to finish */
-		while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-		/* read timer value */
-		currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
-
-		/* Check if rollover occured */
-		if(currentTime < lastTime)
-		{
-			rollOverCount++;
-		}
+		/* Get the elapsed time */
+		elapsedTime = AdiGetTicks64() - startTime;
 
 		/* Read the pin value */
 		pinValue = ((GPIO->lpp_gpio_simple[pin] & CY_U3P_LPP_GPIO_IN_VALUE) >> 1);
 
 		/* update the exit condition (will always have valid timeout)
 		 * exits when pin reaches the desired polarity or timer reaches timeout */
-		exitCondition = ((pinValue == polarity) || ((currentTime >= timeoutTicks) && (rollOverCount >= timeoutRollover)));
+		exitCondition = ((pinValue == polarity) || (elapsedTime >= timeout));
 	}
 
 	/* Catch potential out of bounds status code */
@@ -1010,18 +1184,8 @@ CyU3PReturnStatus_t AdiPulseWait(uint16_t transferLength)
 		status = CY_U3P_ERROR_NOT_SUPPORTED;
 	}
 
-	/* Populate bulk buffer with the function results */
-	BulkBuffer[4] = currentTime & 0xFF;
-	BulkBuffer[5] = (currentTime & 0xFF00) >> 8;
-	BulkBuffer[6] = (currentTime & 0xFF0000) >> 16;
-	BulkBuffer[7] = (currentTime & 0xFF000000) >> 24;
-	BulkBuffer[8] = rollOverCount & 0xFF;
-	BulkBuffer[9] = (rollOverCount & 0xFF00) >> 8;
-	BulkBuffer[10] = (rollOverCount & 0xFF0000) >> 16;
-	BulkBuffer[11] = (rollOverCount & 0xFF000000) >> 24;
-
-	/* Send the data to PC via bulk endpoint */
-	AdiReturnBulkEndpointData(status, 12);
+	/* Populate the function results (timer ticks, timer rollovers) */
+	AdiTicks64ToBuffer(elapsedTime, results);
 
 	/* return status code */
 	return status;
@@ -1058,6 +1222,12 @@ CyU3PReturnStatus_t AdiSetPin(uint16_t pinNumber, CyBool_t polarity)
 		CyU3PDebugPrint (4, "Setting pin %d to %d\r\n", pinNumber, polarity);
 #endif
 
+	/* Driving the DUT reset pin invalidates the register cache */
+	if(pinNumber == FX3State.PinMap.ADI_PIN_RESET)
+	{
+		AdiRegCacheInvalidate();
+	}
+
 	/* Configure pin as output and set the drive value */
 	gpioConfig.outValue = polarity;
 	gpioConfig.inputEn = CyFalse;
@@ -1086,15 +1256,42 @@ CyU3PReturnStatus_t AdiSetPin(uint16_t pinNumber, CyBool_t polarity)
   *
   * @param interruptSetting The simple GPIO interrupt mode that the selected pin is configured with.
   *
-  * @param timeoutTicks The number of GPIO timer ticks (10MHz) to wait for before timing out and returning.
+  * @param timeoutMs The time (in ms) to wait for before timing out and returning. Must be non-zero.
   *
   * @return A status code indicating the success of the pin wait function.
+  *
+  * The pin interrupt bit is polled with the GPIO interrupt vector masked (AdiGpioRouterMask), since the
+  * SDK GPIO ISR would otherwise clear it. Any edge latched before the call is cleared first, so only an
+  * edge during the wait is reported. The edge is counted through AdiGpioRouterCountEdge.
  **/
-CyU3PReturnStatus_t AdiWaitForPin(uint32_t pinNumber, CyU3PGpioIntrMode_t interruptSetting, uint32_t timeoutTicks)
+CyU3PReturnStatus_t AdiWaitForPin(uint32_t pinNumber, CyU3PGpioIntrMode_t interruptSetting, uint32_t timeoutMs)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	uint32_t gpioEventFlag = 0;
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+	volatile uint32_t * intrReg;
+	uint32_t intrMask;
+	uint64_t startTime, timeout;
+	CyBool_t edgeDetected;
+
+	if((timeoutMs == 0) || !AdiIsValidGPIO(pinNumber))
+	{
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	/* Interrupt status register and bit for the pin */
+	if(pinNumber < 32)
+	{
+		intrReg = &GPIO->lpp_gpio_intr0;
+		intrMask = 1 << pinNumber;
+	}
+	else
+	{
+		intrReg = &GPIO->lpp_gpio_intr1;
+		intrMask = 1 << (pinNumber - 32);
+	}
+
+	/* Mask relevant interrupts */
+	AdiGpioRouterMask();
 
 	/* Configure the specified pin as an input and attach the correct pin interrupt */
 	gpioConfig.outValue = CyTrue;
@@ -1103,22 +1300,38 @@ CyU3PReturnStatus_t AdiWaitForPin(uint32_t pinNumber, CyU3PGpioIntrMode_t interr
 	gpioConfig.driveHighEn = CyFalse;
 	gpioConfig.intrMode = interruptSetting;
 	status = CyU3PGpioSetSimpleConfig(pinNumber, &gpioConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiGpioRouterUnmask();
+		return status;
+	}
+
+	/* Clear any stale edge */
+	GPIO->lpp_gpio_simple[pinNumber] |= CY_U3P_LPP_GPIO_INTR;
 
-	/* Catch unspecified timeout */
-	if (timeoutTicks == 0)
+	/* Wait for the edge, or timeout */
+	timeout = (uint64_t) timeoutMs * MS_TO_TICKS_MULT;
+	startTime = AdiGetTicks64();
+	edgeDetected = CyFalse;
+	while(!edgeDetected)
 	{
-		timeoutTicks = CYU3P_WAIT_FOREVER;
+		edgeDetected = ((*intrReg) & intrMask) ? CyTrue : CyFalse;
+		if(!edgeDetected && ((AdiGetTicks64() - startTime) >= timeout))
+		{
+			status = CY_U3P_ERROR_TIMEOUT;
+			break;
+		}
 	}
 
-	if (status == CY_U3P_SUCCESS)
+	if(edgeDetected)
 	{
-		/* Enable GPIO interrupts (in case it's not enabled) */
-		CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-		/* Wait for GPIO interrupt flag */
-		status = CyU3PEventGet(&GpioHandler, pinNumber, CYU3P_EVENT_OR_CLEAR, &gpioEventFlag, timeoutTicks);
-		/* Disable GPIO interrupts until we need them again */
-		CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+		GPIO->lpp_gpio_simple[pinNumber] |= CY_U3P_LPP_GPIO_INTR;
+		AdiGpioRouterCountEdge(pinNumber);
 	}
+
+	/* Unmask interrupts (only re-enables the vector if no one else holds the mask) */
+	AdiGpioRouterUnmask();
+
 	return status;
 }
 
@@ -1135,21 +1348,21 @@ uint32_t AdiMStoTicks(uint32_t timeInMS)
 }
 
 /**
-  * @brief This function handles Pin read control end point requests.
+  * @brief Configures a pin as an input and reads its value.
   *
   * @param pin The GPIO matrix number of the pin to read
   *
-  * @return The success of the pin read operation
+  * @param pinValue Output for the pin value
   *
-  * This function reads the value of a specified GPIO pin, and sends that value over the
-  * control endpoint to the host PC. The pin read status is also attached.
+  * @return The success of the pin read operation
  **/
-CyU3PReturnStatus_t AdiPinRead(uint16_t pin)
+CyU3PReturnStatus_t AdiReadPinValue(uint16_t pin, CyBool_t * pinValue)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	CyBool_t pinValue = CyFalse;
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 
+	*pinValue = CyFalse;
+
 	if(AdiIsValidGPIO(pin))
 	{
 		/* Configure pin as input and sample the pin value */
@@ -1162,7 +1375,7 @@ CyU3PReturnStatus_t AdiPinRead(uint16_t pin)
 		/* If the config is successful, read the pin value */
 		if(status == CY_U3P_SUCCESS)
 		{
-			status = CyU3PGpioSimpleGetValue(pin, &pinValue);
+			status = CyU3PGpioSimpleGetValue(pin, pinValue);
 		}
 		else
 		{
@@ -1171,7 +1384,7 @@ CyU3PReturnStatus_t AdiPinRead(uint16_t pin)
 			status = CyU3PGpioSetSimpleConfig(pin, &gpioConfig);
 			if(status == CY_U3P_SUCCESS)
 			{
-				status = CyU3PGpioSimpleGetValue(pin, &pinValue);
+				status = CyU3PGpioSimpleGetValue(pin, pinValue);
 			}
 			else
 				AdiLogError(PinFunctions_c, __LINE__, status);
@@ -1183,27 +1396,47 @@ CyU3PReturnStatus_t AdiPinRead(uint16_t pin)
 	}
 
 #ifdef VERBOSE_MODE
-		CyU3PDebugPrint (4, "Pin %d value: %d\r\n", pin, pinValue);
+		CyU3PDebugPrint (4, "Pin %d value: %d\r\n", pin, *pinValue);
 #endif
 
-	/* Put pin register value in output buffer */
-	USBBuffer[0] = pinValue;
-	USBBuffer[1] = status & 0xFF;
-	USBBuffer[2] = (status & 0xFF00) >> 8;
-	USBBuffer[3] = (status & 0xFF0000) >> 16;
-	USBBuffer[4] = (status & 0xFF000000) >> 24;
-	/* Send the pin value */
-	CyU3PUsbSendEP0Data (5, (uint8_t *)USBBuffer);
 	return status;
 }
 
 /**
-  * @brief Reads the current value of the 10MHz timer (32 bit)
+  * @brief This function handles Pin read control end point requests.
   *
-  * @return The number of elapsed timer ticks
- **/
-uint32_t AdiReadTimerRegValue()
-{
+  * @param pin The GPIO matrix number of the pin to read
+  *
+  * @return The success of the pin read operation
+  *
+  * This function reads the value of a specified GPIO pin, and sends that value over the
+  * control endpoint to the host PC. The pin read status is also attached.
+ **/
+CyU3PReturnStatus_t AdiPinRead(uint16_t pin)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyBool_t pinValue = CyFalse;
+
+	status = AdiReadPinValue(pin, &pinValue);
+
+	/* Put pin register value in output buffer */
+	USBBuffer[0] = pinValue;
+	USBBuffer[1] = status & 0xFF;
+	USBBuffer[2] = (status & 0xFF00) >> 8;
+	USBBuffer[3] = (status & 0xFF0000) >> 16;
+	USBBuffer[4] = (status & 0xFF000000) >> 24;
+	/* Send the pin value */
+	CyU3PUsbSendEP0Data (5, (uint8_t *)USBBuffer);
+	return status;
+}
+
+/**
+  * @brief Samples the 10MHz timer hardware register
+  *
+  * @return The 32-bit timer register value
+ **/
+static inline uint32_t AdiSampleTimerPin()
+{
 	/* Set config for sample now mode */
 	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
 	/* Wait for sample to finish */
@@ -1212,6 +1445,153 @@ uint32_t AdiReadTimerRegValue()
 	return GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
 }
 
+/**
+  * @brief Gets the current value of the 64-bit extended 10MHz timer
+  *
+  * @return The number of 10MHz timer ticks since power up
+  *
+  * The 32-bit complex GPIO timer is extended in software. A timer zero interrupt on the timer pin counts
+  * each hardware rollover (AdiTimerRolloverHandler). Timing functions run with the GPIO interrupt vector
+  * disabled, so a pending rollover is also consumed here. Interrupts are disabled while the timer is sampled,
+  * so each rollover is counted exactly once, by either path. The returned value never wraps.
+  *
+  * While a stream or bit bang SPI transaction has taken over the timer hardware (AdiTimerAcquire), the value
+  * advances at the RTOS tick (1ms) resolution instead, so any delay or measurement made with it during that
+  * time is only accurate to 1ms.
+ **/
+uint64_t AdiGetTicks64()
+{
+	uint32_t intrMask, currentTime;
+	uint64_t ticks;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+
+	if(TimerAcquired)
+	{
+		/* Timer hardware is in use. Only 1ms (10000 tick) resolution until AdiTimerRelease */
+		ticks = TimerAcquireTicks + ((uint64_t) (CyU3PGetTime() - TimerAcquireOsTime) * MS_TO_TICKS_MULT);
+	}
+	else
+	{
+		currentTime = AdiSampleTimerPin();
+
+		/* Rollover which has not been serviced by the ISR. Sample again, so the value is after the rollover */
+		if(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR)
+		{
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | CY_U3P_LPP_GPIO_INTR);
+			TimerRollovers++;
+			currentTime = AdiSampleTimerPin();
+		}
+		ticks = TimerBase + ((uint64_t) TimerRollovers << 32) + currentTime;
+	}
+
+	CyU3PVicEnableInterrupts(intrMask);
+
+	return ticks;
+}
+
+/**
+  * @brief Writes an extended timer value to a buffer as timer ticks[0-3], timer rollovers[4-7]
+  *
+  * @param ticks The extended timer value (or difference)
+  *
+  * @param outBuf The buffer to write the 8 bytes to
+  *
+  * @return void
+ **/
+void AdiTicks64ToBuffer(uint64_t ticks, uint8_t * outBuf)
+{
+	outBuf[0] = ticks & 0xFF;
+	outBuf[1] = (ticks >> 8) & 0xFF;
+	outBuf[2] = (ticks >> 16) & 0xFF;
+	outBuf[3] = (ticks >> 24) & 0xFF;
+	outBuf[4] = (ticks >> 32) & 0xFF;
+	outBuf[5] = (ticks >> 40) & 0xFF;
+	outBuf[6] = (ticks >> 48) & 0xFF;
+	outBuf[7] = (ticks >> 56) & 0xFF;
+}
+
+/**
+  * @brief Counts a 10MHz timer rollover. Called from the GPIO interrupt handler on a timer zero event
+  *
+  * @return void
+  *
+  * Timer events while the timer hardware is acquired (stall or SCLK timing) are not rollovers, and are
+  * not counted. The SDK GPIO ISR has already cleared the pin interrupt status before this is called, so
+  * those events are lost to any poller. Functions which poll the timer interrupt themselves must keep the
+  * GPIO vector masked (AdiGpioRouterMask) while they do so.
+ **/
+void AdiTimerRolloverHandler()
+{
+	if(!TimerAcquired)
+	{
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+		TimerRollovers++;
+	}
+}
+
+/**
+  * @brief Takes over the 10MHz timer hardware, for functions which need to reprogram the timer period or threshold
+  *
+  * @return void
+  *
+  * The extended timer value is saved, and AdiGetTicks64 continues from it using the RTOS time until
+  * AdiTimerRelease is called. Calling this when the timer is already acquired has no effect.
+ **/
+void AdiTimerAcquire()
+{
+	uint64_t ticks;
+
+	if(TimerAcquired)
+		return;
+
+	ticks = AdiGetTicks64();
+	TimerAcquireTicks = ticks;
+	TimerAcquireOsTime = CyU3PGetTime();
+	TimerAcquired = CyTrue;
+}
+
+/**
+  * @brief Restores the 10MHz timer hardware to free running mode, with a rollover interrupt
+  *
+  * @return void
+  *
+  * The extended timer value picks up from the value saved by AdiTimerAcquire, plus the time spent acquired.
+  * Calling this when the timer is not acquired has no effect.
+ **/
+void AdiTimerRelease()
+{
+	uint32_t intrMask;
+
+	if(!TimerAcquired)
+		return;
+
+	intrMask = CyU3PVicDisableAllInterrupts();
+
+	/* Restore the timer to free running mode */
+	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold = 0xFFFFFFFF;
+	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
+	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | CY_U3P_LPP_GPIO_INTR);
+
+	/* Continue counting from the acquired time */
+	TimerBase = TimerAcquireTicks + ((uint64_t) (CyU3PGetTime() - TimerAcquireOsTime) * MS_TO_TICKS_MULT);
+	TimerRollovers = 0;
+	TimerAcquired = CyFalse;
+
+	CyU3PVicEnableInterrupts(intrMask);
+}
+
+/**
+  * @brief Reads the low 32 bits of the extended 10MHz timer
+  *
+  * @return The number of elapsed timer ticks (wraps every ~7 minutes)
+ **/
+uint32_t AdiReadTimerRegValue()
+{
+	return (uint32_t) AdiGetTicks64();
+}
+
 /**
   * @brief Reads the current value from the complex GPIO timer and then sends the value over the control endpoint.
   *
@@ -1225,11 +1605,7 @@ CyU3PReturnStatus_t AdiReadTimerValue()
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	uint32_t timerValue;
 
-	status = CyU3PGpioComplexSampleNow(ADI_TIMER_PIN, &timerValue);
-	if(status != CY_U3P_SUCCESS)
-	{
-		AdiLogError(PinFunctions_c, __LINE__, status);
-	}
+	timerValue = AdiReadTimerRegValue();
 	USBBuffer[4] = timerValue & 0xFF;
 	USBBuffer[5] = (timerValue & 0xFF00) >> 8;
 	USBBuffer[6] = (timerValue & 0xFF0000) >> 16;
@@ -1253,86 +1629,84 @@ CyU3PReturnStatus_t AdiReadTimerValue()
   * timeoutInMs: The specified timeout in milliseconds
  **/
 CyU3PReturnStatus_t AdiMeasurePinFreq()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Run the measurement using the request data in the USB Buffer */
+	status = AdiMeasurePinFreqRun(USBBuffer, BulkBuffer + 4);
+
+	/* Send the data to PC */
+	AdiReturnBulkEndpointData(status, 12);
+
+	/* return status code */
+	return status;
+}
+
+/**
+  * @brief Runs a data ready frequency measurement on a pin.
+  *
+  * @param params The measurement parameters: pin[0-1], polarity[2], timeout ticks[3-6], timeout rollovers[7-10], number of periods[11-12]
+  *
+  * @param results Buffer for the measured time (8 bytes, extended 10MHz timer ticks)
+  *
+  * @return A status code indicating the success of the measurement
+ **/
+CyU3PReturnStatus_t AdiMeasurePinFreqRun(uint8_t * params, uint8_t * results)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	CyBool_t polarity, timeoutOccurred, interruptTriggered, exitCondition;
 	uint16_t pin, numPeriods, periodCount;
-	uint32_t timeoutTicks, timeoutRollovers, currentTime, lastTime, rollovers;
+	uint32_t timeoutTicks, timeoutRollovers;
+	uint64_t startTime, elapsedTime, timeout;
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 
-	/* Parse data from the USB Buffer */
-	pin = USBBuffer[0];
-	pin |= (USBBuffer[1] << 8);
-	polarity = USBBuffer[2];
-	timeoutTicks = USBBuffer[3];
-	timeoutTicks |= (USBBuffer[4] << 8);
-	timeoutTicks |= (USBBuffer[5] << 16);
-	timeoutTicks |= (USBBuffer[6] << 24);
-	timeoutRollovers = USBBuffer[7];
-	timeoutRollovers |= (USBBuffer[8] << 8);
-	timeoutRollovers |= (USBBuffer[9] << 16);
-	timeoutRollovers |= (USBBuffer[10] << 24);
-	numPeriods = USBBuffer[11];
-	numPeriods |= (USBBuffer[12] << 8);
-
-	/* Disable relevant interrupts */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* Parse the measurement parameters */
+	pin = params[0];
+	pin |= (params[1] << 8);
+	polarity = params[2];
+	timeoutTicks = params[3];
+	timeoutTicks |= (params[4] << 8);
+	timeoutTicks |= (params[5] << 16);
+	timeoutTicks |= (params[6] << 24);
+	timeoutRollovers = params[7];
+	timeoutRollovers |= (params[8] << 8);
+	timeoutRollovers |= (params[9] << 16);
+	timeoutRollovers |= (params[10] << 24);
+	numPeriods = params[11];
+	numPeriods |= (params[12] << 8);
+
+	/* Mask relevant interrupts */
+	AdiGpioRouterMask();
 
 	/* Configure pin as an input, with interrupts set on the desired polarity */
 	AdiConfigurePinInterrupt(pin, polarity);
 
-	/* Reset timer value */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
-	/* Disable interrupts on the timer pin */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
-	/* Set the pin timer period to 0xFFFFFFFF */
-	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-
-	currentTime = 0;
-	lastTime = 0;
-	rollovers = 0;
+	timeout = ((uint64_t) timeoutRollovers << 32) | timeoutTicks;
+	startTime = AdiGetTicks64();
+	elapsedTime = 0;
 	timeoutOccurred = CyFalse;
 	interruptTriggered = CyFalse;
 	/* Clear GPIO interrupts */
-	GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+	GPIO->lpp_gpio_simple[pin] |= CY_U3P_LPP_GPIO_INTR;
 	/* Wait for edge, checking timeout as well */
 	while(!(interruptTriggered | timeoutOccurred))
 	{
 		interruptTriggered = GPIO->lpp_gpio_intr0 & (1 << pin);
 		if(interruptTriggered)
 		{
-			/* Reset the timer and clear bit*/
-			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+			/* Restart the measurement from this edge and clear bit */
+			startTime = AdiGetTicks64();
 			GPIO->lpp_gpio_simple[pin] |= CY_U3P_LPP_GPIO_INTR;
 		}
 		else
 		{
-			/* Get the new time values */
-			lastTime = currentTime;
-
-			/* Set the pin config for sample now mode */
-			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-			/* Wait for sample to finish */
-			while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-			/* Read timer value */
-			currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
-
-			/* Check if roll over occurred */
-			if(currentTime < lastTime)
-			{
-				rollovers++;
-			}
-
 			/* Determine if a timeout has occurred */
-			timeoutOccurred = (currentTime >= timeoutTicks) && (rollovers >= timeoutRollovers);
+			timeoutOccurred = (AdiGetTicks64() - startTime) >= timeout;
 		}
 	}
 
 	/* Reset counters */
-	currentTime = 0;
-	lastTime = 0;
-	rollovers = 0;
+	elapsedTime = 0;
 	periodCount = 0;
 	interruptTriggered = CyFalse;
 
@@ -1351,37 +1725,18 @@ CyU3PReturnStatus_t AdiMeasurePinFreq()
 			GPIO->lpp_gpio_simple[pin] |= CY_U3P_LPP_GPIO_INTR;
 		}
 
-		/* Save the last timer value */
-		lastTime = currentTime;
-
-		/* Get the new timer value */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status = (FX3State.TimerPinConfig | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS));
-		while (GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_MODE_MASK);
-		currentTime = GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold;
-
-		/* Check if rollover occured */
-		if(currentTime < lastTime)
-		{
-			rollovers++;
-		}
+		/* Get the time since the first edge */
+		elapsedTime = AdiGetTicks64() - startTime;
 
 		/* Determine if a timeout has occurred */
-		timeoutOccurred = (currentTime >= timeoutTicks) && (rollovers >= timeoutRollovers);
+		timeoutOccurred = (elapsedTime >= timeout);
 
 		/* Determine the exit condition */
 		exitCondition = timeoutOccurred || (periodCount >= numPeriods);
 	}
 
 	/* add 0.8us to current time (fudge factor, calibrated using DSLogic Pro) */
-	if(currentTime < (0xFFFFFFFF - 8))
-	{
-		currentTime = currentTime + 8;
-	}
-	else
-	{
-		currentTime = 0;
-		rollovers++;
-	}
+	elapsedTime += 8;
 
 	/* Set error flags if a timeout occurred (status = timeout error) */
 	if(timeoutOccurred)
@@ -1397,55 +1752,487 @@ CyU3PReturnStatus_t AdiMeasurePinFreq()
 	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
 	CyU3PGpioSetSimpleConfig(pin, &gpioConfig);
 
-	/* Re-enable relevant ISRs */
-	CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-	CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Release the interrupt mask */
+	AdiGpioRouterUnmask();
+
+	/* Populate function results (timer ticks, timer rollovers) */
+	AdiTicks64ToBuffer(elapsedTime, results);
+
+	/* return status code */
+	return status;
+}
+
+/**
+  * @brief Captures a timestamp for each edge on a user specified pin
+  *
+  * @param transferLength The number of request data bytes
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Request data is formatted as pin[0-1], edge[2] (0 = falling, 1 = rising, 2 = both),
+  * number of edges[3-6], timeout in ms[7-10] (must be non-zero, since the capture holds the
+  * control endpoint with the GPIO ISR masked). The timer is reset when the capture starts. The status, number of edges captured[4-7] and the timestamp records are
+  * returned over the bulk endpoint, starting at BulkBuffer[8]. If the timeout expires the
+  * edges captured so far are returned, along with a timeout status.
+ **/
+CyU3PReturnStatus_t AdiEdgeCaptureHandler(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	EdgeCaptureState state;
+	uint16_t pin;
+	uint8_t edge;
+	uint32_t numEdges, timeoutMs, edgesCaptured;
+
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinFunctions_c, __LINE__, status);
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+
+	/* Parse request data */
+	pin = USBBuffer[0];
+	pin |= (USBBuffer[1] << 8);
+	edge = USBBuffer[2];
+	numEdges = USBBuffer[3];
+	numEdges |= (USBBuffer[4] << 8);
+	numEdges |= (USBBuffer[5] << 16);
+	numEdges |= (USBBuffer[6] << 24);
+	timeoutMs = USBBuffer[7];
+	timeoutMs |= (USBBuffer[8] << 8);
+	timeoutMs |= (USBBuffer[9] << 16);
+	timeoutMs |= (USBBuffer[10] << 24);
+
+	edgesCaptured = 0;
+	if((numEdges == 0) || (numEdges > ADI_EDGE_CAPTURE_MAX_EDGES) || (timeoutMs == 0) || (edge > 2) || !AdiIsValidGPIO(pin))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	else
+	{
+		/* Mask relevant interrupts */
+		AdiGpioRouterMask();
+
+		status = AdiEdgeCaptureInit(&state, pin, edge);
+		if(status == CY_U3P_SUCCESS)
+		{
+			edgesCaptured = AdiEdgeCaptureRun(&state, BulkBuffer + 8, numEdges, (uint64_t) timeoutMs * MS_TO_TICKS_MULT);
+			if(edgesCaptured < numEdges)
+			{
+				status = CY_U3P_ERROR_TIMEOUT;
+			}
+		}
+		AdiEdgeCaptureEnd(&state);
+
+		/* Release the interrupt mask */
+		AdiGpioRouterUnmask();
+	}
 
-	/* Populate bulk buffer with function results */
-	BulkBuffer[4] = currentTime & 0xFF;
-	BulkBuffer[5] = (currentTime & 0xFF00) >> 8;
-	BulkBuffer[6] = (currentTime & 0xFF0000) >> 16;
-	BulkBuffer[7] = (currentTime & 0xFF000000) >> 24;
-	BulkBuffer[8] = rollovers & 0xFF;
-	BulkBuffer[9] = (rollovers & 0xFF00) >> 8;
-	BulkBuffer[10] = (rollovers & 0xFF0000) >> 16;
-	BulkBuffer[11] = (rollovers & 0xFF000000) >> 24;
+	BulkBuffer[4] = edgesCaptured & 0xFF;
+	BulkBuffer[5] = (edgesCaptured & 0xFF00) >> 8;
+	BulkBuffer[6] = (edgesCaptured & 0xFF0000) >> 16;
+	BulkBuffer[7] = (edgesCaptured & 0xFF000000) >> 24;
 
 	/* Send the data to PC */
-	AdiReturnBulkEndpointData(status, 12);
+	AdiReturnBulkEndpointData(status, 8 + (edgesCaptured * ADI_EDGE_RECORD_LEN));
 
-	/* return status code */
 	return status;
 }
 
 /**
-  * @brief configures the selected pin as an interrupt with edge triggering based on polarity
+  * @brief Starts an edge timestamp capture on a pin
   *
-  * @param polarity The edge to trigger on (true -> rising edge, false -> falling edge)
+  * @param state The capture state to initialize
   *
-  * @param pin The GPIO pin number to configure
+  * @param pin The GPIO pin number to capture
+  *
+  * @param edge The edge(s) to capture (0 = falling, 1 = rising, 2 = both)
   *
   * @return The success of the pin configuration operation.
+  *
+  * Configures the pin as an input with edge interrupts enabled, and resets the 10MHz timer. The
+  * GPIO ISR should be disabled by the caller for the duration of the capture. The capture ignores
+  * stream stop requests, unless the caller sets StopOnStreamKill after this function returns.
  **/
-CyU3PReturnStatus_t AdiConfigurePinInterrupt(uint16_t pin, CyBool_t polarity)
+CyU3PReturnStatus_t AdiEdgeCaptureInit(EdgeCaptureState * state, uint16_t pin, uint8_t edge)
+{
+	CyU3PReturnStatus_t status;
+	CyU3PGpioIntrMode_t intrMode;
+
+	if(edge == 0)
+		intrMode = CY_U3P_GPIO_INTR_NEG_EDGE;
+	else if(edge == 1)
+		intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
+	else
+		intrMode = CY_U3P_GPIO_INTR_BOTH_EDGE;
+
+	status = AdiConfigurePinEdgeInterrupt(pin, intrMode);
+
+	state->Pin = pin;
+	state->StartTime = AdiGetTicks64();
+	state->LastTime = 0;
+	state->StopOnStreamKill = CyFalse;
+
+	/* Clear any edge seen before the capture started */
+	GPIO->lpp_gpio_simple[pin] |= CY_U3P_LPP_GPIO_INTR;
+
+	return status;
+}
+
+/**
+  * @brief Captures edge timestamps until the requested number of edges is reached
+  *
+  * @param state The capture state (from AdiEdgeCaptureInit)
+  *
+  * @param outBuf Buffer to place the ADI_EDGE_RECORD_LEN byte timestamp records in
+  *
+  * @param numEdges The number of edges to capture
+  *
+  * @param timeoutTicks Capture timeout, in 10MHz timer ticks. 0 waits until a stream stop is requested
+  *
+  * @return The number of edges captured
+  *
+  * Each edge is timestamped with the first extended timer sample after it is detected (approx. 1us
+  * resolution), relative to the start of the capture. If state->StopOnStreamKill is set, also exits when a stream
+  * stop (KillStreamEarly) is requested. One-shot captures leave it clear, so a stale stop request from an earlier
+  * stream can not end them early.
+ **/
+uint32_t AdiEdgeCaptureRun(EdgeCaptureState * state, uint8_t * outBuf, uint32_t numEdges, uint64_t timeoutTicks)
+{
+	uint32_t edgeCount = 0;
+	uint32_t intrMask;
+	volatile uint32_t * intrReg;
+	uint64_t startTime, now;
+	CyBool_t edgeDetected;
+
+	/* Interrupt status register and bit for the pin */
+	if(state->Pin < 32)
+	{
+		intrReg = &GPIO->lpp_gpio_intr0;
+		intrMask = 1 << state->Pin;
+	}
+	else
+	{
+		intrReg = &GPIO->lpp_gpio_intr1;
+		intrMask = 1 << (state->Pin - 32);
+	}
+
+	startTime = state->LastTime;
+
+	while((edgeCount < numEdges) && !(state->StopOnStreamKill && KillStreamEarly))
+	{
+		/* Check for an edge before sampling the timer, so the timestamp is never early */
+		edgeDetected = ((*intrReg) & intrMask) ? CyTrue : CyFalse;
+		if(edgeDetected)
+		{
+			GPIO->lpp_gpio_simple[state->Pin] |= CY_U3P_LPP_GPIO_INTR;
+		}
+
+		/* Get the time since the capture started */
+		now = AdiGetTicks64() - state->StartTime;
+		state->LastTime = now;
+
+		if(edgeDetected)
+		{
+			AdiTicks64ToBuffer(now, outBuf);
+			outBuf += ADI_EDGE_RECORD_LEN;
+			edgeCount++;
+		}
+
+		/* Check timeout */
+		if(timeoutTicks)
+		{
+			if((now - startTime) >= timeoutTicks)
+				break;
+		}
+	}
+	return edgeCount;
+}
+
+/**
+  * @brief Ends an edge timestamp capture, removing the edge interrupt from the pin
+  *
+  * @param state The capture state
+  *
+  * @return void
+ **/
+void AdiEdgeCaptureEnd(EdgeCaptureState * state)
 {
-	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 
-	/* Make sure the data ready pin is configured as an input and attach the correct pin interrupt */
 	gpioConfig.outValue = CyTrue;
 	gpioConfig.inputEn = CyTrue;
 	gpioConfig.driveLowEn = CyFalse;
 	gpioConfig.driveHighEn = CyFalse;
-	if (polarity)
+	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	CyU3PGpioSetSimpleConfig(state->Pin, &gpioConfig);
+	GPIO->lpp_gpio_simple[state->Pin] |= CY_U3P_LPP_GPIO_INTR;
+}
+
+/**
+  * @brief Measures a number of consecutive periods on a pin, and returns period statistics and a histogram
+  *
+  * @param transferLength The number of bytes to read from the control endpoint
+  *
+  * @return A status code indicating the success of the measurement
+  *
+  * Request data: pin[0-1], edge[2] (0 = falling, 1 = rising, 2 = both), number of periods[3-6],
+  * timeout in ms[7-10] (must be non-zero), first bin start[11-14], bin width[15-18], number of bins[19-20].
+  * Bin start and bin width are in 10MHz timer ticks.
+  *
+  * Response data (after status): period count[4-7], min period[8-11], max period[12-15],
+  * reference period[16-19], sum of (period - reference)[20-27] (signed), sum of (period - reference)^2[28-35],
+  * periods below the first bin[36-39], periods above the last bin[40-43], flags[44-47], bin counts[48-...].
+  * All periods are in 10MHz timer ticks.
+  *
+  * Periods are accumulated as each edge is seen, so no samples are stored. Sums are taken relative to the
+  * first measured period, which keeps them exact in 64 bits for any realistic signal. Each squared deviation
+  * is exact (periods are clamped to 32 bits), and the sums saturate instead of wrapping. If either sum
+  * saturates, ADI_PERIOD_STATS_FLAG_SATURATED is set, and the sums are no longer exact. The mean and variance
+  * are computed from the sums by the host.
+ **/
+CyU3PReturnStatus_t AdiMeasurePinPeriodStats(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	EdgeCaptureState state;
+	uint16_t pin, numBins;
+	uint8_t edge;
+	uint32_t numPeriods, timeoutMs, binStart, binWidth, periodCount, bin;
+	uint32_t minPeriod, maxPeriod, refPeriod, underflow, overflow;
+	uint64_t timeoutTicks, lastEdge, edgeTime, period, now, sumSqDev, absDev, sqDev;
+	int64_t sumDev;
+	uint32_t flags;
+	uint32_t * bins;
+	uint32_t results[11];
+	uint8_t record[ADI_EDGE_RECORD_LEN];
+	CyBool_t firstEdge;
+	int i;
+
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinFunctions_c, __LINE__, status);
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+
+	/* Parse request data */
+	pin = USBBuffer[0];
+	pin |= (USBBuffer[1] << 8);
+	edge = USBBuffer[2];
+	numPeriods = USBBuffer[3];
+	numPeriods |= (USBBuffer[4] << 8);
+	numPeriods |= (USBBuffer[5] << 16);
+	numPeriods |= (USBBuffer[6] << 24);
+	timeoutMs = USBBuffer[7];
+	timeoutMs |= (USBBuffer[8] << 8);
+	timeoutMs |= (USBBuffer[9] << 16);
+	timeoutMs |= (USBBuffer[10] << 24);
+	binStart = USBBuffer[11];
+	binStart |= (USBBuffer[12] << 8);
+	binStart |= (USBBuffer[13] << 16);
+	binStart |= (USBBuffer[14] << 24);
+	binWidth = USBBuffer[15];
+	binWidth |= (USBBuffer[16] << 8);
+	binWidth |= (USBBuffer[17] << 16);
+	binWidth |= (USBBuffer[18] << 24);
+	numBins = USBBuffer[19];
+	numBins |= (USBBuffer[20] << 8);
+
+	/* Histogram bins are accumulated in place in the bulk buffer (4 byte aligned, little endian) */
+	bins = (uint32_t *) (BulkBuffer + ADI_PERIOD_STATS_HEADER_LEN);
+
+	periodCount = 0;
+	minPeriod = 0xFFFFFFFF;
+	maxPeriod = 0;
+	refPeriod = 0;
+	underflow = 0;
+	overflow = 0;
+	sumDev = 0;
+	sumSqDev = 0;
+	flags = 0;
+
+	/* The measurement holds the control endpoint with the GPIO ISR masked, so must have a timeout */
+	if((numPeriods == 0) || (timeoutMs == 0) || (edge > 2) || (numBins > ADI_PERIOD_STATS_MAX_BINS) || ((numBins != 0) && (binWidth == 0)) || !AdiIsValidGPIO(pin))
 	{
-		gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		numBins = 0;
 	}
 	else
 	{
-		gpioConfig.intrMode = CY_U3P_GPIO_INTR_NEG_EDGE;
+		CyU3PMemSet((uint8_t *) bins, 0, numBins * 4);
+		timeoutTicks = (uint64_t) timeoutMs * MS_TO_TICKS_MULT;
+
+		/* Mask relevant interrupts */
+		AdiGpioRouterMask();
+
+		status = AdiEdgeCaptureInit(&state, pin, edge);
+		lastEdge = 0;
+		firstEdge = CyTrue;
+		/* Capture one edge at a time. Periods are measured starting from the first edge */
+		while((status == CY_U3P_SUCCESS) && (periodCount < numPeriods))
+		{
+			/* Capture timeout is relative to the start of each call, so pass the time remaining */
+			now = state.LastTime;
+			if(now >= timeoutTicks)
+			{
+				status = CY_U3P_ERROR_TIMEOUT;
+				break;
+			}
+			if(AdiEdgeCaptureRun(&state, record, 1, timeoutTicks - now) == 0)
+			{
+				status = CY_U3P_ERROR_TIMEOUT;
+				break;
+			}
+
+			edgeTime = ((uint64_t) record[4] << 32) | ((uint64_t) record[5] << 40) | ((uint64_t) record[6] << 48) | ((uint64_t) record[7] << 56);
+			edgeTime |= record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t) record[3] << 24);
+
+			period = edgeTime - lastEdge;
+			lastEdge = edgeTime;
+
+			/* First edge only marks the start of the first period */
+			if(firstEdge)
+			{
+				firstEdge = CyFalse;
+				continue;
+			}
+			if(period > 0xFFFFFFFF)
+				period = 0xFFFFFFFF;
+
+			/* Update running statistics */
+			if(periodCount == 0)
+				refPeriod = (uint32_t) period;
+			if(period < minPeriod)
+				minPeriod = (uint32_t) period;
+			if(period > maxPeriod)
+				maxPeriod = (uint32_t) period;
+
+			/* Period and reference are both 32 bits, so the squared deviation fits in 64 bits. Saturate the sums instead of wrapping */
+			if(period >= refPeriod)
+			{
+				absDev = period - refPeriod;
+				if(sumDev > (int64_t) (0x7FFFFFFFFFFFFFFFULL - absDev))
+				{
+					sumDev = 0x7FFFFFFFFFFFFFFFLL;
+					flags |= ADI_PERIOD_STATS_FLAG_SATURATED;
+				}
+				else
+				{
+					sumDev += (int64_t) absDev;
+				}
+			}
+			else
+			{
+				absDev = refPeriod - period;
+				if(sumDev < (-0x7FFFFFFFFFFFFFFFLL - 1) + (int64_t) absDev)
+				{
+					sumDev = (-0x7FFFFFFFFFFFFFFFLL - 1);
+					flags |= ADI_PERIOD_STATS_FLAG_SATURATED;
+				}
+				else
+				{
+					sumDev -= (int64_t) absDev;
+				}
+			}
+			sqDev = absDev * absDev;
+			if(sqDev > (0xFFFFFFFFFFFFFFFFULL - sumSqDev))
+			{
+				sumSqDev = 0xFFFFFFFFFFFFFFFFULL;
+				flags |= ADI_PERIOD_STATS_FLAG_SATURATED;
+			}
+			else
+			{
+				sumSqDev += sqDev;
+			}
+
+			/* Update histogram */
+			if(numBins)
+			{
+				if(period < binStart)
+				{
+					underflow++;
+				}
+				else
+				{
+					bin = ((uint32_t) period - binStart) / binWidth;
+					if(bin >= numBins)
+						overflow++;
+					else
+						bins[bin]++;
+				}
+			}
+			periodCount++;
+		}
+		AdiEdgeCaptureEnd(&state);
+
+		/* Release the interrupt mask */
+		AdiGpioRouterUnmask();
+	}
+
+	if(periodCount == 0)
+		minPeriod = 0;
+
+	/* Populate bulk buffer with the statistics */
+	results[0] = periodCount;
+	results[1] = minPeriod;
+	results[2] = maxPeriod;
+	results[3] = refPeriod;
+	results[4] = (uint32_t) ((uint64_t) sumDev & 0xFFFFFFFF);
+	results[5] = (uint32_t) ((uint64_t) sumDev >> 32);
+	results[6] = (uint32_t) (sumSqDev & 0xFFFFFFFF);
+	results[7] = (uint32_t) (sumSqDev >> 32);
+	results[8] = underflow;
+	results[9] = overflow;
+	results[10] = flags;
+	for(i = 0; i < 11; i++)
+	{
+		BulkBuffer[4 + (i * 4)] = results[i] & 0xFF;
+		BulkBuffer[5 + (i * 4)] = (results[i] & 0xFF00) >> 8;
+		BulkBuffer[6 + (i * 4)] = (results[i] & 0xFF0000) >> 16;
+		BulkBuffer[7 + (i * 4)] = (results[i] & 0xFF000000) >> 24;
 	}
 
+	/* Send the data to PC */
+	AdiReturnBulkEndpointData(status, ADI_PERIOD_STATS_HEADER_LEN + (numBins * 4));
+
+	return status;
+}
+
+/**
+  * @brief configures the selected pin as an interrupt with edge triggering based on polarity
+  *
+  * @param polarity The edge to trigger on (true -> rising edge, false -> falling edge)
+  *
+  * @param pin The GPIO pin number to configure
+  *
+  * @return The success of the pin configuration operation.
+ **/
+CyU3PReturnStatus_t AdiConfigurePinInterrupt(uint16_t pin, CyBool_t polarity)
+{
+	return AdiConfigurePinEdgeInterrupt(pin, polarity ? CY_U3P_GPIO_INTR_POS_EDGE : CY_U3P_GPIO_INTR_NEG_EDGE);
+}
+
+/**
+  * @brief configures the selected pin as an input, with the selected interrupt mode
+  *
+  * @param pin The GPIO pin number to configure
+  *
+  * @param intrMode The interrupt mode (edge) to set
+  *
+  * @return The success of the pin configuration operation.
+ **/
+CyU3PReturnStatus_t AdiConfigurePinEdgeInterrupt(uint16_t pin, CyU3PGpioIntrMode_t intrMode)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PGpioSimpleConfig_t gpioConfig = {0};
+
+	/* Make sure the pin is configured as an input and attach the correct pin interrupt */
+	gpioConfig.outValue = CyTrue;
+	gpioConfig.inputEn = CyTrue;
+	gpioConfig.driveLowEn = CyFalse;
+	gpioConfig.driveHighEn = CyFalse;
+	gpioConfig.intrMode = intrMode;
+
 	status = CyU3PGpioSetSimpleConfig(pin, &gpioConfig);
 	if(status != CY_U3P_SUCCESS)
 	{
@@ -49,25 +49,82 @@ typedef enum PinState
 	HighZ = 2
 }PinState;
 
+/** Structure to track an edge timestamp capture on a pin */
+typedef struct EdgeCaptureState
+{
+	/** The pin being captured */
+	uint16_t Pin;
+
+	/** The extended timer value when the capture started */
+	uint64_t StartTime;
+
+	/** The last sampled time, in 10MHz timer ticks since the capture started */
+	uint64_t LastTime;
+
+	/** Exit the capture when a stream stop (KillStreamEarly) is requested. Only set for an edge capture stream */
+	CyBool_t StopOnStreamKill;
+}EdgeCaptureState;
+
 /* Function definitions */
 CyU3PReturnStatus_t AdiPulseDrive();
 CyU3PReturnStatus_t AdiPulseWait(uint16_t transferLength);
+CyU3PReturnStatus_t AdiPulseWaitRun(uint8_t * params, uint8_t * results, uint64_t startTime);
 CyU3PReturnStatus_t AdiSetPin(uint16_t pinNumber, CyBool_t polarity);
 CyU3PReturnStatus_t AdiMeasurePinFreq();
-CyU3PReturnStatus_t AdiWaitForPin(uint32_t pinNumber, CyU3PGpioIntrMode_t interruptSetting, uint32_t timeoutTicks);
+CyU3PReturnStatus_t AdiMeasurePinFreqRun(uint8_t * params, uint8_t * results);
+CyU3PReturnStatus_t AdiWaitForPin(uint32_t pinNumber, CyU3PGpioIntrMode_t interruptSetting, uint32_t timeoutMs);
 CyU3PReturnStatus_t AdiPinRead(uint16_t pin);
+CyU3PReturnStatus_t AdiReadPinValue(uint16_t pin, CyBool_t * pinValue);
 CyU3PReturnStatus_t AdiReadTimerValue();
 CyU3PReturnStatus_t AdiConfigurePWM(CyBool_t EnablePWM);
+CyU3PReturnStatus_t AdiConfigurePWMGroup(uint16_t transferLength);
 CyU3PReturnStatus_t AdiMeasureBusyPulse(uint16_t transferLength);
+CyU3PReturnStatus_t AdiMeasureBusyPulseRun(uint8_t * params, uint8_t * results);
 CyU3PReturnStatus_t AdiConfigurePinInterrupt(uint16_t pin, CyBool_t polarity);
+CyU3PReturnStatus_t AdiConfigurePinEdgeInterrupt(uint16_t pin, CyU3PGpioIntrMode_t intrMode);
+CyU3PReturnStatus_t AdiEdgeCaptureHandler(uint16_t transferLength);
+CyU3PReturnStatus_t AdiEdgeCaptureInit(EdgeCaptureState * state, uint16_t pin, uint8_t edge);
+uint32_t AdiEdgeCaptureRun(EdgeCaptureState * state, uint8_t * outBuf, uint32_t numEdges, uint64_t timeoutTicks);
+void AdiEdgeCaptureEnd(EdgeCaptureState * state);
+CyU3PReturnStatus_t AdiMeasurePinPeriodStats(uint16_t transferLength);
 CyU3PReturnStatus_t AdiMeasurePinDelay(uint16_t transferLength);
+CyU3PReturnStatus_t AdiMeasurePinDelayRun(uint8_t * params, uint8_t * results);
 CyU3PReturnStatus_t AdiSetPinResistor(uint16_t pin, PinResistorSetting setting);
 uint32_t AdiMStoTicks(uint32_t desiredStallTime);
 uint32_t AdiReadTimerRegValue();
+uint64_t AdiGetTicks64();
+void AdiTicks64ToBuffer(uint64_t ticks, uint8_t * outBuf);
+void AdiTimerRolloverHandler();
+void AdiTimerAcquire();
+void AdiTimerRelease();
 CyBool_t AdiIsValidGPIO(uint16_t GpioId);
 PinState AdiGetPinState(uint16_t pin);
 void AdiGetBoardPinInfo(uint8_t * outBuf);
 
+/** Size of a single edge timestamp record: 64-bit time since the capture started (timer value[0-3], timer rollovers[4-7]) */
+#define ADI_EDGE_RECORD_LEN						(8)
+
+/** Max number of edges captured in a single (non-stream) capture. Status and edge count fill the first 8 bytes of the bulk buffer */
+#define ADI_EDGE_CAPTURE_MAX_EDGES				((12288 - 8) / ADI_EDGE_RECORD_LEN)
+
+/** Number of bytes (status and statistics) ahead of the histogram bins in a period statistics response */
+#define ADI_PERIOD_STATS_HEADER_LEN				(48)
+
+/** Period statistics flag: the deviation sums saturated, so the mean and variance can not be computed from them */
+#define ADI_PERIOD_STATS_FLAG_SATURATED			(1 << 0)
+
+/** Max number of histogram bins in a period statistics measurement */
+#define ADI_PERIOD_STATS_MAX_BINS				(1024)
+
+/** Max number of channels in a phase aligned PWM group (one per complex GPIO block, less the timer block) */
+#define ADI_PWM_GROUP_MAX_CHANNELS				(7)
+
+/** Number of request bytes per PWM group channel: pin, period, threshold, phase delay */
+#define ADI_PWM_GROUP_CHANNEL_LEN				(14)
+
+/** Number of response bytes per PWM group channel: pin, achieved period, achieved threshold */
+#define ADI_PWM_GROUP_RESPONSE_LEN				(10)
+
 /*
  * GPIO Pin mapping definitions
  */
@@ -0,0 +1,477 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		PinJob.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Asynchronous (background) pin measurement jobs.
+  *
+  * The pin measurements (pulse wait, busy pulse, pin delay, data ready frequency) busy wait until
+  * the measured edge arrives or the timeout passes. Run as vendor commands they hold the control
+  * endpoint for the whole measurement, so a stuck DUT stalls the FX3 until the timeout.
+  *
+  * This module runs the same measurements as jobs. The host starts a job with an ID of its choosing,
+  * and the start command returns as soon as the job is queued. The jobs are executed in order by the
+  * low priority PinJobThread, and the host polls for the result by job ID. Several short measurements
+  * can be queued back to back, and the control endpoint stays free while they run.
+  *
+  * The job parameters and results use the same format as the blocking measurement commands. Each job
+  * carries its own parameter and result buffers, so jobs never touch USBBuffer / BulkBuffer.
+ **/
+
+#include "PinJob.h"
+
+/* Private function prototypes */
+static PinJob * AdiPinJobFind(uint16_t jobId);
+static CyU3PReturnStatus_t AdiPinJobStart(uint16_t jobId, uint16_t transferLength);
+static CyU3PReturnStatus_t AdiPinJobPoll(uint16_t jobId, uint16_t transferLength);
+static CyU3PReturnStatus_t AdiPinJobCancel(uint16_t jobId, uint16_t transferLength);
+static void AdiPinJobExecute(PinJob * job);
+
+/* Tell the compiler where to find the needed globals */
+extern uint8_t USBBuffer[4096];
+extern StreamState StreamThreadState;
+
+/** Job table */
+static PinJob Jobs[ADI_PIN_JOB_MAX_JOBS];
+
+/** Message queue of job table indexes for the PinJobThread */
+static CyU3PQueue JobQueue;
+
+/** Storage for the job queue (one 32-bit message per job) */
+static uint32_t JobQueueStorage[ADI_PIN_JOB_MAX_JOBS];
+
+/** Protects the job table. Only held briefly, never while a measurement runs */
+static CyU3PMutex JobLock;
+
+/** A pin measurement is running outside the job table (a deferred bulk command) */
+static volatile CyBool_t ExternalMeasureActive = CyFalse;
+
+/**
+  * @brief Entry point for the PinJobThread. Executes queued pin measurement jobs in the order started.
+  *
+  * @param input Unused
+  *
+  * @return void
+  *
+  * Also creates the queue and mutex used by the job table. The thread is started by the kernel at
+  * boot, well ahead of the USB enumeration which allows jobs to be started.
+ **/
+void AdiPinJobThreadEntry(uint32_t input)
+{
+	UNUSED(input);
+	CyU3PReturnStatus_t status;
+	uint32_t index;
+
+	status = CyU3PQueueCreate(&JobQueue, 1, JobQueueStorage, sizeof(JobQueueStorage));
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinJob_c, __LINE__, status);
+	}
+	status = CyU3PMutexCreate(&JobLock, CYU3P_NO_INHERIT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinJob_c, __LINE__, status);
+	}
+
+	for(;;)
+	{
+		if(CyU3PQueueReceive(&JobQueue, &index, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS)
+			continue;
+
+		if(index >= ADI_PIN_JOB_MAX_JOBS)
+			continue;
+
+		/* Free jobs which were cancelled while queued */
+		CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+		if(Jobs[index].State != PinJobQueued)
+		{
+			Jobs[index].State = PinJobFree;
+			CyU3PMutexPut(&JobLock);
+			continue;
+		}
+		Jobs[index].State = PinJobRunning;
+		CyU3PMutexPut(&JobLock);
+
+		AdiPinJobExecute(&Jobs[index]);
+	}
+}
+
+/**
+  * @brief Handler for the ADI_PIN_JOB vendor command
+  *
+  * @param action The job action (ADI_PIN_JOB_START, ADI_PIN_JOB_POLL, ADI_PIN_JOB_CANCEL). Passed in wIndex
+  *
+  * @param jobId The host assigned job ID. Passed in wValue
+  *
+  * @param transferLength The control transfer data length
+  *
+  * @return A status code indicating the success of the function. A failed start stalls the control endpoint.
+ **/
+CyU3PReturnStatus_t AdiPinJobHandler(uint16_t action, uint16_t jobId, uint16_t transferLength)
+{
+	switch(action)
+	{
+	case ADI_PIN_JOB_START:
+		return AdiPinJobStart(jobId, transferLength);
+	case ADI_PIN_JOB_POLL:
+		return AdiPinJobPoll(jobId, transferLength);
+	case ADI_PIN_JOB_CANCEL:
+		return AdiPinJobCancel(jobId, transferLength);
+	default:
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+}
+
+/**
+  * @brief Checks if any pin job is queued or running
+  *
+  * @return CyTrue if the PinJobThread has (or is about to start) a measurement, or a measurement
+  * claimed with AdiPinJobClaimMeasure is running
+  *
+  * The job table is only read, so this can be called without JobLock.
+ **/
+CyBool_t AdiPinJobBusy()
+{
+	int i;
+
+	if(ExternalMeasureActive)
+		return CyTrue;
+
+	for(i = 0; i < ADI_PIN_JOB_MAX_JOBS; i++)
+	{
+		if((Jobs[i].State == PinJobQueued) || (Jobs[i].State == PinJobRunning))
+			return CyTrue;
+	}
+	return CyFalse;
+}
+
+/**
+  * @brief Claims the pin measurement interlock for a measurement which runs outside the job table
+  *
+  * @return CY_U3P_SUCCESS if claimed (release with AdiPinJobReleaseMeasure), CY_U3P_ERROR_INVALID_SEQUENCE
+  * if a stream, pin job or other claimed measurement is running
+  *
+  * Used for the deferred bulk command pin measurements, so they get the same stream, router monitor
+  * and pin job exclusion (AdiPinJobBusy) as pin jobs.
+ **/
+CyU3PReturnStatus_t AdiPinJobClaimMeasure()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+	if(AdiPinJobBusy() || StreamThreadState.StreamActive || AdiGpioRouterStreamMasked())
+	{
+		status = CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+	else
+	{
+		ExternalMeasureActive = CyTrue;
+	}
+	CyU3PMutexPut(&JobLock);
+	return status;
+}
+
+/**
+  * @brief Releases the pin measurement interlock taken by AdiPinJobClaimMeasure
+  *
+  * @return void
+ **/
+void AdiPinJobReleaseMeasure()
+{
+	ExternalMeasureActive = CyFalse;
+}
+
+/**
+  * @brief Finds the job table entry for a job ID. Must be called with JobLock held
+  *
+  * @param jobId The job ID to search for
+  *
+  * @return The job, or NULL if no job with that ID is in the table
+ **/
+static PinJob * AdiPinJobFind(uint16_t jobId)
+{
+	int i;
+
+	for(i = 0; i < ADI_PIN_JOB_MAX_JOBS; i++)
+	{
+		if((Jobs[i].State != PinJobFree) && (Jobs[i].State != PinJobCancelled) && (Jobs[i].Id == jobId))
+			return &Jobs[i];
+	}
+	return NULL;
+}
+
+/**
+  * @brief Reads a job request from the control endpoint, and queues the job
+  *
+  * @param jobId The host assigned job ID. Must not match a job already in the table
+  *
+  * @param transferLength The request length. Formatted as opcode[0], then the measurement parameters
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The supported opcodes are ADI_PULSE_WAIT, ADI_BUSY_MEASURE, ADI_PIN_DELAY_MEASURE and ADI_MEASURE_DR.
+  * Busy pulse measurements must use a pin trigger. A SPI trigger would need the SPI bus, which is not
+  * available to the job thread. For pulse waits, the delay and timeout start when the job starts running.
+  * Jobs can't be started while a data stream or a deferred bulk command measurement is running (and
+  * streams can't be started while a job is queued or running).
+ **/
+static CyU3PReturnStatus_t AdiPinJobStart(uint16_t jobId, uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status;
+	uint8_t request[ADI_PIN_JOB_MAX_PARAMS + 1];
+	uint16_t bytesRead = 0;
+	uint16_t minLength;
+	uint32_t i;
+	PinJob * job;
+
+	if((transferLength < 1) || (transferLength > sizeof(request)))
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	status = CyU3PUsbGetEP0Data(transferLength, request, &bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(PinJob_c, __LINE__, status);
+		return status;
+	}
+
+	/* Check the request holds all the parameters for the measurement */
+	switch(request[0])
+	{
+	case ADI_PIN_DELAY_MEASURE:
+		minLength = 10;
+		break;
+	case ADI_MEASURE_DR:
+		minLength = 14;
+		break;
+	case ADI_PULSE_WAIT:
+		minLength = 16;
+		break;
+	case ADI_BUSY_MEASURE:
+		minLength = 16;
+		break;
+	default:
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	if(transferLength < minLength)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	/* Busy pulse measurements must use a pin trigger */
+	if((request[0] == ADI_BUSY_MEASURE) && request[8])
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	/* Jobs poll the pin interrupt bits (some with the GPIO vector masked), so can't run under a stream */
+	if(StreamThreadState.StreamActive || AdiGpioRouterStreamMasked())
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+
+	CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+
+	/* Deferred bulk command measurements poll the same pin interrupt bits */
+	if(ExternalMeasureActive)
+	{
+		CyU3PMutexPut(&JobLock);
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+
+	/* Job IDs must be unique within the table */
+	if(AdiPinJobFind(jobId) != NULL)
+	{
+		CyU3PMutexPut(&JobLock);
+		return CY_U3P_ERROR_ALREADY_STARTED;
+	}
+
+	/* Find a free slot */
+	job = NULL;
+	for(i = 0; i < ADI_PIN_JOB_MAX_JOBS; i++)
+	{
+		if(Jobs[i].State == PinJobFree)
+		{
+			job = &Jobs[i];
+			break;
+		}
+	}
+	if(job == NULL)
+	{
+		CyU3PMutexPut(&JobLock);
+		return CY_U3P_ERROR_QUEUE_FULL;
+	}
+
+	job->Id = jobId;
+	job->Opcode = request[0];
+	job->Status = CY_U3P_SUCCESS;
+	job->ResultLength = 0;
+	CyU3PMemSet(job->Params, 0, ADI_PIN_JOB_MAX_PARAMS);
+	CyU3PMemCopy(job->Params, request + 1, transferLength - 1);
+	CyU3PMemSet(job->Result, 0, ADI_PIN_JOB_MAX_RESULT);
+	job->State = PinJobQueued;
+
+	/* Each queued index holds a table slot until it is received, so the queue can't overflow */
+	status = CyU3PQueueSend(&JobQueue, &i, CYU3P_NO_WAIT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		job->State = PinJobFree;
+		AdiLogError(PinJob_c, __LINE__, status);
+	}
+
+	CyU3PMutexPut(&JobLock);
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "Pin job %d started, opcode 0x%x\r\n", jobId, request[0]);
+#endif
+
+	return status;
+}
+
+/**
+  * @brief Sends the state and result of a job to the PC over the control endpoint
+  *
+  * @param jobId The job ID to poll
+  *
+  * @param transferLength The control transfer data length. Should be ADI_PIN_JOB_POLL_LEN
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The response is formatted as status[0-3], job ID[4-5], state[6], result length[7], result[8-15].
+  * While the job is queued or running the status is CY_U3P_ERROR_NOT_STARTED. Once done, the status
+  * is the measurement status, and the job is freed. An unknown job ID gives state PinJobFree with
+  * status CY_U3P_ERROR_BAD_ARGUMENT.
+ **/
+static CyU3PReturnStatus_t AdiPinJobPoll(uint16_t jobId, uint16_t transferLength)
+{
+	CyU3PReturnStatus_t jobStatus;
+	PinJob * job;
+
+	CyU3PMemSet(USBBuffer, 0, ADI_PIN_JOB_POLL_LEN);
+	USBBuffer[4] = jobId & 0xFF;
+	USBBuffer[5] = (jobId & 0xFF00) >> 8;
+
+	CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+	job = AdiPinJobFind(jobId);
+	if(job == NULL)
+	{
+		jobStatus = CY_U3P_ERROR_BAD_ARGUMENT;
+		USBBuffer[6] = PinJobFree;
+	}
+	else if(job->State != PinJobDone)
+	{
+		jobStatus = CY_U3P_ERROR_NOT_STARTED;
+		USBBuffer[6] = job->State;
+	}
+	else
+	{
+		jobStatus = job->Status;
+		USBBuffer[6] = PinJobDone;
+		USBBuffer[7] = job->ResultLength;
+		CyU3PMemCopy(USBBuffer + 8, job->Result, job->ResultLength);
+		job->State = PinJobFree;
+	}
+	CyU3PMutexPut(&JobLock);
+
+	USBBuffer[0] = jobStatus & 0xFF;
+	USBBuffer[1] = (jobStatus & 0xFF00) >> 8;
+	USBBuffer[2] = (jobStatus & 0xFF0000) >> 16;
+	USBBuffer[3] = (jobStatus & 0xFF000000) >> 24;
+
+	if(transferLength > ADI_PIN_JOB_POLL_LEN)
+		transferLength = ADI_PIN_JOB_POLL_LEN;
+	return CyU3PUsbSendEP0Data(transferLength, USBBuffer);
+}
+
+/**
+  * @brief Cancels a queued job, and sends the status to the PC over the control endpoint
+  *
+  * @param jobId The job ID to cancel
+  *
+  * @param transferLength The control transfer data length
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Only queued jobs can be cancelled. A running job finishes when its measurement completes or
+  * times out. Cancelling a done job discards its result.
+ **/
+static CyU3PReturnStatus_t AdiPinJobCancel(uint16_t jobId, uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	PinJob * job;
+
+	CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+	job = AdiPinJobFind(jobId);
+	if(job == NULL)
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	else if(job->State == PinJobRunning)
+	{
+		status = CY_U3P_ERROR_ALREADY_STARTED;
+	}
+	else if(job->State == PinJobQueued)
+	{
+		/* The job thread frees the slot when it receives the index */
+		job->State = PinJobCancelled;
+	}
+	else
+	{
+		job->State = PinJobFree;
+	}
+	CyU3PMutexPut(&JobLock);
+
+	AdiSendStatus(status, transferLength, CyTrue);
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Runs a single job, and stores its result
+  *
+  * @param job The job to run. Must be in the running state
+  *
+  * @return void
+ **/
+static void AdiPinJobExecute(PinJob * job)
+{
+	CyU3PReturnStatus_t status;
+	uint8_t result[ADI_PIN_JOB_MAX_RESULT] = {0};
+	uint8_t resultLength;
+
+	switch(job->Opcode)
+	{
+	case ADI_PULSE_WAIT:
+		status = AdiPulseWaitRun(job->Params, result, AdiGetTicks64());
+		resultLength = 8;
+		break;
+	case ADI_BUSY_MEASURE:
+		status = AdiMeasureBusyPulseRun(job->Params, result);
+		resultLength = 4;
+		break;
+	case ADI_PIN_DELAY_MEASURE:
+		status = AdiMeasurePinDelayRun(job->Params, result);
+		resultLength = 8;
+		break;
+	case ADI_MEASURE_DR:
+		status = AdiMeasurePinFreqRun(job->Params, result);
+		resultLength = 8;
+		break;
+	default:
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		resultLength = 0;
+		break;
+	}
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "Pin job %d done, status 0x%x\r\n", job->Id, status);
+#endif
+
+	CyU3PMutexGet(&JobLock, CYU3P_WAIT_FOREVER);
+	CyU3PMemCopy(job->Result, result, resultLength);
+	job->ResultLength = resultLength;
+	job->Status = status;
+	job->State = PinJobDone;
+	CyU3PMutexPut(&JobLock);
+}
@@ -0,0 +1,102 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		PinJob.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the asynchronous (background) pin measurement jobs
+ **/
+
+#ifndef PINJOB_H_
+#define PINJOB_H_
+
+/* Include main */
+#include "main.h"
+
+/** Max number of pin measurement jobs which can be queued, running, or waiting to be read at once */
+#define ADI_PIN_JOB_MAX_JOBS					(8)
+
+/** Max number of measurement parameter bytes for a job */
+#define ADI_PIN_JOB_MAX_PARAMS					(16)
+
+/** Max number of result bytes for a job */
+#define ADI_PIN_JOB_MAX_RESULT					(8)
+
+/** Length of the job poll response. Formatted as status[0-3], job ID[4-5], state[6], result length[7], result[8-15] */
+#define ADI_PIN_JOB_POLL_LEN					(16)
+
+/** Job control action (wIndex): start a job. Data is opcode[0], then the measurement parameters */
+#define ADI_PIN_JOB_START						(0)
+
+/** Job control action (wIndex): read the state and result of a job. Done jobs are freed once read */
+#define ADI_PIN_JOB_POLL						(1)
+
+/** Job control action (wIndex): cancel a queued job. Returns status[0-3] */
+#define ADI_PIN_JOB_CANCEL						(2)
+
+/** PinJobThread allocated stack size (2KB) */
+#define PINJOBTHREAD_STACK						(0x0800)
+
+/** PinJobThread execution priority. Lower than the BulkCmdThread, so measurement jobs never hold up commands */
+#define PINJOBTHREAD_PRIORITY					(11)
+
+/** Pin measurement job states */
+typedef enum PinJobState
+{
+	/** Job slot is unused (or the job ID is not known) */
+	PinJobFree = 0,
+
+	/** Job is waiting for the job thread */
+	PinJobQueued = 1,
+
+	/** Job is executing */
+	PinJobRunning = 2,
+
+	/** Job is finished, and the result is ready to be read */
+	PinJobDone = 3,
+
+	/** Job was cancelled while queued. The slot is freed once the job thread drops it from the queue */
+	PinJobCancelled = 4
+}PinJobState;
+
+/** Structure to track a single pin measurement job */
+typedef struct PinJob
+{
+	/** Host assigned job ID */
+	uint16_t Id;
+
+	/** Measurement opcode (vendor command of the matching blocking measurement) */
+	uint8_t Opcode;
+
+	/** Current job state */
+	PinJobState State;
+
+	/** Measurement status code (valid once done) */
+	CyU3PReturnStatus_t Status;
+
+	/** Measurement parameters, in the same format as the blocking measurement request */
+	uint8_t Params[ADI_PIN_JOB_MAX_PARAMS];
+
+	/** Measurement result, in the same format as the blocking measurement response (less the status) */
+	uint8_t Result[ADI_PIN_JOB_MAX_RESULT];
+
+	/** Number of valid result bytes */
+	uint8_t ResultLength;
+}PinJob;
+
+/* Public function prototypes */
+void AdiPinJobThreadEntry(uint32_t input);
+CyU3PReturnStatus_t AdiPinJobHandler(uint16_t action, uint16_t jobId, uint16_t transferLength);
+CyBool_t AdiPinJobBusy();
+CyU3PReturnStatus_t AdiPinJobClaimMeasure();
+void AdiPinJobReleaseMeasure();
+
+#endif /* PINJOB_H_ */
@@ -0,0 +1,284 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		RegCache.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Shadow cache of 16 bit DUT registers, keyed by page and address.
+  *
+  * The cache is disabled at boot. When enabled, register reads through AdiReadRegBytes
+  * are returned from the cache (without any SPI traffic) for registers which the host
+  * has flagged as cacheable and which have a valid cached value. Cached values are
+  * populated by reads, and kept coherent by writes through AdiWriteRegByte (write-through).
+  * All registers are volatile (never cached) until flagged otherwise by the host.
+  *
+  * The current DUT page is tracked from writes and reads of the page ID register. Any
+  * operation which can change DUT register contents or the page without going through the
+  * cache (streams, raw SPI transfers, DUT reset, DUT power cycle) invalidates the cache and
+  * marks the current page as unknown. No cache hits occur until the page is known again.
+ **/
+
+#include "RegCache.h"
+
+/* Tell the compiler where to find the needed globals */
+extern BoardState FX3State;
+extern uint8_t USBBuffer[4096];
+
+/** Cached register values */
+static uint16_t CacheValues[ADI_REG_CACHE_NUM_PAGES][ADI_REG_CACHE_WORDS_PER_PAGE];
+
+/** Bit map of registers which hold a valid cached value */
+static uint8_t CacheValid[ADI_REG_CACHE_NUM_PAGES][ADI_REG_CACHE_FLAG_BYTES];
+
+/** Bit map of registers which the host has flagged as cacheable */
+static uint8_t CacheFlags[ADI_REG_CACHE_NUM_PAGES][ADI_REG_CACHE_FLAG_BYTES];
+
+/** Track if the register cache is enabled */
+static CyBool_t CacheEnabled = CyFalse;
+
+/** Current DUT page */
+static uint16_t CurrentPage = 0;
+
+/** Track if the current DUT page is known */
+static CyBool_t CurrentPageValid = CyFalse;
+
+/** Status of the last ADI_REG_CACHE_SET_FLAGS command */
+static CyU3PReturnStatus_t FlagsStatus = CY_U3P_SUCCESS;
+
+/**
+  * @brief Gets the current DUT page, if it can be cached.
+  *
+  * @param page Output for the current page
+  *
+  * @return CyTrue if the current page is known and within the cached page range
+ **/
+static CyBool_t AdiRegCacheGetPage(uint16_t * page)
+{
+	/* Legacy IMU products are not paged */
+	if(FX3State.DutType == LegacyIMU)
+	{
+		*page = 0;
+		return CyTrue;
+	}
+	*page = CurrentPage;
+	return (CurrentPageValid && (CurrentPage < ADI_REG_CACHE_NUM_PAGES));
+}
+
+/**
+  * @brief Invalidates all cached register values, and marks the current DUT page as unknown.
+  *
+  * @return void
+  *
+  * Must be called whenever DUT register contents may have changed without passing through
+  * the cache (DUT reset, streams, raw SPI transfers, etc).
+ **/
+void AdiRegCacheInvalidate()
+{
+	CyU3PMemSet((uint8_t *) CacheValid, 0, sizeof(CacheValid));
+	CurrentPageValid = CyFalse;
+}
+
+/**
+  * @brief Looks up a register value in the cache.
+  *
+  * @param addr The register address being read
+  *
+  * @param value Output for the cached register value
+  *
+  * @return CyTrue for a cache hit, CyFalse if the register must be read over SPI
+ **/
+CyBool_t AdiRegCacheRead(uint16_t addr, uint16_t * value)
+{
+	uint16_t page, word;
+
+	if(!CacheEnabled)
+		return CyFalse;
+
+	if(!AdiRegCacheGetPage(&page))
+		return CyFalse;
+
+	word = (addr & 0x7F) >> 1;
+	if((CacheFlags[page][word >> 3] & CacheValid[page][word >> 3]) & (1 << (word & 0x7)))
+	{
+		*value = CacheValues[page][word];
+		return CyTrue;
+	}
+	return CyFalse;
+}
+
+/**
+  * @brief Stores a register value read over SPI.
+  *
+  * @param addr The register address which was read
+  *
+  * @param value The value read from the DUT
+  *
+  * @return void
+  *
+  * The value is only cached if the register is flagged as cacheable. Reads of the page
+  * ID register always update the tracked DUT page.
+ **/
+void AdiRegCacheStoreRead(uint16_t addr, uint16_t value)
+{
+	uint16_t page, word;
+
+	addr &= 0x7F;
+
+	/* Reading the page register re-synchronizes the tracked page */
+	if((addr == ADI_PAGE_ID_ADDR) && (FX3State.DutType != LegacyIMU))
+	{
+		CurrentPage = value & 0xFF;
+		CurrentPageValid = CyTrue;
+	}
+
+	if(!CacheEnabled)
+		return;
+
+	if(!AdiRegCacheGetPage(&page))
+		return;
+
+	word = addr >> 1;
+	if(CacheFlags[page][word >> 3] & (1 << (word & 0x7)))
+	{
+		CacheValues[page][word] = value;
+		CacheValid[page][word >> 3] |= (1 << (word & 0x7));
+	}
+}
+
+/**
+  * @brief Applies a register byte write to the cache (write-through).
+  *
+  * @param addr The register address written (even address is the lower byte, odd address is the upper byte)
+  *
+  * @param data The byte written
+  *
+  * @return void
+  *
+  * Page ID register writes always update the tracked DUT page. Writes to registers with a
+  * valid cached value update the corresponding byte of the cached value.
+ **/
+void AdiRegCacheWrite(uint16_t addr, uint8_t data)
+{
+	uint16_t page, word;
+
+	addr &= 0x7F;
+
+	/* Page register write */
+	if((addr == ADI_PAGE_ID_ADDR) && (FX3State.DutType != LegacyIMU))
+	{
+		CurrentPage = data;
+		CurrentPageValid = CyTrue;
+		return;
+	}
+
+	if(!AdiRegCacheGetPage(&page))
+		return;
+
+	word = addr >> 1;
+	if(CacheValid[page][word >> 3] & (1 << (word & 0x7)))
+	{
+		if(addr & 0x1)
+		{
+			CacheValues[page][word] = (CacheValues[page][word] & 0x00FF) | (data << 8);
+		}
+		else
+		{
+			CacheValues[page][word] = (CacheValues[page][word] & 0xFF00) | data;
+		}
+	}
+}
+
+/**
+  * @brief Handles the register cache vendor command.
+  *
+  * @param index The wIndex from the control endpoint transaction (cache command)
+  *
+  * @param value The wValue from the control endpoint transaction
+  *
+  * @param length The length of the control endpoint data phase
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * ADI_REG_CACHE_ENABLE: wValue = 1 enables the cache, 0 disables it. Status is returned over the control endpoint.
+  * ADI_REG_CACHE_INVALIDATE: Invalidates all cached values. Status is returned over the control endpoint.
+  * ADI_REG_CACHE_SET_FLAGS: The data phase contains one or more 9 byte records, formatted as
+  * page[0], cacheable bit map[1-8] (bit n = register address 2n, LSB first). The data phase is host to device, so
+  * the status is saved, and is read back over the control endpoint with ADI_REG_CACHE_FLAGS_STATUS.
+  * ADI_REG_CACHE_FLAGS_STATUS: Returns the status of the last ADI_REG_CACHE_SET_FLAGS over the control endpoint.
+ **/
+CyU3PReturnStatus_t AdiRegCacheHandler(uint16_t index, uint16_t value, uint16_t length)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t *bytesRead = 0;
+	uint16_t recordIndex, page;
+
+	switch(index)
+	{
+	case ADI_REG_CACHE_ENABLE:
+		CacheEnabled = (CyBool_t) (value != 0);
+		AdiRegCacheInvalidate();
+		AdiSendStatus(status, length, CyTrue);
+		break;
+
+	case ADI_REG_CACHE_INVALIDATE:
+		AdiRegCacheInvalidate();
+		AdiSendStatus(status, length, CyTrue);
+		break;
+
+	case ADI_REG_CACHE_SET_FLAGS:
+		/* Too long to receive, so stall the request */
+		if(length > sizeof(USBBuffer))
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			AdiLogError(RegCache_c, __LINE__, status);
+			FlagsStatus = status;
+			break;
+		}
+		status = CyU3PUsbGetEP0Data(length, USBBuffer, bytesRead);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(RegCache_c, __LINE__, status);
+			FlagsStatus = status;
+			break;
+		}
+		for(recordIndex = 0; (recordIndex + ADI_REG_CACHE_FLAG_BYTES) < length; recordIndex += (ADI_REG_CACHE_FLAG_BYTES + 1))
+		{
+			page = USBBuffer[recordIndex];
+			if(page >= ADI_REG_CACHE_NUM_PAGES)
+			{
+				status = CY_U3P_ERROR_BAD_ARGUMENT;
+				continue;
+			}
+			CyU3PMemCopy(CacheFlags[page], USBBuffer + recordIndex + 1, ADI_REG_CACHE_FLAG_BYTES);
+			/* Drop any values which are no longer cacheable */
+			CyU3PMemSet(CacheValid[page], 0, ADI_REG_CACHE_FLAG_BYTES);
+		}
+		/* The data phase is complete, so the status is read back with ADI_REG_CACHE_FLAGS_STATUS */
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(RegCache_c, __LINE__, status);
+		}
+		FlagsStatus = status;
+		status = CY_U3P_SUCCESS;
+		break;
+
+	case ADI_REG_CACHE_FLAGS_STATUS:
+		AdiSendStatus(FlagsStatus, length, CyTrue);
+		break;
+
+	default:
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiSendStatus(status, length, CyTrue);
+		break;
+	}
+
+	return status;
+}
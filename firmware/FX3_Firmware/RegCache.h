@@ -0,0 +1,55 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		RegCache.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the DUT register shadow cache
+ **/
+
+#ifndef REGCACHE_H_
+#define REGCACHE_H_
+
+/* Include main */
+#include "main.h"
+
+/* Public function prototypes */
+void AdiRegCacheInvalidate();
+CyBool_t AdiRegCacheRead(uint16_t addr, uint16_t * value);
+void AdiRegCacheStoreRead(uint16_t addr, uint16_t value);
+void AdiRegCacheWrite(uint16_t addr, uint8_t data);
+CyU3PReturnStatus_t AdiRegCacheHandler(uint16_t index, uint16_t value, uint16_t length);
+
+/** Number of DUT register pages which can be cached. Pages above this are never cached */
+#define ADI_REG_CACHE_NUM_PAGES					(32)
+
+/** Number of 16 bit registers per DUT page (7 bit byte address) */
+#define ADI_REG_CACHE_WORDS_PER_PAGE			(64)
+
+/** Number of bytes in the per page cacheable/valid bit maps */
+#define ADI_REG_CACHE_FLAG_BYTES				(ADI_REG_CACHE_WORDS_PER_PAGE / 8)
+
+/** DUT page ID register address */
+#define ADI_PAGE_ID_ADDR						(0x00)
+
+/** Register cache command (wIndex) to enable (wValue = 1) or disable (wValue = 0) the cache */
+#define ADI_REG_CACHE_ENABLE					(0)
+
+/** Register cache command (wIndex) to invalidate all cached register values */
+#define ADI_REG_CACHE_INVALIDATE				(1)
+
+/** Register cache command (wIndex) to set the cacheable flags for one or more pages */
+#define ADI_REG_CACHE_SET_FLAGS					(2)
+
+/** Register cache command (wIndex) to read the status of the last ADI_REG_CACHE_SET_FLAGS command */
+#define ADI_REG_CACHE_FLAGS_STATUS				(3)
+
+#endif /* REGCACHE_H_ */
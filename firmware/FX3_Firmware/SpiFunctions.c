@@ -19,16 +19,16 @@
 #include "SpiFunctions.h"
 
 /* Private function prototypes */
-static void AdiBitBangSpiTransferCPHA0(uint8_t * MOSI, uint8_t* MISO, uint32_t BitCount, BitBangSpiConf config);
-static void AdiBitBangSpiTransferCPHA1(uint8_t * MOSI, uint8_t* MISO, uint32_t BitCount, BitBangSpiConf config);
-static CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config);
+static void AdiBitBangSpiTransferCPHA0(uint8_t * MOSI, uint8_t* MISO, uint32_t BitOffset, uint32_t BitCount, BitBangSpiConf config);
+static void AdiBitBangSpiTransferCPHA1(uint8_t * MOSI, uint8_t* MISO, uint32_t BitOffset, uint32_t BitCount, BitBangSpiConf config);
+static inline void AdiBitBangHalfClock(uint32_t loopCount);
+static void AdiBitBangDelay(uint32_t count);
 static void AdiWaitForSpiNotBusy();
 
 /* Tell the compiler where to find the needed globals */
 extern BoardState FX3State;
 extern StreamState StreamThreadState;
 extern CyU3PDmaBuffer_t ManualDMABuffer;
-extern CyU3PDmaChannel ChannelToPC;
 extern uint8_t USBBuffer[4096];
 extern uint8_t BulkBuffer[12288];
 
@@ -53,33 +53,54 @@ static uint32_t SCLKInactiveMask;
 /** SCLK low period offset */
 static uint32_t SCLKLowTime;
 
+/** Track if bit bang SPI edges are timed from the 10MHz complex GPIO timer */
+static CyBool_t BitBangTimerClocked;
+
+/** Bit bang SCLK half period, in 10MHz timer ticks (timer clocked mode only) */
+static uint32_t BitBangHalfPeriodTicks;
+
+/** Word length (in bytes) latched when a SPI streaming session is started */
+static uint8_t SessionWordLen;
+
+/** SPI interrupt mask saved while a SPI streaming session is active */
+static uint32_t SessionIntrMask;
+
 /**
-  * @brief Bi-directional SPI transfer function, in register mode. Optimized for speed.
+  * @brief Starts a register mode SPI streaming session.
   *
   * @return void
   *
-  * This function is used to allow for a reduced SPI stall time. Is fairly "unsafe" in that
-  * all hardware has to be configured for correct operation, and free, before this function
-  * can be called.
+  * This function performs the per-transfer setup work (FIFO clear, TX/RX enable, SPI block enable)
+  * once, so that any number of words can then be pushed back to back using AdiSpiStreamTransferWord.
+  * The session must be closed with AdiSpiStreamSessionEnd before the SPI controller is used
+  * through the Cypress API again. Like AdiSpiTransferWord, this is fairly "unsafe" in that the
+  * SPI controller must be configured and free before a session is started.
+  *
+  * Removing the FIFO clear and block enable/disable from each word shortens the minimum
+  * gap between back to back words by roughly the time the controller needs to drain and
+  * re-arm (a fixed number of CPU cycles). This saving has not been measured on hardware.
+  * For reference, the 16 bit word time alone (calculated from SCLK, not measured) is 8us
+  * at 2MHz, 2us at 8MHz and approx. 1.07us at 15MHz, so the fixed overhead removed here
+  * matters most at the higher SCLK settings.
  **/
-void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
+void AdiSpiStreamSessionStart()
 {
-    uint32_t temp, intrMask;
-    uint8_t  wordLen;
-
     /* Get the wordLen in bytes. Min. 1 byte */
-    wordLen = ((SPI->lpp_spi_config & CY_U3P_LPP_SPI_WL_MASK) >> CY_U3P_LPP_SPI_WL_POS);
-    if ((wordLen & 0x07) != 0)
+    SessionWordLen = ((SPI->lpp_spi_config & CY_U3P_LPP_SPI_WL_MASK) >> CY_U3P_LPP_SPI_WL_POS);
+    if ((SessionWordLen & 0x07) != 0)
     {
-        wordLen = (wordLen >> 3) + 1;
+        SessionWordLen = (SessionWordLen >> 3) + 1;
     }
     else
     {
-        wordLen = (wordLen >> 3);
+        SessionWordLen = (SessionWordLen >> 3);
     }
 
+    /* Wait for any previous transaction to finish */
+    AdiWaitForSpiNotBusy();
+
     /* Disable interrupts. */
-    intrMask = SPI->lpp_spi_intr_mask;
+    SessionIntrMask = SPI->lpp_spi_intr_mask;
     SPI->lpp_spi_intr_mask = 0;
 
     /* Reset SPI FIFO */
@@ -95,12 +116,29 @@ void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
     /* Enable the TX and RX bits. */
     SPI->lpp_spi_config |= CY_U3P_LPP_SPI_TX_ENABLE | CY_U3P_LPP_SPI_RX_ENABLE;
 
-    /* Re-enable SPI block. */
+    /* Enable SPI block. */
     SPI->lpp_spi_config |= CY_U3P_LPP_SPI_ENABLE;
+}
+
+/**
+  * @brief Transfers a single word within an active SPI streaming session.
+  *
+  * @param txBuf Pointer to the data to place in the SPI egress register (1 - 4 bytes, based on word length)
+  *
+  * @param rxBuf Pointer to the buffer to place the SPI ingress data in
+  *
+  * @return void
+  *
+  * This function only writes the egress register, waits for the received word, and reads the ingress
+  * register. AdiSpiStreamSessionStart must be called first.
+ **/
+void AdiSpiStreamTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
+{
+    uint32_t temp;
 
     /* Place data in egress register */
     temp = 0;
-    switch (wordLen)
+    switch (SessionWordLen)
     {
         case 4:
             temp |= (txBuf[3] << 24);
@@ -117,14 +155,14 @@ void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
     }
     SPI->lpp_spi_egress_data = temp;
 
-    /* Wait for tx/rx done interrupt */
+    /* Wait for tx/rx done */
     while ((SPI->lpp_spi_status & (CY_U3P_LPP_SPI_RX_DATA | CY_U3P_LPP_SPI_TX_SPACE)) != (CY_U3P_LPP_SPI_RX_DATA | CY_U3P_LPP_SPI_TX_SPACE));
 
     /* Get ingress data */
     temp = SPI->lpp_spi_ingress_data;
 
     /* Apply to buffer */
-    switch (wordLen)
+    switch (SessionWordLen)
     {
         case 4:
         	/* Word length of 4 bytes */
@@ -143,18 +181,50 @@ void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
             rxBuf[0] = (uint8_t)(temp & 0xFF);
             break;
     }
+}
+
+/**
+  * @brief Ends a register mode SPI streaming session.
+  *
+  * @return void
+  *
+  * Disables TX/RX and the SPI block, clears the SPI interrupts, and restores the interrupt mask
+  * saved by AdiSpiStreamSessionStart. The SPI controller can be used through the Cypress API again
+  * after this function returns.
+ **/
+void AdiSpiStreamSessionEnd()
+{
+    /* Wait for the last word to finish */
+    AdiWaitForSpiNotBusy();
 
     /* Disable the TX and RX. */
     SPI->lpp_spi_config &= ~(CY_U3P_LPP_SPI_TX_ENABLE | CY_U3P_LPP_SPI_RX_ENABLE);
 
     /* Clear all interrupts and restore interrupt mask. */
     SPI->lpp_spi_intr |= (CY_U3P_LPP_SPI_TX_DONE | CY_U3P_LPP_SPI_RX_DATA);
-    SPI->lpp_spi_intr_mask = intrMask;
+    SPI->lpp_spi_intr_mask = SessionIntrMask;
 
     /* Disable SPI block */
     SPI->lpp_spi_config &= ~(CY_U3P_LPP_SPI_ENABLE);
 }
 
+/**
+  * @brief Bi-directional SPI transfer function, in register mode. Optimized for speed.
+  *
+  * @return void
+  *
+  * This function is used to allow for a reduced SPI stall time. Is fairly "unsafe" in that
+  * all hardware has to be configured for correct operation, and free, before this function
+  * can be called. For multiple back to back words, use a SPI streaming session instead
+  * (AdiSpiStreamSessionStart) to avoid the per-word setup and tear down.
+ **/
+void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf)
+{
+    AdiSpiStreamSessionStart();
+    AdiSpiStreamTransferWord(txBuf, rxBuf);
+    AdiSpiStreamSessionEnd();
+}
+
 /**
   * @brief This function restarts the SPI controller.
   *
@@ -192,108 +262,233 @@ CyU3PReturnStatus_t AdiRestartSpi()
 /**
   * @brief This function handles bit bang SPI requests from the control endpoint.
   *
+  * @param flags Bit bang SPI option flags (wIndex from the control endpoint request).
+  *
+  * @param transferLength The number of bytes received in the control endpoint data phase.
+  *
   * @returns A status code indicating the success of the SPI bitbang operation.
   *
   * This function requires all data to have been retrieved from the control endpoint before being
   * called. It parses all the parameters about the current bit bang SPI operation to perform from
   * the transaction. The pins/timing/config is sent from the FX3 API to the firmware with each
   * bitbang SPI transaction.
+  *
+  * The bit bang engine operates on packed data (8 bits per byte, MSB first, as one continuous bit
+  * stream across all transfers). If ADI_BITBANG_FLAG_PACKED is set, the MOSI data is received and
+  * the MISO data is returned in this packed format. Otherwise, the legacy format (one byte per bit for
+  * MOSI, one GPIO register sample per bit for MISO) is used, and is packed/unpacked in place.
+  *
+  * If ADI_BITBANG_FLAG_TIMER is set, all SCLK edges are derived from the 10MHz complex GPIO timer, and
+  * the half clock, CS lead, CS lag and stall times are interpreted as timer ticks. Otherwise, the
+  * timings are busy wait loop counts.
  **/
-CyU3PReturnStatus_t AdiBitBangSpiHandler()
+CyU3PReturnStatus_t AdiBitBangSpiHandler(uint16_t flags, uint16_t transferLength)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t dmaStatus;
 	BitBangSpiConf config = {0};
-	uint32_t bitsPerTransfer;
-	uint32_t numTransfers;
-	uint32_t transferCounter;
-	uint32_t bitBangStallTime;
-	register uvint32_t cycleTimer;
+	uint32_t totalBits;
+	uint32_t maxBits;
+	uint32_t bitIndex;
+	CyBool_t packed;
 
 	/* Buffer pointers */
 	uint8_t * MOSIPtr;
-	uint8_t * MISOPtr;
 
 	/* Parse data from the USB buffer */
-	config.SCLK = USBBuffer[0];
-	config.CS = USBBuffer[1];
-	config.MOSI = USBBuffer[2];
-	config.MISO = USBBuffer[3];
-	config.HalfClockDelay = USBBuffer[4];
-	config.HalfClockDelay |= (USBBuffer[5] << 8);
-	config.HalfClockDelay |= (USBBuffer[6] << 16);
-	config.HalfClockDelay |= (USBBuffer[7] << 24);
-	config.CSLeadDelay = USBBuffer[8];
-	config.CSLeadDelay |= (USBBuffer[9] << 8);
-	config.CSLagDelay = USBBuffer[10];
-	config.CSLagDelay |= (USBBuffer[11] << 8);
-	bitBangStallTime = USBBuffer[12];
-	bitBangStallTime |= (USBBuffer[13] << 8);
-	bitBangStallTime |= (USBBuffer[14] << 16);
-	bitBangStallTime |= (USBBuffer[15] << 24);
-	config.CPHA = USBBuffer[16];
-	config.CPOL = USBBuffer[17];
-	bitsPerTransfer = USBBuffer[18];
-	bitsPerTransfer |= (USBBuffer[19] << 8);
-	bitsPerTransfer |= (USBBuffer[20] << 16);
-	bitsPerTransfer |= (USBBuffer[21] << 24);
-	numTransfers = USBBuffer[22];
-	numTransfers |= (USBBuffer[23] << 8);
-	numTransfers |= (USBBuffer[24] << 16);
-	numTransfers |= (USBBuffer[25] << 24);
-
-	/* apply offset to stall */
-	if(bitBangStallTime > STALL_COUNT_OFFSET)
-		bitBangStallTime -= STALL_COUNT_OFFSET;
+	AdiBitBangSpiParseConfig(USBBuffer, flags, &config);
+
+	packed = (CyBool_t) ((flags & ADI_BITBANG_FLAG_PACKED) != 0);
+
+	/* Validate the transaction size against the packed buffer sizes */
+	totalBits = config.BitsPerTransfer * config.NumTransfers;
+	if(packed)
+	{
+		maxBits = (transferLength - ADI_BITBANG_HEADER_LEN) * 8;
+		if(maxBits > (sizeof(BulkBuffer) * 8))
+			maxBits = sizeof(BulkBuffer) * 8;
+	}
 	else
-		bitBangStallTime = 0;
+	{
+		/* Legacy MISO data is returned one byte per bit */
+		maxBits = transferLength - ADI_BITBANG_HEADER_LEN;
+		if(maxBits > sizeof(BulkBuffer))
+			maxBits = sizeof(BulkBuffer);
+	}
+	if((transferLength < ADI_BITBANG_HEADER_LEN) || (config.BitsPerTransfer == 0) || (config.NumTransfers > (maxBits / config.BitsPerTransfer)))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		totalBits = 0;
+		config.NumTransfers = 0;
+	}
 
 	/* Memclear the bulk buffer */
 	CyU3PMemSet (BulkBuffer, 0, sizeof(BulkBuffer));
 
-	/* Start MISO pointer at bulk buffer */
-	MISOPtr = BulkBuffer;
-
-	/* Start MOSI pointer at USBBuffer[26], first transmit data bit */
-	MOSIPtr = USBBuffer;
-	MOSIPtr += 26;
+	/* Start MOSI pointer at USBBuffer[26], first transmit data byte */
+	MOSIPtr = USBBuffer + ADI_BITBANG_HEADER_LEN;
 
-	/* Setup the GPIO selected */
-	status = AdiBitBangSpiSetup(config);
-	if(status == CY_U3P_SUCCESS)
+	/* Pack legacy MOSI data in place (packed index never passes the unpacked index) */
+	if(!packed)
 	{
-		/* Perform transfers */
-		for(transferCounter = 0; transferCounter < numTransfers; transferCounter++)
+		for(bitIndex = 0; bitIndex < totalBits; bitIndex++)
 		{
-			/* Transfer data */
-			if(config.CPHA)
-				AdiBitBangSpiTransferCPHA1(MOSIPtr, MISOPtr, bitsPerTransfer, config);
+			if(bitIndex & 0x7)
+				MOSIPtr[bitIndex >> 3] |= (MOSIPtr[bitIndex] & 0x1) << (7 - (bitIndex & 0x7));
 			else
-				AdiBitBangSpiTransferCPHA0(MOSIPtr, MISOPtr, bitsPerTransfer, config);
-			/* Update buffer pointers */
-			MOSIPtr += bitsPerTransfer;
-			MISOPtr += bitsPerTransfer;
-			/* Wait for stall time */
-			cycleTimer = bitBangStallTime;
-			while(cycleTimer > 0)
-				cycleTimer--;
+				MOSIPtr[bitIndex >> 3] = (MOSIPtr[bitIndex] & 0x1) << 7;
 		}
 	}
 
+	/* Bit bang transfers bypass the register cache */
+	AdiRegCacheInvalidate();
+
+	/* Setup the GPIO selected, then perform transfers */
+	if(status == CY_U3P_SUCCESS)
+		status = AdiBitBangSpiSetup(config);
+	if(status == CY_U3P_SUCCESS)
+		AdiBitBangSpiRun(MOSIPtr, BulkBuffer, &config);
+	AdiBitBangSpiEnd();
+
 	/* Return MISO data over bulk buffer */
 	ManualDMABuffer.buffer = BulkBuffer;
 	ManualDMABuffer.size = sizeof(BulkBuffer);
-	ManualDMABuffer.count = numTransfers * bitsPerTransfer;
+	if(packed)
+	{
+		ManualDMABuffer.count = (totalBits + 7) >> 3;
+	}
+	else
+	{
+		/* Unpack in place, from the end of the bit stream, to the legacy GPIO input value format */
+		bitIndex = totalBits;
+		while(bitIndex > 0)
+		{
+			bitIndex--;
+			BulkBuffer[bitIndex] = ((BulkBuffer[bitIndex >> 3] >> (7 - (bitIndex & 0x7))) & 0x1) << 1;
+		}
+		ManualDMABuffer.count = totalBits;
+	}
+
+	/* Always send at least one byte so the host transfer completes */
+	if(ManualDMABuffer.count == 0)
+		ManualDMABuffer.count = 1;
 
 	/* Send the data to PC */
-	status = CyU3PDmaChannelSetupSendBuffer(&ChannelToPC, &ManualDMABuffer);
-	if(status != CY_U3P_SUCCESS)
+	dmaStatus = AdiBulkCmdSendData(&ManualDMABuffer);
+	if(dmaStatus != CY_U3P_SUCCESS)
 	{
-		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiLogError(SpiFunctions_c, __LINE__, dmaStatus);
+		status = dmaStatus;
 	}
 
 	return status;
 }
 
+/**
+  * @brief Parses a bit bang SPI configuration header (ADI_BITBANG_HEADER_LEN bytes).
+  *
+  * @param params Pointer to the start of the configuration header.
+  *
+  * @param flags Bit bang SPI option flags (ADI_BITBANG_FLAG_x).
+  *
+  * @param config Output for the parsed configuration.
+  *
+  * @return void
+  *
+  * The header is formatted as SCLK[0], CS[1], MOSI[2], MISO[3], HalfClock[4-7], CSLead[8-9], CSLag[10-11],
+  * Stall[12-15], CPHA[16], CPOL[17], BitsPerTransfer[18-21], NumTransfers[22-25].
+ **/
+void AdiBitBangSpiParseConfig(uint8_t * params, uint16_t flags, BitBangSpiConf * config)
+{
+	config->SCLK = params[0];
+	config->CS = params[1];
+	config->MOSI = params[2];
+	config->MISO = params[3];
+	config->HalfClockDelay = params[4];
+	config->HalfClockDelay |= (params[5] << 8);
+	config->HalfClockDelay |= (params[6] << 16);
+	config->HalfClockDelay |= (params[7] << 24);
+	config->CSLeadDelay = params[8];
+	config->CSLeadDelay |= (params[9] << 8);
+	config->CSLagDelay = params[10];
+	config->CSLagDelay |= (params[11] << 8);
+	config->StallDelay = params[12];
+	config->StallDelay |= (params[13] << 8);
+	config->StallDelay |= (params[14] << 16);
+	config->StallDelay |= (params[15] << 24);
+	config->CPHA = params[16];
+	config->CPOL = params[17];
+	config->BitsPerTransfer = params[18];
+	config->BitsPerTransfer |= (params[19] << 8);
+	config->BitsPerTransfer |= (params[20] << 16);
+	config->BitsPerTransfer |= (params[21] << 24);
+	config->NumTransfers = params[22];
+	config->NumTransfers |= (params[23] << 8);
+	config->NumTransfers |= (params[24] << 16);
+	config->NumTransfers |= (params[25] << 24);
+	config->TimerClocked = (CyBool_t) ((flags & ADI_BITBANG_FLAG_TIMER) != 0);
+
+	/* apply offset to stall (loop timed mode only) */
+	if(!config->TimerClocked)
+	{
+		if(config->StallDelay > STALL_COUNT_OFFSET)
+			config->StallDelay -= STALL_COUNT_OFFSET;
+		else
+			config->StallDelay = 0;
+	}
+}
+
+/**
+  * @brief Performs all the transfers in a bit bang SPI transaction. AdiBitBangSpiSetup must be called first.
+  *
+  * @param MOSI Pointer to the packed MOSI data (one continuous bit stream across all transfers).
+  *
+  * @param MISO Pointer to the packed MISO data output buffer. Must hold (BitsPerTransfer * NumTransfers + 7) / 8 bytes.
+  *
+  * @param config The bit bang SPI configuration.
+  *
+  * @return void
+  *
+  * Each transfer is followed by the configured stall time.
+ **/
+void AdiBitBangSpiRun(uint8_t * MOSI, uint8_t * MISO, BitBangSpiConf * config)
+{
+	uint32_t transferCounter;
+	uint32_t bitOffset = 0;
+
+	for(transferCounter = 0; transferCounter < config->NumTransfers; transferCounter++)
+	{
+		/* Transfer data */
+		if(config->CPHA)
+			AdiBitBangSpiTransferCPHA1(MOSI + (bitOffset >> 3), MISO + (bitOffset >> 3), bitOffset & 0x7, config->BitsPerTransfer, *config);
+		else
+			AdiBitBangSpiTransferCPHA0(MOSI + (bitOffset >> 3), MISO + (bitOffset >> 3), bitOffset & 0x7, config->BitsPerTransfer, *config);
+		/* Update bit stream position */
+		bitOffset += config->BitsPerTransfer;
+		/* Wait for stall time */
+		AdiBitBangDelay(config->StallDelay);
+	}
+}
+
+/**
+  * @brief Releases the resources used by a bit bang SPI transaction.
+  *
+  * @return void
+  *
+  * Restores the 10MHz timer to free running mode, and releases the GPIO interrupt mask, if the timer
+  * was used to clock the bit bang SPI.
+ **/
+void AdiBitBangSpiEnd()
+{
+	if(BitBangTimerClocked)
+	{
+		AdiTimerRelease();
+		AdiGpioRouterUnmask();
+		BitBangTimerClocked = CyFalse;
+	}
+}
+
 /**
   * @brief Configures all pins and timers needed to bitbang a SPI connection.
   *
@@ -301,7 +496,7 @@ CyU3PReturnStatus_t AdiBitBangSpiHandler()
   *
   * @returns A status code indicating the success of the bitbang SPI setup process.
  **/
-static CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config)
+CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
@@ -412,6 +607,21 @@ static CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config)
 	/* Calculate wait value for short half of period */
 	SCLKLowTime = config.HalfClockDelay + BITBANG_HALFCLOCK_OFFSET;
 
+	/* Configure the 10MHz timer to generate a threshold event every SCLK half period */
+	BitBangTimerClocked = config.TimerClocked;
+	if(BitBangTimerClocked)
+	{
+		BitBangHalfPeriodTicks = config.HalfClockDelay;
+		if(BitBangHalfPeriodTicks < ADI_BITBANG_MIN_HALF_TICKS)
+			BitBangHalfPeriodTicks = ADI_BITBANG_MIN_HALF_TICKS;
+		/* The timer threshold bit is polled, so the GPIO ISR must not clear it */
+		AdiGpioRouterMask();
+		AdiTimerAcquire();
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= (~CY_U3P_LPP_GPIO_INTRMODE_MASK);
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_GPIO_INTR_TIMER_THRES << CY_U3P_LPP_GPIO_INTRMODE_POS;
+		AdiBitBangDelay(0);
+	}
+
 	/* Set the sclk active/inactive masks based on CPOL */
 	if(config.CPOL)
 	{
@@ -428,12 +638,79 @@ static CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config)
 	return status;
 }
 
+/**
+  * @brief Waits for one bit bang SCLK half period.
+  *
+  * @param loopCount The number of busy wait loop iterations (loop timed mode only).
+  *
+  * @return void
+  *
+  * In timer clocked mode, the 10MHz timer wraps every half period, so this waits for the next
+  * timer threshold event. Edges then land on timer ticks regardless of the code execution time.
+ **/
+static inline void AdiBitBangHalfClock(uint32_t loopCount)
+{
+	register uvint32_t cycleTimer;
+
+	if(BitBangTimerClocked)
+	{
+		while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+	}
+	else
+	{
+		cycleTimer = loopCount;
+		while(cycleTimer > 0)
+			cycleTimer--;
+	}
+}
+
+/**
+  * @brief Performs a bit bang SPI delay (CS lead/lag or stall).
+  *
+  * @param count The delay. In timer clocked mode, this is in 10MHz timer ticks. Otherwise, busy wait loop iterations.
+  *
+  * @return void
+  *
+  * In timer clocked mode, the timer is re-armed for the SCLK half period once the delay is complete,
+  * so the first SCLK edge after the delay is a full half period later.
+ **/
+static void AdiBitBangDelay(uint32_t count)
+{
+	register uvint32_t cycleTimer;
+
+	if(BitBangTimerClocked)
+	{
+		if(count > 1)
+		{
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold = count - 1;
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = count - 1;
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+			while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
+		}
+		/* Re-arm for the SCLK half period */
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold = BitBangHalfPeriodTicks - 1;
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = BitBangHalfPeriodTicks - 1;
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+	}
+	else
+	{
+		cycleTimer = count;
+		while(cycleTimer > 0)
+			cycleTimer--;
+	}
+}
+
 /**
   * @brief Performs a single bit banged SPI transfer. Pins must already be configured as needed.
   *
-  * @param MOSI A pointer to the master out data buffer. This data will be transmitted MSB first, over the MOSI line in config.
+  * @param MOSI A pointer to the packed master out data buffer. This data will be transmitted MSB first, over the MOSI line in config.
   *
-  * @param MISO A pointer to the data receive (rx) buffer. The data received from a slave will be placed here.
+  * @param MISO A pointer to the packed data receive (rx) buffer. The data received from a slave will be OR'd in here, MSB first.
+  *
+  * @param BitOffset The bit position (0 - 7, counting from the MSB) of the first bit to transfer in MOSI[0] / MISO[0].
   *
   * @param BitCount The number of bits to transfer.
   *
@@ -441,85 +718,96 @@ static CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config)
   *
   * This function allows a user to use any pins on the FX3 as a low speed SPI master. The API
   * provided is similar to the Cypress API for the hardware SPI. This function is fixed to operate in
-  * CPHA mode 1 (update data on idle-active edge, sample on active-idle edge).
+  * CPHA mode 1 (update data on idle-active edge, sample on active-idle edge). Data bits are shifted
+  * in and out of registers, and only touch memory once per byte.
  **/
-static void AdiBitBangSpiTransferCPHA1(uint8_t * MOSI, uint8_t* MISO, uint32_t BitCount, BitBangSpiConf config)
+static void AdiBitBangSpiTransferCPHA1(uint8_t * MOSI, uint8_t* MISO, uint32_t BitOffset, uint32_t BitCount, BitBangSpiConf config)
 {
 	/* Track the number of bits clocked */
 	uint32_t bitCounter;
-	register uvint32_t cycleTimer;
+	register uint32_t mosiByte, misoByte, bitPos;
+
+	/* Load the first partial byte */
+	bitPos = BitOffset;
+	mosiByte = MOSI[0] << bitPos;
+	misoByte = MISO[0] >> (8 - bitPos);
 
 	/* Drop chip select */
 	*CSPin = GPIO_LOW;
 
 	/* Wait for CS lead delay */
-	cycleTimer = config.CSLeadDelay;
-	while(cycleTimer > 0)
-		cycleTimer--;
+	AdiBitBangDelay(config.CSLeadDelay);
 
 	/* main transmission loop */
 	for(bitCounter = 0; bitCounter < (BitCount - 1); bitCounter++)
 	{
 		/* Place output data bit on MOSI pin (approx. 150ns) */
-		*MOSIPin = GPIO_LOW | MOSI[bitCounter];
+		*MOSIPin = GPIO_LOW | ((mosiByte >> 7) & 0x1);
 
 		/* Toggle SCLK active */
 		*SCLKPin = SCLKActiveMask;
 
 		/* Wait HalfClock period (w/ added offset to make duty cycle 50%)*/
-		cycleTimer = SCLKLowTime;
-		while(cycleTimer > 0)
-			cycleTimer--;
+		AdiBitBangHalfClock(SCLKLowTime);
 
 		/* Toggle SCLK inactive */
 		*SCLKPin = SCLKInactiveMask;
 
 		/* Sample MISO pin */
-		MISO[bitCounter] = *MISOPin;
+		misoByte = (misoByte << 1) | ((*MISOPin & CY_U3P_LPP_GPIO_IN_VALUE) >> 1);
+		mosiByte <<= 1;
+
+		/* Move to the next byte. The last bit is clocked after the loop, so the next MOSI byte is always part of the transfer */
+		bitPos++;
+		if(bitPos == 8)
+		{
+			*MISO++ = misoByte;
+			mosiByte = *(++MOSI);
+			misoByte = 0;
+			bitPos = 0;
+		}
 
 		/* Wait HalfClock period */
-		cycleTimer = config.HalfClockDelay;
-		while(cycleTimer > 0)
-			cycleTimer--;
+		AdiBitBangHalfClock(config.HalfClockDelay);
 	}
 
 	/* Perform last bit outside the loop to save some time */
 
 	/* Place output data bit on MOSI pin */
-	*MOSIPin = GPIO_LOW | MOSI[BitCount - 1];
+	*MOSIPin = GPIO_LOW | ((mosiByte >> 7) & 0x1);
 
 	/* Toggle SCLK active */
 	*SCLKPin = SCLKActiveMask;
 
 	/* Wait HalfClock period (w/ added offset to make duty cycle 50%)*/
-	cycleTimer = SCLKLowTime;
-	while(cycleTimer > 0)
-		cycleTimer--;
+	AdiBitBangHalfClock(SCLKLowTime);
 
 	/* Toggle SCLK inactive */
 	*SCLKPin = SCLKInactiveMask;
 
 	/* Sample MISO pin */
-	MISO[BitCount - 1] = *MISOPin;
+	misoByte = (misoByte << 1) | ((*MISOPin & CY_U3P_LPP_GPIO_IN_VALUE) >> 1);
+	bitPos++;
 
 	/* Wait for CS lag delay */
-	cycleTimer = config.CSLagDelay;
-	while(cycleTimer > 0)
-	{
-		cycleTimer--;
-	}
+	AdiBitBangDelay(config.CSLagDelay);
 
 	/* Restore CS, MOSI to high */
 	*CSPin = GPIO_HIGH;
 	*MOSIPin = GPIO_HIGH;
+
+	/* Store the final (possibly partial) MISO byte, MSB aligned */
+	*MISO = (uint8_t) (misoByte << (8 - bitPos));
 }
 
 /**
   * @brief Performs a single bit banged SPI transfer. Pins must already be configured as needed.
   *
-  * @param MOSI A pointer to the master out data buffer. This data will be transmitted MSB first, over the MOSI line in config.
+  * @param MOSI A pointer to the packed master out data buffer. This data will be transmitted MSB first, over the MOSI line in config.
+  *
+  * @param MISO A pointer to the packed data receive (rx) buffer. The data received from a slave will be OR'd in here, MSB first.
   *
-  * @param MISO A pointer to the data receive (rx) buffer. The data received from a slave will be placed here.
+  * @param BitOffset The bit position (0 - 7, counting from the MSB) of the first bit to transfer in MOSI[0] / MISO[0].
   *
   * @param BitCount The number of bits to transfer.
   *
@@ -527,24 +815,28 @@ static void AdiBitBangSpiTransferCPHA1(uint8_t * MOSI, uint8_t* MISO, uint32_t B
   *
   * This function allows a user to use any pins on the FX3 as a low speed SPI master. The API
   * provided is similar to the Cypress API for the hardware SPI. This function is fixed to operate in
-  * CPHA mode 0 (sample data on idle-active edge, update data on active-idle edge).
+  * CPHA mode 0 (sample data on idle-active edge, update data on active-idle edge). Data bits are shifted
+  * in and out of registers, and only touch memory once per byte.
  **/
-static void AdiBitBangSpiTransferCPHA0(uint8_t * MOSI, uint8_t* MISO, uint32_t BitCount, BitBangSpiConf config)
+static void AdiBitBangSpiTransferCPHA0(uint8_t * MOSI, uint8_t* MISO, uint32_t BitOffset, uint32_t BitCount, BitBangSpiConf config)
 {
 	/* Track the number of bits clocked */
 	uint32_t bitCounter;
-	register uvint32_t cycleTimer;
+	register uint32_t mosiByte, misoByte, bitPos;
+
+	/* Load the first partial byte */
+	bitPos = BitOffset;
+	mosiByte = MOSI[0] << bitPos;
+	misoByte = MISO[0] >> (8 - bitPos);
 
 	/* Drop chip select */
 	*CSPin = GPIO_LOW;
 
 	/* Load initial data bit to output */
-	*MOSIPin = GPIO_LOW | MOSI[0];
+	*MOSIPin = GPIO_LOW | ((mosiByte >> 7) & 0x1);
 
 	/* Wait for CS lead delay */
-	cycleTimer = config.CSLeadDelay;
-	while(cycleTimer > 0)
-		cycleTimer--;
+	AdiBitBangDelay(config.CSLeadDelay);
 
 	/* main transmission loop */
 	for(bitCounter = 0; bitCounter < BitCount; bitCounter++)
@@ -553,35 +845,43 @@ static void AdiBitBangSpiTransferCPHA0(uint8_t * MOSI, uint8_t* MISO, uint32_t B
 		*SCLKPin = SCLKActiveMask;
 
 		/* Sample MISO pin */
-		MISO[bitCounter] = *MISOPin;
+		misoByte = (misoByte << 1) | ((*MISOPin & CY_U3P_LPP_GPIO_IN_VALUE) >> 1);
+		mosiByte <<= 1;
+
+		/* Move to the next byte. Only load the next MOSI byte if bits remain, to not read past the end of the buffer */
+		bitPos++;
+		if(bitPos == 8)
+		{
+			*MISO++ = misoByte;
+			if(bitCounter < (BitCount - 1))
+				mosiByte = *(++MOSI);
+			misoByte = 0;
+			bitPos = 0;
+		}
 
 		/* Wait HalfClock period */
-		cycleTimer = config.HalfClockDelay;
-		while(cycleTimer > 0)
-			cycleTimer--;
+		AdiBitBangHalfClock(config.HalfClockDelay);
 
 		/* Toggle SCLK inactive */
 		*SCLKPin = SCLKInactiveMask;
 
 		/* Place output data bit on MOSI pin (approx. 150ns) */
-		*MOSIPin = GPIO_LOW | MOSI[bitCounter + 1];
+		*MOSIPin = GPIO_LOW | ((mosiByte >> 7) & 0x1);
 
 		/* Wait HalfClock period (w/ added offset to make duty cycle 50%)*/
-		cycleTimer = SCLKLowTime;
-		while(cycleTimer > 0)
-			cycleTimer--;
+		AdiBitBangHalfClock(SCLKLowTime);
 	}
 
 	/* Wait for CS lag delay */
-	cycleTimer = config.CSLagDelay;
-	while(cycleTimer > 0)
-	{
-		cycleTimer--;
-	}
+	AdiBitBangDelay(config.CSLagDelay);
 
 	/* Restore CS, MOSI to high */
 	*CSPin = GPIO_HIGH;
 	*MOSIPin = GPIO_HIGH;
+
+	/* Store the final partial MISO byte, MSB aligned */
+	if(bitPos)
+		*MISO = (uint8_t) (misoByte << (8 - bitPos));
 }
 
 /**
@@ -661,8 +961,10 @@ CyU3PReturnStatus_t AdiTransferBytes(uint32_t writeData)
 	writeBuffer[2] = (writeData & 0xFF0000) >> 16;
 	writeBuffer[3] = (writeData & 0xFF000000) >> 24;
 
+	/* Raw transfers bypass the register cache */
+	AdiRegCacheInvalidate();
+
 	/* perform SPI transfer */
-	AdiWaitForSpiNotBusy();
 	AdiSpiTransferWord(writeBuffer, readBuffer);
 
 	/* Load read data to be sent back via control endpoint */
@@ -680,39 +982,75 @@ CyU3PReturnStatus_t AdiTransferBytes(uint32_t writeData)
   *
   * @param addr The address to send to the DUT in the first SPI transaction.
   *
+  * @param outBuf Output buffer for the register value (2 bytes, LSB first)
+  *
   * @return A status code indicating the success of the function.
   *
   * This function reads a single word over SPI. Note that reads are not "full duplex"
   * and will require a discrete read to set the address to be read from (two 16 bit transactions per read).
  **/
-CyU3PReturnStatus_t AdiReadRegBytes(uint16_t addr)
+CyU3PReturnStatus_t AdiReadRegData(uint16_t addr, uint8_t * outBuf)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	uint8_t tempBuffer[2];
+	uint16_t cachedValue;
 
-	/* Set the second byte to 0's */
-	tempBuffer[0] = 0;
-	/* Set the address to read from */
-	tempBuffer[1] = (0x7F) & addr;
-	/* Send SPI Read command */
-	status = CyU3PSpiTransmitWords(tempBuffer, 2);
-	/* Check that the transfer was successful and end function if failed */
-	if (status != CY_U3P_SUCCESS)
+	/* Check the register cache first */
+	if(AdiRegCacheRead(addr, &cachedValue))
 	{
-		AdiLogError(SpiFunctions_c, __LINE__, status);
+		outBuf[0] = cachedValue & 0xFF;
+		outBuf[1] = (cachedValue & 0xFF00) >> 8;
 	}
+	else
+	{
+		/* Set the second byte to 0's */
+		outBuf[0] = 0;
+		/* Set the address to read from */
+		outBuf[1] = (0x7F) & addr;
+		/* Send SPI Read command */
+		status = CyU3PSpiTransmitWords(outBuf, 2);
+		/* Check that the transfer was successful and end function if failed */
+		if (status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(SpiFunctions_c, __LINE__, status);
+		}
 
-	/* Stall for user-specified time */
-	AdiSleepForMicroSeconds(FX3State.StallTime);
+		/* Stall for user-specified time */
+		AdiSleepForMicroSeconds(FX3State.StallTime);
 
-	/* Receive the data requested */
-	status = CyU3PSpiReceiveWords(tempBuffer, 2);
-	/* Check that the transfer was successful and end function if failed */
-	if (status != CY_U3P_SUCCESS)
-	{
-		AdiLogError(SpiFunctions_c, __LINE__, status);
+		/* Receive the data requested */
+		status = CyU3PSpiReceiveWords(outBuf, 2);
+		/* Check that the transfer was successful and end function if failed */
+		if (status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(SpiFunctions_c, __LINE__, status);
+		}
+		else
+		{
+			/* Populate the register cache */
+			AdiRegCacheStoreRead(addr, outBuf[0] | (outBuf[1] << 8));
+		}
 	}
 
+	return status;
+}
+
+/**
+  * @brief This function handles register read requests from the control endpoint.
+  *
+  * @param addr The address to send to the DUT in the first SPI transaction.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Reads the register using AdiReadRegData, then sends the status and register value back
+  * over the control endpoint.
+ **/
+CyU3PReturnStatus_t AdiReadRegBytes(uint16_t addr)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint8_t tempBuffer[2];
+
+	status = AdiReadRegData(addr, tempBuffer);
+
 	/* Send status and data back via control endpoint */
 	USBBuffer[0] = status & 0xFF;
 	USBBuffer[1] = (status & 0xFF00) >> 8;
@@ -738,7 +1076,7 @@ CyU3PReturnStatus_t AdiReadRegBytes(uint16_t addr)
   * For the standard iSensor SPI parts, a write is performed in a single 16 bit command,
   * where the first bit clocked out is the write bit (high) followed by the address and data.
  **/
-CyU3PReturnStatus_t AdiWriteRegByte(uint16_t addr, uint8_t data)
+CyU3PReturnStatus_t AdiWriteRegData(uint16_t addr, uint8_t data)
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	uint8_t tempBuffer[2];
@@ -749,7 +1087,34 @@ CyU3PReturnStatus_t AdiWriteRegByte(uint16_t addr, uint8_t data)
 	if (status != CY_U3P_SUCCESS)
 	{
 		AdiLogError(SpiFunctions_c, __LINE__, status);
+		/* DUT state is unknown */
+		AdiRegCacheInvalidate();
 	}
+	else
+	{
+		/* Write through to the register cache */
+		AdiRegCacheWrite(addr, data);
+	}
+	return status;
+}
+
+/**
+  * @brief This function handles register write requests from the control endpoint.
+  *
+  * @param addr The DUT address to write data to (7 bits).
+  *
+  * @param data The byte of data to write to the address
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Writes the register using AdiWriteRegData, then sends the status back over the control endpoint.
+ **/
+CyU3PReturnStatus_t AdiWriteRegByte(uint16_t addr, uint8_t data)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	status = AdiWriteRegData(addr, data);
+
 	/* Send write status over the control endpoint */
 	USBBuffer[0] = status & 0xFF;
 	USBBuffer[1] = (status & 0xFF00) >> 8;
@@ -760,6 +1125,380 @@ CyU3PReturnStatus_t AdiWriteRegByte(uint16_t addr, uint8_t data)
 	return status;
 }
 
+/**
+  * @brief This function performs an atomic read-modify-write of a 16 bit register.
+  *
+  * @param transferLength The number of bytes in the control endpoint data phase
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The control endpoint data is formatted as addr[0-1], mask[2-3], value[4-5]. The register is read
+  * over SPI, the bits set in mask are replaced with the corresponding bits of value, and the result
+  * is written back using byte writes. Only the register bytes covered by mask are written (lower byte
+  * to addr, upper byte to addr + 1). All SPI words are run in a single SPI streaming session, with the
+  * configured stall time between each word, so no other register access can occur between the read
+  * and the write. The status (4 bytes), old register value (2 bytes) and new register value (2 bytes)
+  * are sent to the PC over the bulk endpoint.
+ **/
+CyU3PReturnStatus_t AdiRegReadModifyWrite(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t addr, mask, value, oldValue, newValue;
+	uint8_t txBuf[2];
+	uint8_t rxBuf[2] = {0};
+
+	/* Read the RMW parameters into USBBuffer */
+	if(transferLength < 6)
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 8);
+		return status;
+	}
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 8);
+		return status;
+	}
+
+	/* Parse parameters */
+	addr = USBBuffer[0];
+	addr |= (USBBuffer[1] << 8);
+	mask = USBBuffer[2];
+	mask |= (USBBuffer[3] << 8);
+	value = USBBuffer[4];
+	value |= (USBBuffer[5] << 8);
+
+	/* Always operate on the whole register */
+	addr &= 0x7E;
+
+	AdiSpiStreamSessionStart();
+
+	/* Send the read command */
+	txBuf[0] = 0;
+	txBuf[1] = addr;
+	AdiSpiStreamTransferWord(txBuf, rxBuf);
+	AdiSleepForMicroSeconds(FX3State.StallTime);
+
+	/* Clock out the read data (read of address 0 is discarded) */
+	txBuf[1] = 0;
+	AdiSpiStreamTransferWord(txBuf, rxBuf);
+	AdiSleepForMicroSeconds(FX3State.StallTime);
+	oldValue = rxBuf[0] | (rxBuf[1] << 8);
+
+	/* Merge */
+	newValue = (oldValue & ~mask) | (value & mask);
+
+	/* Write the lower byte */
+	if(mask & 0x00FF)
+	{
+		txBuf[0] = newValue & 0xFF;
+		txBuf[1] = 0x80 | addr;
+		AdiSpiStreamTransferWord(txBuf, rxBuf);
+		AdiSleepForMicroSeconds(FX3State.StallTime);
+	}
+
+	/* Write the upper byte */
+	if(mask & 0xFF00)
+	{
+		txBuf[0] = (newValue & 0xFF00) >> 8;
+		txBuf[1] = 0x80 | (addr + 1);
+		AdiSpiStreamTransferWord(txBuf, rxBuf);
+	}
+
+	AdiSpiStreamSessionEnd();
+
+	/* Keep the register cache coherent */
+	AdiRegCacheStoreRead(addr, oldValue);
+	AdiRegCacheWrite(addr, newValue & 0xFF);
+	AdiRegCacheWrite(addr + 1, (newValue & 0xFF00) >> 8);
+
+	/* Send status, old value, new value to the PC */
+	BulkBuffer[4] = oldValue & 0xFF;
+	BulkBuffer[5] = (oldValue & 0xFF00) >> 8;
+	BulkBuffer[6] = newValue & 0xFF;
+	BulkBuffer[7] = (newValue & 0xFF00) >> 8;
+	AdiReturnBulkEndpointData(status, 8);
+
+	return status;
+}
+
+/**
+  * @brief This function performs a batch of register reads and writes, and returns all read data at once.
+  *
+  * @param transferLength The number of bytes in the control endpoint data phase (2 bytes per register operation)
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The control endpoint data contains a list of 16 bit register operations, formatted the same way as the
+  * generic stream register list: for each operation, byte 0 is the write data and byte 1 is the address,
+  * with the write bit (0x80) set for a write. All operations are clocked out back to back in a single SPI
+  * streaming session, with the configured stall time (FX3State.StallTime) between each word. Since the
+  * iSensor SPI protocol returns read data on the following SPI word, the read data for each read operation
+  * is captured from the next transfer in the list, and an extra read of address 0 is appended if the final
+  * operation is a read. The status (4 bytes) followed by the 16 bit result of each read operation, in order,
+  * is sent to the PC over the bulk endpoint. An odd transferLength is rejected with CY_U3P_ERROR_BAD_ARGUMENT.
+ **/
+CyU3PReturnStatus_t AdiRegBatchHandler(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t opIndex, numOps;
+	uint8_t txBuf[2];
+	uint8_t rxBuf[2] = {0};
+	uint8_t *outPtr;
+	uint16_t readAddr = 0;
+	CyBool_t readPending = CyFalse;
+
+	/* Validate that the op list fits in the USB buffer */
+	if(transferLength > sizeof(USBBuffer))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Read the op list into USBBuffer */
+	status = AdiGetRequestData(transferLength, USBBuffer);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Each operation is two bytes, so an odd length is a malformed op list */
+	if(transferLength & 1)
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Two bytes per operation */
+	numOps = transferLength >> 1;
+
+	/* Read data is placed after the status */
+	outPtr = BulkBuffer + 4;
+
+	AdiSpiStreamSessionStart();
+	for(opIndex = 0; opIndex < numOps; opIndex++)
+	{
+		txBuf[0] = USBBuffer[opIndex << 1];
+		txBuf[1] = USBBuffer[(opIndex << 1) + 1];
+
+		/* Clear the lower byte for reads */
+		if(!(txBuf[1] & 0x80))
+		{
+			txBuf[0] = 0;
+		}
+
+		AdiSpiStreamTransferWord(txBuf, rxBuf);
+
+		/* Previous read data comes back on this word */
+		if(readPending)
+		{
+			outPtr[0] = rxBuf[0];
+			outPtr[1] = rxBuf[1];
+			outPtr += 2;
+			AdiRegCacheStoreRead(readAddr, rxBuf[0] | (rxBuf[1] << 8));
+		}
+		readPending = !(txBuf[1] & 0x80);
+
+		/* Keep the register cache coherent */
+		if(readPending)
+		{
+			readAddr = txBuf[1];
+		}
+		else
+		{
+			AdiRegCacheWrite(txBuf[1], txBuf[0]);
+		}
+
+		/* Stall for user-specified time */
+		AdiSleepForMicroSeconds(FX3State.StallTime);
+	}
+
+	/* Clock out the data for a trailing read */
+	if(readPending)
+	{
+		txBuf[0] = 0;
+		txBuf[1] = 0;
+		AdiSpiStreamTransferWord(txBuf, rxBuf);
+		outPtr[0] = rxBuf[0];
+		outPtr[1] = rxBuf[1];
+		outPtr += 2;
+		AdiRegCacheStoreRead(readAddr, rxBuf[0] | (rxBuf[1] << 8));
+	}
+	AdiSpiStreamSessionEnd();
+
+	/* Send status and read data to the PC */
+	AdiReturnBulkEndpointData(status, outPtr - BulkBuffer);
+
+	return status;
+}
+
+/**
+  * @brief This function runs a SPI link characterization sweep over a grid of SCLK frequencies and stall times.
+  *
+  * @param transferLength The number of bytes in the control endpoint data phase
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * The control endpoint data is formatted as addr[0-1], expectedValue[2-3], numReads[4-5], numSclk[6],
+  * numStall[7], SCLK frequency list[8 - ...] (4 bytes per frequency, in Hz), stall time list (2 bytes per stall,
+  * in microseconds). For each grid point, the SPI clock and stall time are applied, then the register at addr
+  * is read numReads times, back to back, using the same timer based stall as the generic register stream
+  * (AdiConfigStreamStallTimer). Each read is compared against expectedValue. The status (4 bytes) followed by
+  * the number of failed reads (2 bytes) for each grid point is sent to the PC over the bulk endpoint. The
+  * results are ordered with the stall time index changing fastest. A grid point passes if its failure count
+  * is 0. The original SCLK frequency and stall time are restored after the sweep.
+ **/
+CyU3PReturnStatus_t AdiSpiSweepHandler(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t *bytesRead = 0;
+	uint16_t addr, expectedValue, numReads, readCount, numErrors;
+	uint8_t numSclk, numStall, sclkIndex, stallIndex;
+	uint32_t originalClock;
+	uint16_t originalStall;
+	uint8_t *sclkList, *stallList, *outPtr;
+	uint8_t txBuf[2];
+	uint8_t rxBuf[2] = {0};
+
+	/* Read the sweep parameters into USBBuffer */
+	if((transferLength < 8) || (transferLength > sizeof(USBBuffer)))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+	status = CyU3PUsbGetEP0Data(transferLength, USBBuffer, bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Parse parameters */
+	addr = USBBuffer[0];
+	addr |= (USBBuffer[1] << 8);
+	expectedValue = USBBuffer[2];
+	expectedValue |= (USBBuffer[3] << 8);
+	numReads = USBBuffer[4];
+	numReads |= (USBBuffer[5] << 8);
+	numSclk = USBBuffer[6];
+	numStall = USBBuffer[7];
+	sclkList = USBBuffer + 8;
+	stallList = sclkList + (4 * numSclk);
+
+	/* Validate grid fits in the request and the result fits in the bulk buffer */
+	if(((8 + (4 * numSclk) + (2 * numStall)) > transferLength) || ((4 + (2 * numSclk * numStall)) > sizeof(BulkBuffer)))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(SpiFunctions_c, __LINE__, status);
+		AdiReturnBulkEndpointData(status, 4);
+		return status;
+	}
+
+	/* Save the current settings */
+	originalClock = FX3State.SpiConfig.clock;
+	originalStall = FX3State.StallTime;
+
+	/* Read command for the register under test */
+	txBuf[0] = 0;
+	txBuf[1] = addr & 0x7F;
+
+	/* Mask the GPIO ISR, which would clear the timer interrupt bit polled for each stall */
+	AdiGpioRouterMask();
+
+	outPtr = BulkBuffer + 4;
+	for(sclkIndex = 0; sclkIndex < numSclk; sclkIndex++)
+	{
+		/* Apply SCLK setting (same as AdiSpiUpdate) */
+		FX3State.SpiConfig.clock = sclkList[4 * sclkIndex];
+		FX3State.SpiConfig.clock |= (sclkList[(4 * sclkIndex) + 1] << 8);
+		FX3State.SpiConfig.clock |= (sclkList[(4 * sclkIndex) + 2] << 16);
+		FX3State.SpiConfig.clock |= (sclkList[(4 * sclkIndex) + 3] << 24);
+		status = CyU3PSpiSetConfig(&FX3State.SpiConfig, NULL);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(SpiFunctions_c, __LINE__, status);
+			break;
+		}
+
+		for(stallIndex = 0; stallIndex < numStall; stallIndex++)
+		{
+			/* Apply stall setting */
+			FX3State.StallTime = stallList[2 * stallIndex];
+			FX3State.StallTime |= (stallList[(2 * stallIndex) + 1] << 8);
+			AdiConfigStreamStallTimer();
+
+			AdiSpiStreamSessionStart();
+
+			/* Prime the first read */
+			AdiSpiStreamTransferWord(txBuf, rxBuf);
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+
+			/* Each transfer returns the data for the previous read */
+			numErrors = 0;
+			for(readCount = 0; readCount < numReads; readCount++)
+			{
+				/* Wait for the complex GPIO timer to reach the stall time */
+				while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
+
+				AdiSpiStreamTransferWord(txBuf, rxBuf);
+
+				GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
+				GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
+
+				if((rxBuf[0] | (rxBuf[1] << 8)) != expectedValue)
+				{
+					numErrors++;
+				}
+			}
+
+			/* Wait for final stall before the next grid point */
+			while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
+
+			AdiSpiStreamSessionEnd();
+
+			outPtr[0] = numErrors & 0xFF;
+			outPtr[1] = (numErrors & 0xFF00) >> 8;
+			outPtr += 2;
+		}
+	}
+
+	/* Restore the timer to its default (free running) state */
+	AdiTimerRelease();
+	AdiGpioRouterUnmask();
+
+	/* Restore the original SPI settings */
+	FX3State.StallTime = originalStall;
+	FX3State.SpiConfig.clock = originalClock;
+	if(status == CY_U3P_SUCCESS)
+	{
+		status = CyU3PSpiSetConfig(&FX3State.SpiConfig, NULL);
+		if(status != CY_U3P_SUCCESS)
+			AdiLogError(SpiFunctions_c, __LINE__, status);
+	}
+	else
+	{
+		CyU3PSpiSetConfig(&FX3State.SpiConfig, NULL);
+	}
+
+	/* Send status and results to PC */
+	AdiReturnBulkEndpointData(status, outPtr - BulkBuffer);
+
+	return status;
+}
+
 /**
   * @brief Sets the SPI controller word length (4 - 32 bits)
   *
@@ -1019,6 +1758,8 @@ CyBool_t AdiSpiUpdate(uint16_t index, uint16_t value, uint16_t length)
 	case 10:
 		/* DUT type */
 		FX3State.DutType = value;
+		/* Paging behavior may have changed */
+		AdiRegCacheInvalidate();
 		switch(FX3State.DutType)
 		{
 		case ADcmXL3021:
@@ -46,11 +46,23 @@ typedef struct BitBangSpiConf
 	/** The delay after finishing SCLKs before raising CS */
 	uint16_t CSLagDelay;
 
+	/** The delay after each transfer */
+	uint32_t StallDelay;
+
+	/** The number of bits clocked per transfer (CS assertion) */
+	uint32_t BitsPerTransfer;
+
+	/** The number of transfers to perform */
+	uint32_t NumTransfers;
+
 	/** SPI clock phase setting */
 	CyBool_t CPHA;
 
 	/** SPI clock polarity setting */
 	CyBool_t CPOL;
+
+	/** Derive SCLK edges from the 10MHz timer (delays in timer ticks) instead of busy wait loops */
+	CyBool_t TimerClocked;
 }BitBangSpiConf;
 
 /* SPI configuration functions */
@@ -61,15 +73,39 @@ CyU3PSpiConfig_t AdiGetSpiConfig();
 void AdiSetSpiWordLength(uint8_t wordLength);
 void AdiPrintSpiConfig(CyU3PSpiConfig_t config);
 CyU3PReturnStatus_t AdiRestartSpi();
+CyU3PReturnStatus_t AdiSpiSweepHandler(uint16_t transferLength);
 
 /* SPI data transfer functions */
 void AdiSpiTransferWord(uint8_t *txBuf, uint8_t *rxBuf);
+void AdiSpiStreamSessionStart();
+void AdiSpiStreamTransferWord(uint8_t *txBuf, uint8_t *rxBuf);
+void AdiSpiStreamSessionEnd();
 CyU3PReturnStatus_t AdiTransferBytes(uint32_t writeData);
 CyU3PReturnStatus_t AdiWriteRegByte(uint16_t addr, uint8_t data);
 CyU3PReturnStatus_t AdiReadRegBytes(uint16_t addr);
+CyU3PReturnStatus_t AdiReadRegData(uint16_t addr, uint8_t * outBuf);
+CyU3PReturnStatus_t AdiWriteRegData(uint16_t addr, uint8_t data);
+CyU3PReturnStatus_t AdiRegBatchHandler(uint16_t transferLength);
+CyU3PReturnStatus_t AdiRegReadModifyWrite(uint16_t transferLength);
 
 /* Bitbang SPI functions */
-CyU3PReturnStatus_t AdiBitBangSpiHandler();
+CyU3PReturnStatus_t AdiBitBangSpiHandler(uint16_t flags, uint16_t transferLength);
+void AdiBitBangSpiParseConfig(uint8_t * params, uint16_t flags, BitBangSpiConf * config);
+CyU3PReturnStatus_t AdiBitBangSpiSetup(BitBangSpiConf config);
+void AdiBitBangSpiRun(uint8_t * MOSI, uint8_t * MISO, BitBangSpiConf * config);
+void AdiBitBangSpiEnd();
+
+/** Number of bit bang SPI configuration bytes ahead of the MOSI data */
+#define ADI_BITBANG_HEADER_LEN 26
+
+/** Bit bang SPI flag (wIndex) to send MOSI data and return MISO data packed 8 bits per byte */
+#define ADI_BITBANG_FLAG_PACKED (1 << 0)
+
+/** Bit bang SPI flag (wIndex) to time all SCLK edges and delays from the 10MHz timer */
+#define ADI_BITBANG_FLAG_TIMER (1 << 1)
+
+/** Minimum SCLK half period in timer clocked mode, in 10MHz timer ticks (approx. 1.26MHz SCLK) */
+#define ADI_BITBANG_MIN_HALF_TICKS 4
 
 /** Offset to make the short side of the bitbang SPI match long side. Approx. 62ns per tick */
 #define BITBANG_HALFCLOCK_OFFSET 5
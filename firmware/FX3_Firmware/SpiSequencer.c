@@ -0,0 +1,339 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		SpiSequencer.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		On-device SPI micro-sequencer, for DUT transactions which need FX3 side timing.
+  *
+  * The host uploads a small bytecode script once (SPI word transfers, pin drive, pin edge waits,
+  * timer delays, counted loops, and captures of received data). The script is validated on upload,
+  * and can then be run on demand (captured data returned over the bulk endpoint), or repeated for
+  * each data ready edge as a stream (captured data sent over the streaming endpoint).
+  *
+  * The scripts have no branches, so the number of bytes captured per run is fixed, and computed
+  * during validation. This lets the stream pack runs into USB buffers the same way as the
+  * transfer and bit bang streams.
+ **/
+
+#include "SpiSequencer.h"
+
+/* Tell the compiler where to find the needed globals */
+extern uint8_t BulkBuffer[12288];
+
+/** Sequencer script storage */
+static uint8_t SeqScript[ADI_SEQ_MAX_SCRIPT_LEN];
+
+/** Number of bytes captured by a single run of the current script */
+static uint32_t SeqCaptureLen = 0;
+
+/** Track if the current script passed validation */
+static CyBool_t SeqScriptValid = CyFalse;
+
+/**
+  * @brief Gets the number of operand bytes which follow a sequencer op code.
+  *
+  * @param op The op code
+  *
+  * @return The operand length, or -1 for an unknown op code
+ **/
+static int32_t AdiSpiSeqOperandLength(uint8_t op)
+{
+	switch(op)
+	{
+	case ADI_SEQ_OP_END:
+	case ADI_SEQ_OP_END_LOOP:
+		return 0;
+	case ADI_SEQ_OP_CAPTURE:
+		return 1;
+	case ADI_SEQ_OP_SET_PIN:
+	case ADI_SEQ_OP_LOOP:
+		return 2;
+	case ADI_SEQ_OP_XFER:
+	case ADI_SEQ_OP_WAIT_PIN:
+	case ADI_SEQ_OP_DELAY:
+		return 4;
+	default:
+		return -1;
+	}
+}
+
+/**
+  * @brief Validates the uploaded script, and computes the number of bytes captured per run.
+  *
+  * @param length The number of script bytes uploaded
+  *
+  * @return A status code indicating if the script is valid
+  *
+  * Checks that every op code is known and complete, that pin numbers are valid, that loops are
+  * balanced and within the max nesting depth, that the script is terminated by an END op, and that
+  * a single run does not capture more than ADI_SEQ_MAX_CAPTURE_LEN bytes.
+ **/
+static CyU3PReturnStatus_t AdiSpiSeqValidate(uint16_t length)
+{
+	uint32_t pc = 0;
+	uint32_t depth = 0;
+	uint32_t captureLen = 0;
+	uint32_t multiplier[ADI_SEQ_MAX_LOOP_DEPTH + 1];
+	int32_t operandLen;
+	uint16_t count;
+
+	/* Runs outside of any loop capture once */
+	multiplier[0] = 1;
+
+	while(pc < length)
+	{
+		operandLen = AdiSpiSeqOperandLength(SeqScript[pc]);
+		if((operandLen < 0) || ((pc + operandLen) >= length))
+			return CY_U3P_ERROR_BAD_ARGUMENT;
+
+		switch(SeqScript[pc])
+		{
+		case ADI_SEQ_OP_END:
+			if(depth != 0)
+				return CY_U3P_ERROR_INVALID_SEQUENCE;
+			SeqCaptureLen = captureLen;
+			return CY_U3P_SUCCESS;
+
+		case ADI_SEQ_OP_CAPTURE:
+			if((SeqScript[pc + 1] == 0) || (SeqScript[pc + 1] > 4))
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			captureLen += SeqScript[pc + 1] * multiplier[depth];
+			if(captureLen > ADI_SEQ_MAX_CAPTURE_LEN)
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			break;
+
+		case ADI_SEQ_OP_SET_PIN:
+		case ADI_SEQ_OP_WAIT_PIN:
+			if(!AdiIsValidGPIO(SeqScript[pc + 1]))
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			if((SeqScript[pc] == ADI_SEQ_OP_WAIT_PIN) && (SeqScript[pc + 2] > 2))
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			if((SeqScript[pc] == ADI_SEQ_OP_WAIT_PIN) && ((SeqScript[pc + 3] | (SeqScript[pc + 4] << 8)) == 0))
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			break;
+
+		case ADI_SEQ_OP_LOOP:
+			count = SeqScript[pc + 1] | (SeqScript[pc + 2] << 8);
+			if((count == 0) || (depth >= ADI_SEQ_MAX_LOOP_DEPTH))
+				return CY_U3P_ERROR_BAD_ARGUMENT;
+			/* Clamp, so that the capture length overflows the max instead of the counter */
+			multiplier[depth + 1] = multiplier[depth] * count;
+			if(multiplier[depth + 1] > ADI_SEQ_MAX_CAPTURE_LEN)
+				multiplier[depth + 1] = ADI_SEQ_MAX_CAPTURE_LEN + 1;
+			depth++;
+			break;
+
+		case ADI_SEQ_OP_END_LOOP:
+			if(depth == 0)
+				return CY_U3P_ERROR_INVALID_SEQUENCE;
+			depth--;
+			break;
+
+		default:
+			break;
+		}
+		pc += operandLen + 1;
+	}
+
+	/* No END op */
+	return CY_U3P_ERROR_INVALID_SEQUENCE;
+}
+
+/**
+  * @brief Gets the number of bytes captured by a single run of the current script.
+  *
+  * @return The capture length, in bytes. 0 if there is no valid script loaded.
+ **/
+uint32_t AdiSpiSeqGetCaptureLength()
+{
+	if(!SeqScriptValid)
+		return 0;
+	return SeqCaptureLen;
+}
+
+/**
+  * @brief Runs the uploaded script once.
+  *
+  * @param outBuf Buffer to place the captured data in. Must hold AdiSpiSeqGetCaptureLength() bytes.
+  *
+  * @param outLen Output for the number of bytes captured
+  *
+  * @return A status code indicating the success of the script run
+  *
+  * SPI words are transferred using AdiSpiTransferWord, so the SPI controller must be configured
+  * and free. Pin waits use AdiWaitForPin, and fail the run on timeout. Delays are timed from
+  * the extended (64-bit) 10MHz timer.
+ **/
+CyU3PReturnStatus_t AdiSpiSeqExecute(uint8_t * outBuf, uint32_t * outLen)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint32_t pc = 0;
+	uint32_t depth = 0;
+	uint32_t loopStart[ADI_SEQ_MAX_LOOP_DEPTH];
+	uint16_t loopCount[ADI_SEQ_MAX_LOOP_DEPTH];
+	uint8_t rxBuf[4] = {0};
+	uint32_t ticks, timeoutMs;
+	uint64_t startTime;
+	CyU3PGpioIntrMode_t edge;
+
+	*outLen = 0;
+
+	if(!SeqScriptValid)
+		return CY_U3P_ERROR_NOT_STARTED;
+
+	for(;;)
+	{
+		switch(SeqScript[pc])
+		{
+		case ADI_SEQ_OP_END:
+			return CY_U3P_SUCCESS;
+
+		case ADI_SEQ_OP_XFER:
+			AdiSpiTransferWord(SeqScript + pc + 1, rxBuf);
+			pc += 5;
+			break;
+
+		case ADI_SEQ_OP_CAPTURE:
+			CyU3PMemCopy(outBuf + *outLen, rxBuf, SeqScript[pc + 1]);
+			*outLen += SeqScript[pc + 1];
+			pc += 2;
+			break;
+
+		case ADI_SEQ_OP_SET_PIN:
+			status = AdiSetPin(SeqScript[pc + 1], (CyBool_t) (SeqScript[pc + 2] != 0));
+			if(status != CY_U3P_SUCCESS)
+				return status;
+			pc += 3;
+			break;
+
+		case ADI_SEQ_OP_WAIT_PIN:
+			if(SeqScript[pc + 2] == 0)
+				edge = CY_U3P_GPIO_INTR_NEG_EDGE;
+			else if(SeqScript[pc + 2] == 1)
+				edge = CY_U3P_GPIO_INTR_POS_EDGE;
+			else
+				edge = CY_U3P_GPIO_INTR_BOTH_EDGE;
+			timeoutMs = SeqScript[pc + 3] | (SeqScript[pc + 4] << 8);
+			status = AdiWaitForPin(SeqScript[pc + 1], edge, timeoutMs);
+			if(status != CY_U3P_SUCCESS)
+				return status;
+			pc += 5;
+			break;
+
+		case ADI_SEQ_OP_DELAY:
+			ticks = SeqScript[pc + 1];
+			ticks |= (SeqScript[pc + 2] << 8);
+			ticks |= (SeqScript[pc + 3] << 16);
+			ticks |= (SeqScript[pc + 4] << 24);
+			startTime = AdiGetTicks64();
+			while((AdiGetTicks64() - startTime) < ticks);
+			pc += 5;
+			break;
+
+		case ADI_SEQ_OP_LOOP:
+			loopCount[depth] = SeqScript[pc + 1] | (SeqScript[pc + 2] << 8);
+			pc += 3;
+			loopStart[depth] = pc;
+			depth++;
+			break;
+
+		case ADI_SEQ_OP_END_LOOP:
+			loopCount[depth - 1]--;
+			if(loopCount[depth - 1])
+			{
+				pc = loopStart[depth - 1];
+			}
+			else
+			{
+				depth--;
+				pc++;
+			}
+			break;
+
+		default:
+			/* Validation should make this unreachable */
+			return CY_U3P_ERROR_INVALID_SEQUENCE;
+		}
+	}
+}
+
+/**
+  * @brief Handles SPI micro-sequencer control endpoint requests.
+  *
+  * @param index The sequencer command (wIndex)
+  *
+  * @param length The number of bytes in the control endpoint data phase (wLength)
+  *
+  * @return A status code indicating the success of the command
+  *
+  * ADI_SEQ_CMD_UPLOAD: The data phase contains the script. The script is validated, and the status
+  * is returned over the bulk endpoint. A script which fails validation cannot be run.
+  *
+  * ADI_SEQ_CMD_RUN: Runs the script once. Any data phase is ignored. The status (4 bytes) is returned
+  * over the bulk endpoint, followed by the captured data. On failure the captured data which was not reached is zero.
+ **/
+CyU3PReturnStatus_t AdiSpiSeqHandler(uint16_t index, uint16_t length)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t bytesRead = 0;
+	uint32_t captureLen;
+
+	switch(index)
+	{
+	case ADI_SEQ_CMD_UPLOAD:
+		SeqScriptValid = CyFalse;
+		SeqCaptureLen = 0;
+		if((length == 0) || (length > sizeof(SeqScript)))
+		{
+			status = CY_U3P_ERROR_BAD_ARGUMENT;
+			AdiLogError(SpiSequencer_c, __LINE__, status);
+			AdiSendStatus(status, 4, CyFalse);
+			break;
+		}
+		status = CyU3PUsbGetEP0Data(length, SeqScript, &bytesRead);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(SpiSequencer_c, __LINE__, status);
+			AdiSendStatus(status, 4, CyFalse);
+			break;
+		}
+		status = AdiSpiSeqValidate(length);
+		SeqScriptValid = (CyBool_t) (status == CY_U3P_SUCCESS);
+		AdiSendStatus(status, 4, CyFalse);
+		break;
+
+	case ADI_SEQ_CMD_RUN:
+		/* Drain the (unused) data phase, if the host sent one */
+		if((length > 0) && (length <= sizeof(BulkBuffer)))
+		{
+			CyU3PUsbGetEP0Data(length, BulkBuffer, &bytesRead);
+		}
+
+		/* Script SPI traffic bypasses the register cache */
+		AdiRegCacheInvalidate();
+		CyU3PMemSet(BulkBuffer + 4, 0, SeqCaptureLen);
+		status = AdiSpiSeqExecute(BulkBuffer + 4, &captureLen);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(SpiSequencer_c, __LINE__, status);
+		}
+		AdiReturnBulkEndpointData(status, 4 + SeqCaptureLen);
+		break;
+
+	default:
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiSendStatus(status, length, CyTrue);
+		break;
+	}
+
+	return status;
+}
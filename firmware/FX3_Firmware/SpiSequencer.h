@@ -0,0 +1,72 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * THIS SOFTWARE UTILIZES LIBRARIES DEVELOPED
+  * AND MAINTAINED BY CYPRESS INC. THE LICENSE INCLUDED IN
+  * THIS REPOSITORY DOES NOT EXTEND TO CYPRESS PROPERTY.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		SpiSequencer.h
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Header file for the SPI micro-sequencer
+ **/
+
+#ifndef SPISEQUENCER_H_
+#define SPISEQUENCER_H_
+
+/* Include main */
+#include "main.h"
+
+/* Public function prototypes */
+CyU3PReturnStatus_t AdiSpiSeqHandler(uint16_t index, uint16_t length);
+CyU3PReturnStatus_t AdiSpiSeqExecute(uint8_t * outBuf, uint32_t * outLen);
+uint32_t AdiSpiSeqGetCaptureLength();
+
+/** Max size of a sequencer script, in bytes */
+#define ADI_SEQ_MAX_SCRIPT_LEN					(2048)
+
+/** Max number of bytes a single script run can capture (must fit in the bulk endpoint buffer after the status) */
+#define ADI_SEQ_MAX_CAPTURE_LEN					(12288 - 4)
+
+/** Max nesting depth of sequencer loops */
+#define ADI_SEQ_MAX_LOOP_DEPTH					(4)
+
+/** Sequencer command (wIndex) to upload a script in the control endpoint data phase */
+#define ADI_SEQ_CMD_UPLOAD						(0)
+
+/** Sequencer command (wIndex) to run the uploaded script once and return the captured data */
+#define ADI_SEQ_CMD_RUN							(1)
+
+/*
+ * Sequencer op codes. All multi-byte operands are little endian.
+ */
+
+/** End of script. Format: op */
+#define ADI_SEQ_OP_END							(0x00)
+
+/** Transfer one SPI word (current word length). Format: op, MOSI word[1-4] */
+#define ADI_SEQ_OP_XFER							(0x01)
+
+/** Append the low bytes of the last received SPI word to the capture buffer. Format: op, num bytes (1 - 4) */
+#define ADI_SEQ_OP_CAPTURE						(0x02)
+
+/** Drive a GPIO pin. Format: op, pin, level (0 = low, else high) */
+#define ADI_SEQ_OP_SET_PIN						(0x03)
+
+/** Wait for an edge on a GPIO pin. Format: op, pin, edge (0 = falling, 1 = rising, 2 = both), timeout in ms[3-4] (must be non-zero) */
+#define ADI_SEQ_OP_WAIT_PIN						(0x04)
+
+/** Busy wait a number of 10MHz timer ticks. Format: op, ticks[1-4] */
+#define ADI_SEQ_OP_DELAY						(0x05)
+
+/** Start of a loop body. Format: op, count[1-2] (1 - 65535) */
+#define ADI_SEQ_OP_LOOP							(0x06)
+
+/** End of the innermost loop body. Format: op */
+#define ADI_SEQ_OP_END_LOOP						(0x07)
+
+#endif /* SPISEQUENCER_H_ */
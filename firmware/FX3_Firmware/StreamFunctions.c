@@ -18,6 +18,9 @@
 
 #include "StreamFunctions.h"
 
+/* Private function prototypes */
+static void AdiSyncStrobeStreamStart();
+
 /* Tell the compiler where to find the needed globals */
 extern CyU3PEvent EventHandler;
 extern CyU3PDmaChannel StreamingChannel;
@@ -26,6 +29,9 @@ extern CyU3PDmaBuffer_t SpiDmaBuffer;
 extern BoardState FX3State;
 extern volatile CyBool_t KillStreamEarly;
 extern StreamState StreamThreadState;
+extern BitBangSpiConf BitBangStreamConfig;
+extern EdgeCaptureState EdgeStreamState;
+extern LogicCaptureState LogicStreamState;
 
 /** Global USB Buffer (Control Endpoint) */
 extern uint8_t USBBuffer[4096];
@@ -43,6 +49,9 @@ extern uint8_t BulkBuffer[12288];
  **/
 void AdiConfigStreamStallTimer()
 {
+	/* Take over the timer from the extended (64-bit) timer */
+	AdiTimerAcquire();
+
 	/* Enable timer interrupts */
 	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= (~CY_U3P_LPP_GPIO_INTRMODE_MASK);
 	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_GPIO_INTR_TIMER_THRES << CY_U3P_LPP_GPIO_INTRMODE_POS;
@@ -62,6 +71,162 @@ void AdiConfigStreamStallTimer()
 	}
 }
 
+/**
+  * @brief Configures the per-frame sync strobe output for burst, real time and generic streams.
+  *
+  * @param transferLength The amount of data (in bytes) to read from the control endpoint
+  *
+  * @return A status code indicating the success of the function. The control endpoint is stalled on failure.
+  *
+  * Request data is enable[0], pin[1-2], polarity[3], pulse width in us[4-5], frame divider[6-7]. The
+  * pin must be one of FX3_PIN_GPIO1 - FX3_PIN_GPIO4. When enabled, the pin is driven to the active
+  * polarity for the pulse width each time a strobe frame is captured (every frame divider frames,
+  * starting with the first frame of each stream), and is otherwise held at the idle level. The pin is
+  * driven back to the idle level when each stream starts, so it can be used for other functions between streams.
+  *
+  * The pulse starts right after the frame SPI transfer completes. The active edge follows the data ready
+  * edge by the data ready polling latency (well under 1us), plus the frame transfer time: bytes * 8 / SCLK
+  * for burst and real time streams, or words * (16 / SCLK + stall time) for generic streams. For example,
+  * a 38 byte burst at 2MHz SCLK puts the strobe approx. 152us after data ready. The FX3Api reports this
+  * delay for the current SPI settings (SyncStrobeDelay), so it can be removed when aligning recordings.
+  *
+  * The pulse width is busy waited, so it adds to the frame loop time for burst and real time streams.
+  * For generic streams it overlaps the stall time after the last word. Keep the width well under the
+  * data ready period.
+ **/
+CyU3PReturnStatus_t AdiConfigureSyncStrobe(uint16_t transferLength)
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t bytesRead = 0;
+	uint16_t pin, width, divider;
+	CyBool_t enable, polarity;
+
+	if(transferLength < 8)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	status = CyU3PUsbGetEP0Data(transferLength, USBBuffer, &bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	enable = (CyBool_t) (USBBuffer[0] != 0);
+	pin = USBBuffer[1];
+	pin |= (USBBuffer[2] << 8);
+	polarity = (CyBool_t) (USBBuffer[3] != 0);
+	width = USBBuffer[4];
+	width |= (USBBuffer[5] << 8);
+	divider = USBBuffer[6];
+	divider |= (USBBuffer[7] << 8);
+
+	/* Disabling leaves the pin at its idle level */
+	if(!enable)
+	{
+		StreamThreadState.StrobeEnable = CyFalse;
+		return CY_U3P_SUCCESS;
+	}
+
+	/* Only the FX3 GPIO header pins can be used as a strobe */
+	if((pin != FX3State.PinMap.FX3_PIN_GPIO1) && (pin != FX3State.PinMap.FX3_PIN_GPIO2) &&
+		(pin != FX3State.PinMap.FX3_PIN_GPIO3) && (pin != FX3State.PinMap.FX3_PIN_GPIO4))
+	{
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	if((width == 0) || (width > ADI_SYNC_STROBE_MAX_WIDTH) || (divider == 0))
+	{
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	/* Drive the pin to the idle level */
+	status = AdiSetPin(pin, !polarity);
+	if(status != CY_U3P_SUCCESS)
+	{
+		return status;
+	}
+
+	/* The pin drive values are read back when each stream starts (AdiSyncStrobeStreamStart) */
+	StreamThreadState.StrobePolarity = polarity;
+	StreamThreadState.StrobePin = pin;
+	StreamThreadState.StrobeWidth = width;
+	StreamThreadState.StrobeDivider = divider;
+	StreamThreadState.StrobeCount = 0;
+	StreamThreadState.StrobeEnable = CyTrue;
+
+#ifdef VERBOSE_MODE
+	CyU3PDebugPrint (4, "Sync strobe enabled on pin %d, width %dus, every %d frames\r\n", pin, width, divider);
+#endif
+
+	return CY_U3P_SUCCESS;
+}
+
+/**
+  * @brief Prepares the sync strobe pin for a new burst, real time or generic stream.
+  *
+  * @return void
+  *
+  * Resets the strobe frame count, so the first frame of the stream is a strobe frame. The pin can be set, read,
+  * or used as a PWM output between streams, so if the strobe is enabled, the pin is driven back to its idle level
+  * and both pin register values are read from the current pin configuration. Each strobe edge is then a single
+  * register write. The strobe is disabled if the pin can't be driven.
+ **/
+static void AdiSyncStrobeStreamStart()
+{
+	CyU3PReturnStatus_t status;
+	uint32_t pinReg;
+
+	StreamThreadState.StrobeCount = 0;
+
+	if(!StreamThreadState.StrobeEnable)
+		return;
+
+	/* Drive the pin to the idle level */
+	status = AdiSetPin(StreamThreadState.StrobePin, !StreamThreadState.StrobePolarity);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		StreamThreadState.StrobeEnable = CyFalse;
+		return;
+	}
+
+	/* Cache both drive values, so a pulse is a single register write per edge */
+	pinReg = GPIO->lpp_gpio_simple[StreamThreadState.StrobePin] & ~(CY_U3P_LPP_GPIO_INTR | CY_U3P_LPP_GPIO_OUT_VALUE);
+	StreamThreadState.StrobeActiveReg = pinReg | (StreamThreadState.StrobePolarity ? CY_U3P_LPP_GPIO_OUT_VALUE : 0);
+	StreamThreadState.StrobeIdleReg = pinReg | (StreamThreadState.StrobePolarity ? 0 : CY_U3P_LPP_GPIO_OUT_VALUE);
+}
+
+/**
+  * @brief Checks if a vendor command is a stream start request.
+  *
+  * @param bRequest The vendor command
+  *
+  * @param wIndex The stream action (wIndex)
+  *
+  * @return CyTrue if the request starts a data stream
+ **/
+CyBool_t AdiIsStreamStart(uint8_t bRequest, uint16_t wIndex)
+{
+	if(wIndex != ADI_STREAM_START_CMD)
+		return CyFalse;
+
+	switch(bRequest)
+	{
+	case ADI_STREAM_GENERIC_DATA:
+	case ADI_STREAM_BURST_DATA:
+	case ADI_STREAM_REALTIME:
+	case ADI_TRANSFER_STREAM:
+	case ADI_BITBANG_STREAM:
+	case ADI_SPI_SEQ_STREAM:
+	case ADI_EDGE_CAPTURE_STREAM:
+	case ADI_LOGIC_CAPTURE_STREAM:
+	case ADI_I2C_READ_STREAM:
+		return CyTrue;
+	default:
+		return CyFalse;
+	}
+}
+
 /**
   * @brief This function sets a flag to notify the streaming thread that the user requested to cancel streaming.
   *
@@ -75,7 +240,7 @@ CyU3PReturnStatus_t AdiStopAnyDataStream()
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
 	/* Set the event mask to the stream enable events */
-	uint32_t eventMask = ADI_GENERIC_STREAM_ENABLE|ADI_RT_STREAM_ENABLE|ADI_BURST_STREAM_ENABLE|ADI_TRANSFER_STREAM_ENABLE|ADI_I2C_STREAM_ENABLE;
+	uint32_t eventMask = ADI_GENERIC_STREAM_ENABLE|ADI_RT_STREAM_ENABLE|ADI_BURST_STREAM_ENABLE|ADI_TRANSFER_STREAM_ENABLE|ADI_I2C_STREAM_ENABLE|ADI_BITBANG_STREAM_ENABLE|ADI_SEQ_STREAM_ENABLE|ADI_PIN_STREAM_ENABLE;
 
 	/* Variable to receive the event arguments into */
 	uint32_t eventFlags = 0;
@@ -129,13 +294,19 @@ CyBool_t AdiPrintStreamState()
   *
   * This function reads the I2C stream start request in from the control
   * endpoint. It parses out the stream parameters from the buffer and
-  * configures the Stream DMA channel for I2C -> USB, with an infinite
-  * transfer.
+  * configures the Stream DMA channel.
+  *
+  * The original request (read length, timeout, preamble, number of reads) streams each
+  * read as its own USB packet, with the I2C block DMA'd straight to USB. If the request is
+  * followed by the stream options (flags[0], flush latency in ms[1-2]) the reads are packed
+  * back to back into full USB buffers by the stream thread, and a buffer is sent early once
+  * its oldest read has waited for the flush latency. Each packed read can be prefixed with an
+  * ADI_I2C_STREAM_TIMESTAMP_LEN byte extended timer value (taken at the data ready edge, if enabled).
  **/
 CyU3PReturnStatus_t AdiI2CStreamStart()
 {
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	uint32_t timeout, index;
+	uint32_t timeout, index, recordLength;
 	uint16_t bytesRead;
 	CyU3PDmaChannelConfig_t i2cDmaConfig;
 
@@ -151,23 +322,57 @@ CyU3PReturnStatus_t AdiI2CStreamStart()
 	StreamThreadState.NumBuffers |= (USBBuffer[index + 2] << 16);
 	StreamThreadState.NumBuffers |= (USBBuffer[index + 3] << 24);
 
-	/* Disable VBUS ISR */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Optional packed stream options */
+	StreamThreadState.I2CPacked = CyFalse;
+	StreamThreadState.I2CTimestamp = CyFalse;
+	StreamThreadState.I2CFlushTicks = 0;
+	if(bytesRead >= (index + 7))
+	{
+		StreamThreadState.I2CPacked = CyTrue;
+		StreamThreadState.I2CTimestamp = (USBBuffer[index + 4] & ADI_I2C_STREAM_TIMESTAMP) ? CyTrue : CyFalse;
+		StreamThreadState.I2CFlushTicks = (USBBuffer[index + 5] | (USBBuffer[index + 6] << 8)) * MS_TO_TICKS_MULT;
+
+		/* Each read must fit in a single USB buffer */
+		recordLength = StreamThreadState.NumCaptures;
+		if(StreamThreadState.I2CTimestamp)
+			recordLength += ADI_I2C_STREAM_TIMESTAMP_LEN;
+		if((recordLength > FX3State.UsbBufferSize) || (StreamThreadState.NumCaptures == 0))
+		{
+			AdiLogError(StreamFunctions_c, __LINE__, CY_U3P_ERROR_BAD_ARGUMENT);
+			StreamThreadState.I2CPacked = CyFalse;
+		}
+	}
 
-	/* Disable GPIO interrupt before attaching interrupt to pin */
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
 
-	/* Re-init I2C block in DMA mode */
-	AdiI2CInit(FX3State.I2CBitRate, CyTrue);
+	/* Re-init I2C block (register mode for packed reads, DMA mode otherwise). Waits for any error log flash write to finish */
+	AdiFlashLock();
+	AdiI2CInit(FX3State.I2CBitRate, StreamThreadState.I2CPacked ? CyFalse : CyTrue);
+	AdiFlashUnlock();
 
 	/* Configure data ready interrupts */
 	if(FX3State.DrActive)
 		AdiConfigureDrPin();
 
-	/* Configure StreamChannel for I2C to USB automatic DMA */
-    CyU3PMemSet ((uint8_t *)&i2cDmaConfig, 0, sizeof(i2cDmaConfig));
-    i2cDmaConfig.size           = StreamThreadState.NumCaptures;
-    i2cDmaConfig.count          = 16;
+	/* Configure StreamChannel for I2C to USB automatic DMA, or CPU to USB for packed reads */
+	CyU3PMemSet ((uint8_t *)&i2cDmaConfig, 0, sizeof(i2cDmaConfig));
+	if(StreamThreadState.I2CPacked)
+	{
+		/* Apply I2C timeout (arguments are in microseconds) */
+		timeout = timeout * 1000;
+		CyU3PI2cSetTimeout(timeout, timeout, timeout);
+
+		i2cDmaConfig.size		= FX3State.UsbBufferSize;
+		i2cDmaConfig.count		= 8;
+		i2cDmaConfig.prodSckId	= CY_U3P_CPU_SOCKET_PROD;
+	}
+	else
+	{
+		i2cDmaConfig.size		= StreamThreadState.NumCaptures;
+		i2cDmaConfig.count		= 16;
+		i2cDmaConfig.prodSckId	= CY_U3P_LPP_SOCKET_I2C_PROD;
+	}
     i2cDmaConfig.prodAvailCount = 0;
     i2cDmaConfig.dmaMode        = CY_U3P_DMA_MODE_BYTE;
     i2cDmaConfig.prodHeader     = 0;
@@ -175,9 +380,8 @@ CyU3PReturnStatus_t AdiI2CStreamStart()
     i2cDmaConfig.consHeader     = 0;
     i2cDmaConfig.notification   = 0;
     i2cDmaConfig.cb             = NULL;
-    i2cDmaConfig.prodSckId = CY_U3P_LPP_SOCKET_I2C_PROD;
     i2cDmaConfig.consSckId = CY_U3P_UIB_SOCKET_CONS_1;
-    status = CyU3PDmaChannelCreate(&StreamingChannel, CY_U3P_DMA_TYPE_AUTO, &i2cDmaConfig);
+    status = CyU3PDmaChannelCreate(&StreamingChannel, StreamThreadState.I2CPacked ? CY_U3P_DMA_TYPE_MANUAL_OUT : CY_U3P_DMA_TYPE_AUTO, &i2cDmaConfig);
 	if(status != CY_U3P_SUCCESS)
 	{
 		AdiLogError(StreamFunctions_c, __LINE__, status);
@@ -224,14 +428,15 @@ CyU3PReturnStatus_t AdiI2CStreamFinished()
 	status |= CyU3PUsbFlushEp(ADI_STREAMING_ENDPOINT);
 
 	/* Re-init I2C in register mode */
+	AdiFlashLock();
 	AdiI2CInit(FX3State.I2CBitRate, CyFalse);
+	AdiFlashUnlock();
 
 	/* Clear all interrupt flags */
 	CyU3PVicClearInt();
 
-	/* Re-enable relevant ISRs */
-	CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-	CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Release the stream hold on the GPIO and VBUS ISRs */
+	AdiGpioRouterStreamMask(CyFalse);
 
 	/* Clear stream kill flag */
 	KillStreamEarly = CyFalse;
@@ -255,6 +460,9 @@ CyU3PReturnStatus_t AdiTransferStreamStart()
 	uint16_t bytesRead;
 	CyU3PDmaChannelConfig_t dmaConfig =  {0};
 
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
+
 	/* Get the data from the control endpoint */
 	status = CyU3PUsbGetEP0Data(StreamThreadState.TransferByteLength, USBBuffer, &bytesRead);
 	if(status != CY_U3P_SUCCESS)
@@ -290,11 +498,8 @@ CyU3PReturnStatus_t AdiTransferStreamStart()
 
 	AdiPrintStreamState();
 
-	/* Disable VBUS ISR */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
-
-	/* Disable GPIO interrupt before attaching interrupt to pin */
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
 
 	/* If using DR triggering configure the selected pin as an input with the correct polarity */
 	if(FX3State.DrActive)
@@ -372,6 +577,500 @@ CyU3PReturnStatus_t AdiTransferStreamFinished()
 	return status;
 }
 
+/**
+  * @brief Starts a bit bang SPI stream.
+  *
+  * @return A status code indicating the success of the bit bang stream start.
+  *
+  * A bit bang SPI stream repeats a configured bit bang SPI transaction on each data ready edge (if DrActive is
+  * set), or back to back, paced by the transaction stall time, if DrActive is not set. The received MISO data
+  * is packed (8 bits per byte) and sent to the PC over the streaming endpoint, using the same packaging and stop
+  * semantics as the transfer stream. The stream info is read in from EP0 into the USBBuffer, and must remain
+  * there for the duration of the stream. The data is formatted as NumCaptures[0-3], NumBuffers[4-7],
+  * BytesPerUSBBuffer[8-11], BitBangFlags[12-13], bit bang SPI config[14-39], packed MOSI data[40 - ...].
+ **/
+CyU3PReturnStatus_t AdiBitBangStreamStart()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t bytesRead;
+	uint16_t flags;
+	uint32_t bytesPerTransaction;
+	uint32_t bytesPerUsbPacket;
+	CyU3PDmaChannelConfig_t dmaConfig =  {0};
+
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
+
+	/* Get the data from the control endpoint */
+	status = CyU3PUsbGetEP0Data(StreamThreadState.TransferByteLength, USBBuffer, &bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Number of transactions per data ready */
+	StreamThreadState.NumCaptures = USBBuffer[0];
+	StreamThreadState.NumCaptures |= (USBBuffer[1] << 8);
+	StreamThreadState.NumCaptures |= (USBBuffer[2] << 16);
+	StreamThreadState.NumCaptures |= (USBBuffer[3] << 24);
+
+	/* Total number of buffers (data ready's) to capture */
+	StreamThreadState.NumBuffers = USBBuffer[4];
+	StreamThreadState.NumBuffers |= (USBBuffer[5] << 8);
+	StreamThreadState.NumBuffers |= (USBBuffer[6] << 16);
+	StreamThreadState.NumBuffers |= (USBBuffer[7] << 24);
+
+	/* Number of bytes to place in a single USB packet before transmitting (validated before storing in the 16 bit stream state) */
+	bytesPerUsbPacket = USBBuffer[8];
+	bytesPerUsbPacket |= (USBBuffer[9] << 8);
+	bytesPerUsbPacket |= (USBBuffer[10] << 16);
+	bytesPerUsbPacket |= (USBBuffer[11] << 24);
+
+	/* Bit bang options and transaction config */
+	flags = USBBuffer[12];
+	flags |= (USBBuffer[13] << 8);
+	AdiBitBangSpiParseConfig(USBBuffer + 14, flags, &BitBangStreamConfig);
+
+	/* Validate the transaction fits in the MOSI data and in a single USB packet */
+	bytesPerTransaction = ((BitBangStreamConfig.BitsPerTransfer * BitBangStreamConfig.NumTransfers) + 7) >> 3;
+	if((BitBangStreamConfig.BitsPerTransfer == 0) ||
+		(BitBangStreamConfig.NumTransfers == 0) ||
+		(StreamThreadState.TransferByteLength < ADI_BITBANG_STREAM_HEADER_LEN) ||
+		(bytesPerTransaction > (uint32_t) (StreamThreadState.TransferByteLength - ADI_BITBANG_STREAM_HEADER_LEN)) ||
+		(bytesPerTransaction > bytesPerUsbPacket) ||
+		(bytesPerUsbPacket > FX3State.UsbBufferSize))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+	StreamThreadState.BytesPerUsbPacket = (uint16_t) bytesPerUsbPacket;
+
+	AdiPrintStreamState();
+
+	/* Configure the bit bang SPI pins */
+	status = AdiBitBangSpiSetup(BitBangStreamConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiBitBangSpiEnd();
+		return status;
+	}
+
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
+
+	/* If using DR triggering configure the selected pin as an input with the correct polarity */
+	if(FX3State.DrActive)
+	{
+		/* Configure the pin as an input with interrupts enabled on the selected edge */
+		AdiConfigureDrPin();
+	}
+
+	/* Flush the streaming endpoint */
+	status = CyU3PUsbFlushEp(ADI_STREAMING_ENDPOINT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Configure the StreamingChannel DMA (CPU to PC) */
+	CyU3PMemSet ((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size 				= FX3State.UsbBufferSize;
+	dmaConfig.count 			= 8;
+	dmaConfig.prodSckId 		= CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId 		= CY_U3P_UIB_SOCKET_CONS_1;
+	dmaConfig.dmaMode 			= CY_U3P_DMA_MODE_BYTE;
+	dmaConfig.prodHeader    	= 0;
+	dmaConfig.prodFooter    	= 0;
+	dmaConfig.consHeader    	= 0;
+	dmaConfig.notification  	= 0;
+	dmaConfig.cb            	= NULL;
+	dmaConfig.prodAvailCount	= 0;
+
+	CyU3PDmaChannelDestroy(&StreamingChannel);
+	status = CyU3PDmaChannelCreate(&StreamingChannel, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Set DMA transfer mode */
+	status = CyU3PDmaChannelSetXfer(&StreamingChannel, 0);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Enable bit bang data capture thread */
+	status = CyU3PEventSet(&EventHandler, ADI_BITBANG_STREAM_ENABLE, CYU3P_EVENT_OR);
+
+	/* Return status code */
+	return status;
+}
+
+/**
+  * @brief Cleans up a bit bang SPI stream.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Releases the bit bang SPI timer (if used), then calls the generic stream finished implementation,
+  * since the same DMA and interrupt resources are used.
+ **/
+CyU3PReturnStatus_t AdiBitBangStreamFinished()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Restore the timer, if it was used for the bit bang SCLK */
+	AdiBitBangSpiEnd();
+
+	/* Call generic stream finished, since the same resources are used */
+	status = AdiGenericStreamFinished();
+
+	/* Return status code */
+	return status;
+}
+
+/**
+  * @brief Starts a SPI micro-sequencer stream.
+  *
+  * @return A status code indicating the success of the sequencer stream start.
+  *
+  * A sequencer stream runs the uploaded sequencer script NumCaptures times on each data ready edge (if DrActive
+  * is set), or back to back if DrActive is not set. The data captured by each run is sent to the PC over the
+  * streaming endpoint, using the same packaging and stop semantics as the transfer stream. The stream info is
+  * read in from EP0, formatted as NumCaptures[0-3], NumBuffers[4-7], BytesPerUSBBuffer[8-11].
+ **/
+CyU3PReturnStatus_t AdiSpiSeqStreamStart()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	uint16_t bytesRead;
+	uint32_t captureLen;
+	CyU3PDmaChannelConfig_t dmaConfig =  {0};
+
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
+
+	/* Get the data from the control endpoint */
+	status = CyU3PUsbGetEP0Data(StreamThreadState.TransferByteLength, USBBuffer, &bytesRead);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Number of script runs per data ready */
+	StreamThreadState.NumCaptures = USBBuffer[0];
+	StreamThreadState.NumCaptures |= (USBBuffer[1] << 8);
+	StreamThreadState.NumCaptures |= (USBBuffer[2] << 16);
+	StreamThreadState.NumCaptures |= (USBBuffer[3] << 24);
+
+	/* Total number of buffers (data ready's) to capture */
+	StreamThreadState.NumBuffers = USBBuffer[4];
+	StreamThreadState.NumBuffers |= (USBBuffer[5] << 8);
+	StreamThreadState.NumBuffers |= (USBBuffer[6] << 16);
+	StreamThreadState.NumBuffers |= (USBBuffer[7] << 24);
+
+	/* Number of bytes to place in a single USB packet before transmitting */
+	StreamThreadState.BytesPerUsbPacket = USBBuffer[8];
+	StreamThreadState.BytesPerUsbPacket |= (USBBuffer[9] << 8);
+
+	/* Validate a script is loaded, and a single run fits in a USB packet */
+	captureLen = AdiSpiSeqGetCaptureLength();
+	if((captureLen == 0) ||
+		(captureLen > StreamThreadState.BytesPerUsbPacket) ||
+		(StreamThreadState.BytesPerUsbPacket > FX3State.UsbBufferSize))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	AdiPrintStreamState();
+
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
+
+	/* If using DR triggering configure the selected pin as an input with the correct polarity */
+	if(FX3State.DrActive)
+	{
+		/* Configure the pin as an input with interrupts enabled on the selected edge */
+		AdiConfigureDrPin();
+	}
+
+	/* Flush the streaming endpoint */
+	status = CyU3PUsbFlushEp(ADI_STREAMING_ENDPOINT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Configure the StreamingChannel DMA (CPU to PC) */
+	CyU3PMemSet ((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size 				= FX3State.UsbBufferSize;
+	dmaConfig.count 			= 8;
+	dmaConfig.prodSckId 		= CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId 		= CY_U3P_UIB_SOCKET_CONS_1;
+	dmaConfig.dmaMode 			= CY_U3P_DMA_MODE_BYTE;
+	dmaConfig.prodHeader    	= 0;
+	dmaConfig.prodFooter    	= 0;
+	dmaConfig.consHeader    	= 0;
+	dmaConfig.notification  	= 0;
+	dmaConfig.cb            	= NULL;
+	dmaConfig.prodAvailCount	= 0;
+
+	CyU3PDmaChannelDestroy(&StreamingChannel);
+	status = CyU3PDmaChannelCreate(&StreamingChannel, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Set DMA transfer mode */
+	status = CyU3PDmaChannelSetXfer(&StreamingChannel, 0);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Enable sequencer data capture thread */
+	status = CyU3PEventSet(&EventHandler, ADI_SEQ_STREAM_ENABLE, CYU3P_EVENT_OR);
+
+	/* Return status code */
+	return status;
+}
+
+/**
+  * @brief Cleans up a SPI micro-sequencer stream.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * This function currently just calls the GenericStreamFinished implementation, since the same
+  * DMA and interrupt resources are used.
+ **/
+CyU3PReturnStatus_t AdiSpiSeqStreamFinished()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Call generic stream finished, since the same resources are used */
+	status = AdiGenericStreamFinished();
+
+	/* Return status code */
+	return status;
+}
+
+/**
+  * @brief Starts an edge timestamp stream.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Request data (read into USBBuffer by the control endpoint handler) is formatted as number of
+  * buffers[0-3], bytes per USB packet[4-7] (multiple of ADI_EDGE_RECORD_LEN), pin[8-9], edge[10]
+  * (0 = falling, 1 = rising, 2 = both). Each USB packet is filled with edge timestamp records.
+  * The stream is stopped and cleaned up using the generic stream events.
+ **/
+CyU3PReturnStatus_t AdiEdgeStreamStart()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PDmaChannelConfig_t dmaConfig =  {0};
+	uint16_t pin;
+	uint8_t edge;
+
+	/* Total number of buffers (USB packets) to capture */
+	StreamThreadState.NumBuffers = USBBuffer[0];
+	StreamThreadState.NumBuffers |= (USBBuffer[1] << 8);
+	StreamThreadState.NumBuffers |= (USBBuffer[2] << 16);
+	StreamThreadState.NumBuffers |= (USBBuffer[3] << 24);
+
+	/* Number of bytes to place in a single USB packet before transmitting */
+	StreamThreadState.BytesPerUsbPacket = USBBuffer[4];
+	StreamThreadState.BytesPerUsbPacket |= (USBBuffer[5] << 8);
+	StreamThreadState.BytesPerUsbPacket |= (USBBuffer[6] << 16);
+	StreamThreadState.BytesPerUsbPacket |= (USBBuffer[7] << 24);
+
+	pin = USBBuffer[8];
+	pin |= (USBBuffer[9] << 8);
+	edge = USBBuffer[10];
+
+	/* Validate settings */
+	if((StreamThreadState.NumBuffers == 0) ||
+		(StreamThreadState.BytesPerUsbPacket < ADI_EDGE_RECORD_LEN) ||
+		(StreamThreadState.BytesPerUsbPacket % ADI_EDGE_RECORD_LEN) ||
+		(StreamThreadState.BytesPerUsbPacket > FX3State.UsbBufferSize) ||
+		(edge > 2) ||
+		!AdiIsValidGPIO(pin))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	AdiPrintStreamState();
+
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
+
+	/* Flush the streaming endpoint */
+	status = CyU3PUsbFlushEp(ADI_STREAMING_ENDPOINT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Configure the StreamingChannel DMA (CPU to PC) */
+	CyU3PMemSet ((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size 				= FX3State.UsbBufferSize;
+	dmaConfig.count 			= 8;
+	dmaConfig.prodSckId 		= CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId 		= CY_U3P_UIB_SOCKET_CONS_1;
+	dmaConfig.dmaMode 			= CY_U3P_DMA_MODE_BYTE;
+	dmaConfig.prodHeader    	= 0;
+	dmaConfig.prodFooter    	= 0;
+	dmaConfig.consHeader    	= 0;
+	dmaConfig.notification  	= 0;
+	dmaConfig.cb            	= NULL;
+	dmaConfig.prodAvailCount	= 0;
+
+	CyU3PDmaChannelDestroy(&StreamingChannel);
+	status = CyU3PDmaChannelCreate(&StreamingChannel, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Set DMA transfer mode */
+	status = CyU3PDmaChannelSetXfer(&StreamingChannel, 0);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Attach the edge interrupt to the pin and reset the timer (timestamps are relative to stream start) */
+	AdiEdgeCaptureInit(&EdgeStreamState, pin, edge);
+	EdgeStreamState.StopOnStreamKill = CyTrue;
+
+	/* Enable edge capture thread */
+	status = CyU3PEventSet(&EventHandler, ADI_PIN_STREAM_ENABLE, CYU3P_EVENT_OR);
+
+	/* Return status code */
+	return status;
+}
+
+/**
+  * @brief Starts a logic analyzer stream of the mapped iSensor DIO and FX3 GPIO pins.
+  *
+  * @return A status code indicating the success of the function.
+  *
+  * Request data (read into USBBuffer by the control endpoint handler) is formatted as number of
+  * buffers[0-3], bytes per USB packet[4-7], sample period in 10MHz timer ticks[8-11], and flush
+  * time in ms[12-15] (max time a partially filled packet is held, 0 = only send full packets).
+  * Each USB packet holds a header and run length encoded pin samples (see LogicCapture.h).
+  * The stream is stopped and cleaned up using the generic stream events.
+ **/
+CyU3PReturnStatus_t AdiLogicStreamStart()
+{
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyU3PDmaChannelConfig_t dmaConfig =  {0};
+	uint32_t samplePeriod, flushMs;
+
+	/* Total number of buffers (USB packets) to capture */
+	StreamThreadState.NumBuffers = USBBuffer[0];
+	StreamThreadState.NumBuffers |= (USBBuffer[1] << 8);
+	StreamThreadState.NumBuffers |= (USBBuffer[2] << 16);
+	StreamThreadState.NumBuffers |= (USBBuffer[3] << 24);
+
+	/* Number of bytes to place in a single USB packet before transmitting */
+	StreamThreadState.BytesPerUsbPacket = USBBuffer[4];
+	StreamThreadState.BytesPerUsbPacket |= (USBBuffer[5] << 8);
+
+	samplePeriod = USBBuffer[8];
+	samplePeriod |= (USBBuffer[9] << 8);
+	samplePeriod |= (USBBuffer[10] << 16);
+	samplePeriod |= (USBBuffer[11] << 24);
+
+	flushMs = USBBuffer[12];
+	flushMs |= (USBBuffer[13] << 8);
+	flushMs |= (USBBuffer[14] << 16);
+	flushMs |= (USBBuffer[15] << 24);
+
+	/* Validate settings */
+	if((StreamThreadState.NumBuffers == 0) ||
+		(StreamThreadState.BytesPerUsbPacket < (ADI_LOGIC_HEADER_LEN + ADI_LOGIC_RECORD_LEN)) ||
+		(StreamThreadState.BytesPerUsbPacket > FX3State.UsbBufferSize))
+	{
+		status = CY_U3P_ERROR_BAD_ARGUMENT;
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	/* Sample the pins from the start of the stream */
+	status = AdiLogicCaptureInit(&LogicStreamState, samplePeriod, flushMs);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		return status;
+	}
+
+	AdiPrintStreamState();
+
+	/* Mask the VBUS and GPIO ISRs */
+	AdiGpioRouterStreamMask(CyTrue);
+
+	/* Flush the streaming endpoint */
+	status = CyU3PUsbFlushEp(ADI_STREAMING_ENDPOINT);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Configure the StreamingChannel DMA (CPU to PC) */
+	CyU3PMemSet ((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size 				= FX3State.UsbBufferSize;
+	dmaConfig.count 			= 8;
+	dmaConfig.prodSckId 		= CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId 		= CY_U3P_UIB_SOCKET_CONS_1;
+	dmaConfig.dmaMode 			= CY_U3P_DMA_MODE_BYTE;
+	dmaConfig.prodHeader    	= 0;
+	dmaConfig.prodFooter    	= 0;
+	dmaConfig.consHeader    	= 0;
+	dmaConfig.notification  	= 0;
+	dmaConfig.cb            	= NULL;
+	dmaConfig.prodAvailCount	= 0;
+
+	CyU3PDmaChannelDestroy(&StreamingChannel);
+	status = CyU3PDmaChannelCreate(&StreamingChannel, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Set DMA transfer mode */
+	status = CyU3PDmaChannelSetXfer(&StreamingChannel, 0);
+	if(status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamFunctions_c, __LINE__, status);
+		AdiAppErrorHandler(status);
+	}
+
+	/* Enable logic capture thread */
+	status = CyU3PEventSet(&EventHandler, ADI_PIN_STREAM_ENABLE, CYU3P_EVENT_OR);
+
+	/* Return status code */
+	return status;
+}
+
 /**
   * @brief Starts a real time stream for ADcmXLx021 DUTs
   *
@@ -390,11 +1089,14 @@ CyU3PReturnStatus_t AdiRealTimeStreamStart()
 	CyU3PGpioSimpleConfig_t gpioConfig = {0};
 	CyU3PDmaChannelConfig_t dmaConfig = {0};
 
-	/* Disable GPIO ISR (Interrupt functionality still active) */
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
+
+	/* The sync strobe (if enabled) starts with the first frame */
+	AdiSyncStrobeStreamStart();
 
-	/* Disable VBUS ISR */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Mask the GPIO ISR (Interrupt functionality still active) and VBUS ISR */
+	AdiGpioRouterStreamMask(CyTrue);
 
 	/* Clear all interrupt flags */
 	CyU3PVicClearInt();
@@ -641,9 +1343,8 @@ CyU3PReturnStatus_t AdiRealTimeStreamFinished()
 	/* Clear all interrupt flags */
 	CyU3PVicClearInt();
 
-	/* Re-enable relevant ISRs */
-	CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-	CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Release the stream hold on the GPIO and VBUS ISRs */
+	AdiGpioRouterStreamMask(CyFalse);
 
 	/* Restore the SPI state */
 	status = CyU3PSpiSetConfig(&FX3State.SpiConfig, NULL);
@@ -674,11 +1375,14 @@ CyU3PReturnStatus_t AdiBurstStreamStart()
 	uint16_t bytesRead;
 	uint16_t triggerLength;
 
-	/* Disable VBUS ISR */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
 
-	/* Disable GPIO interrupt before attaching interrupt to pin */
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* The sync strobe (if enabled) starts with the first frame */
+	AdiSyncStrobeStreamStart();
+
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
 
 	/* Make sure the global data ready pin is configured as an input and attach the interrupt to the correct edge */
 	if(FX3State.DrActive)
@@ -874,9 +1578,8 @@ CyU3PReturnStatus_t AdiBurstStreamFinished()
 	/* Clear all interrupt flags */
 	CyU3PVicClearInt();
 
-	/* Re-enable relevant ISRs */
-	CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-	CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Release the stream hold on the GPIO and VBUS ISRs */
+	AdiGpioRouterStreamMask(CyFalse);
 
 	/* Restore the SPI state */
 	AdiSetSpiWordLength(FX3State.SpiConfig.wordLen);
@@ -901,11 +1604,14 @@ CyU3PReturnStatus_t AdiGenericStreamStart()
 	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 	CyU3PDmaChannelConfig_t dmaConfig = {0};
 
-	/* Disable VBUS ISR */
-	CyU3PVicDisableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Stream SPI traffic bypasses the register cache */
+	AdiRegCacheInvalidate();
+
+	/* The sync strobe (if enabled) starts with the first frame */
+	AdiSyncStrobeStreamStart();
 
-	/* Disable GPIO interrupt before attaching interrupt to pin */
-	CyU3PVicDisableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
+	/* Mask the VBUS and GPIO ISRs before attaching interrupt to pin */
+	AdiGpioRouterStreamMask(CyTrue);
 
 	if(FX3State.DrActive)
 	{
@@ -1042,9 +1748,11 @@ CyU3PReturnStatus_t AdiGenericStreamFinished()
 	/* Clear all interrupt flags */
 	CyU3PVicClearInt();
 
-	/* Re-enable relevant ISRs */
-	CyU3PVicEnableInt(CY_U3P_VIC_GPIO_CORE_VECTOR);
-	CyU3PVicEnableInt(CY_U3P_VIC_GCTL_PWR_VECTOR);
+	/* Return the timer to free running mode, if the stream was stopped before it could */
+	AdiTimerRelease();
+
+	/* Release the stream hold on the GPIO and VBUS ISRs */
+	AdiGpioRouterStreamMask(CyFalse);
 
 	/* Reset KillStreamEarly flag in case the user wants to capture data again */
 	KillStreamEarly = CyFalse;
@@ -42,13 +42,27 @@ CyU3PReturnStatus_t AdiBurstStreamFinished();
 CyU3PReturnStatus_t AdiI2CStreamStart();
 CyU3PReturnStatus_t AdiI2CStreamFinished();
 
+/* Bit bang SPI stream functions */
+CyU3PReturnStatus_t AdiBitBangStreamStart();
+CyU3PReturnStatus_t AdiBitBangStreamFinished();
+
+/* SPI micro-sequencer stream functions */
+CyU3PReturnStatus_t AdiSpiSeqStreamStart();
+CyU3PReturnStatus_t AdiSpiSeqStreamFinished();
+
+/* Pin capture stream functions */
+CyU3PReturnStatus_t AdiEdgeStreamStart();
+CyU3PReturnStatus_t AdiLogicStreamStart();
+
 /* General stream functions. */
 CyU3PReturnStatus_t AdiStopAnyDataStream();
+CyBool_t AdiIsStreamStart(uint8_t bRequest, uint16_t wIndex);
 CyBool_t AdiPrintStreamState();
 CyU3PReturnStatus_t AdiConfigureDrPin();
 
 /* Config functions */
 void AdiConfigStreamStallTimer();
+CyU3PReturnStatus_t AdiConfigureSyncStrobe(uint16_t transferLength);
 
 /*
  * Stream action commands
@@ -63,4 +77,22 @@ void AdiConfigStreamStallTimer();
 /** Control endpoint index value to asynchronously stop a stream. */
 #define ADI_STREAM_STOP_CMD						2
 
+/** I2C stream option flag: prefix each read with the extended timer value when it started */
+#define ADI_I2C_STREAM_TIMESTAMP				(1 << 0)
+
+/** Length of the packed I2C stream read timestamp */
+#define ADI_I2C_STREAM_TIMESTAMP_LEN			(8)
+
+/** Max sync strobe pulse width, in microseconds */
+#define ADI_SYNC_STROBE_MAX_WIDTH				(1000)
+
+/** Number of bytes of stream parameters ahead of the packed MOSI data in a bit bang SPI stream start request */
+#define ADI_BITBANG_STREAM_HEADER_LEN			(14 + ADI_BITBANG_HEADER_LEN)
+
+/** Pin capture stream type for an edge timestamp stream */
+#define ADI_PIN_STREAM_EDGE						(0)
+
+/** Pin capture stream type for a logic analyzer stream */
+#define ADI_PIN_STREAM_LOGIC					(1)
+
 #endif
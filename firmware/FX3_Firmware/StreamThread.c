@@ -24,6 +24,12 @@ static CyU3PReturnStatus_t AdiRealTimeStreamWork();
 static CyU3PReturnStatus_t AdiBurstStreamWork();
 static CyU3PReturnStatus_t AdiTransferStreamWork();
 static CyU3PReturnStatus_t AdiI2CStreamWork();
+static CyU3PReturnStatus_t AdiI2CPackedStreamWork();
+static CyU3PReturnStatus_t AdiBitBangStreamWork();
+static CyU3PReturnStatus_t AdiSpiSeqStreamWork();
+static CyU3PReturnStatus_t AdiEdgeStreamWork();
+static CyU3PReturnStatus_t AdiLogicStreamWork();
+static inline void AdiSyncStrobe();
 
 /* Tell the compiler where to find the needed globals */
 extern CyU3PEvent EventHandler;
@@ -33,6 +39,9 @@ extern CyU3PDmaBuffer_t SpiDmaBuffer;
 extern BoardState FX3State;
 extern volatile CyBool_t KillStreamEarly;
 extern StreamState StreamThreadState;
+extern BitBangSpiConf BitBangStreamConfig;
+extern EdgeCaptureState EdgeStreamState;
+extern LogicCaptureState LogicStreamState;
 extern uint8_t USBBuffer[4096];
 
 /**
@@ -49,7 +58,7 @@ void AdiStreamThreadEntry(uint32_t input)
 	UNUSED(input);
 
 	/* Set the event mask to the stream enable events */
-	uint32_t eventMask = ADI_GENERIC_STREAM_ENABLE|ADI_RT_STREAM_ENABLE|ADI_BURST_STREAM_ENABLE|ADI_TRANSFER_STREAM_ENABLE|ADI_I2C_STREAM_ENABLE;
+	uint32_t eventMask = ADI_GENERIC_STREAM_ENABLE|ADI_RT_STREAM_ENABLE|ADI_BURST_STREAM_ENABLE|ADI_TRANSFER_STREAM_ENABLE|ADI_I2C_STREAM_ENABLE|ADI_BITBANG_STREAM_ENABLE|ADI_SEQ_STREAM_ENABLE|ADI_PIN_STREAM_ENABLE;
 
 	/* Variable to receive the event arguments into */
 	uint32_t eventFlag;
@@ -59,6 +68,8 @@ void AdiStreamThreadEntry(uint32_t input)
 		/* Wait indefinitely for any flag to be set */
 		if (CyU3PEventGet(&EventHandler, eventMask, CYU3P_EVENT_OR_CLEAR, &eventFlag, CYU3P_WAIT_FOREVER) == CY_U3P_SUCCESS)
 		{
+			StreamThreadState.StreamActive = CyTrue;
+
 			/* Real-time (ADcmXL) stream case */
 			if (eventFlag & ADI_RT_STREAM_ENABLE)
 			{
@@ -94,9 +105,47 @@ void AdiStreamThreadEntry(uint32_t input)
 			/* I2C stream case */
 			else if (eventFlag & ADI_I2C_STREAM_ENABLE)
 			{
-				AdiI2CStreamWork();
+				if(StreamThreadState.I2CPacked)
+				{
+					AdiI2CPackedStreamWork();
+				}
+				else
+				{
+					AdiI2CStreamWork();
+				}
 #ifdef VERBOSE_MODE
 				CyU3PDebugPrint (4, "Finished I2C stream work\r\n");
+#endif
+			}
+			/* Bit bang SPI stream case */
+			else if (eventFlag & ADI_BITBANG_STREAM_ENABLE)
+			{
+				AdiBitBangStreamWork();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Finished bit bang stream work\r\n");
+#endif
+			}
+			/* SPI micro-sequencer stream case */
+			else if (eventFlag & ADI_SEQ_STREAM_ENABLE)
+			{
+				AdiSpiSeqStreamWork();
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Finished sequencer stream work\r\n");
+#endif
+			}
+			/* Pin capture (edge timestamp or logic analyzer) stream case */
+			else if (eventFlag & ADI_PIN_STREAM_ENABLE)
+			{
+				if(StreamThreadState.PinStreamType == ADI_PIN_STREAM_LOGIC)
+				{
+					AdiLogicStreamWork();
+				}
+				else
+				{
+					AdiEdgeStreamWork();
+				}
+#ifdef VERBOSE_MODE
+				CyU3PDebugPrint (4, "Finished pin stream work\r\n");
 #endif
 			}
 			else
@@ -107,6 +156,12 @@ void AdiStreamThreadEntry(uint32_t input)
 				CyU3PDebugPrint (4, "ERROR: Unhandled StreamThread event generated. eventFlag: 0x%x\r\n", eventFlag);
 #endif
 			}
+
+			/* Stream workers re-set their enable event until the stream is done */
+			if(CyU3PEventGet(&EventHandler, eventMask, CYU3P_EVENT_OR, &eventFlag, CYU3P_NO_WAIT) != CY_U3P_SUCCESS)
+			{
+				StreamThreadState.StreamActive = CyFalse;
+			}
 		}
         /* Allow other ready threads to run. */
         CyU3PThreadRelinquish();
@@ -135,6 +190,8 @@ static CyU3PReturnStatus_t AdiI2CStreamWork()
 		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
 		/* Loop until interrupt is triggered */
 		while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)));
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
 	}
 
 	/* Start new I2C DMA transfer */
@@ -170,6 +227,148 @@ static CyU3PReturnStatus_t AdiI2CStreamWork()
 	return status;
 }
 
+/**
+  * @brief Checks if a partially filled packed I2C stream buffer is due to be sent.
+  *
+  * @param firstReadTime The extended timer value when the first read in the buffer was taken
+  *
+  * @param byteCount The number of bytes in the buffer
+  *
+  * @return CyTrue if the buffer holds data which has waited for the flush latency
+ **/
+static inline CyBool_t AdiI2CFlushDue(uint64_t firstReadTime, uint32_t byteCount)
+{
+	if((byteCount == 0) || (StreamThreadState.I2CFlushTicks == 0))
+		return CyFalse;
+
+	return ((AdiGetTicks64() - firstReadTime) >= StreamThreadState.I2CFlushTicks);
+}
+
+/**
+  * @brief This is the worker function for the packed I2C read stream.
+  *
+  * @return A status code representing the success of the I2C stream operation.
+  *
+  * This function fills a single USB buffer with back to back I2C reads, optionally each prefixed
+  * with a timestamp. The buffer is sent once the next read will not fit, once the oldest read in
+  * it has waited for the flush latency, or at the end of the stream. While waiting for data ready
+  * the flush latency is still checked, so a slow data ready never holds data back.
+ **/
+static CyU3PReturnStatus_t AdiI2CPackedStreamWork()
+{
+	/* Track the number of reads performed */
+	static uint32_t numReads = 0;
+
+	/* DMA buffer structure for the active buffer for the streaming DMA channel */
+	CyU3PDmaBuffer_t StreamChannelBuffer = {0};
+
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+	CyBool_t streamDone = CyFalse;
+	CyBool_t flush = CyFalse;
+	uint32_t recordLength, byteCount;
+	uint64_t readTime, firstReadTime = 0;
+	uint8_t * recordPtr;
+
+	recordLength = StreamThreadState.NumCaptures;
+	if(StreamThreadState.I2CTimestamp)
+		recordLength += ADI_I2C_STREAM_TIMESTAMP_LEN;
+
+	/* Get a buffer */
+	status = CyU3PDmaChannelGetBuffer(&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+	if (status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamThread_c, __LINE__, status);
+	}
+	recordPtr = StreamChannelBuffer.buffer;
+	byteCount = 0;
+
+	while(((byteCount + recordLength) <= FX3State.UsbBufferSize) && !streamDone && !flush)
+	{
+		/* Wait for DR if enabled (give up to send a partial buffer, or to stop) */
+		if (FX3State.DrActive)
+		{
+			/* Clear GPIO interrupts */
+			GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+			/* Loop until interrupt is triggered */
+			while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)))
+			{
+				if(KillStreamEarly || AdiI2CFlushDue(firstReadTime, byteCount))
+				{
+					flush = CyTrue;
+					break;
+				}
+			}
+			if(flush)
+				break;
+			/* Count the edge (the GPIO ISR is masked while streaming) */
+			AdiGpioRouterCountEdge(FX3State.DrPin);
+		}
+
+		readTime = AdiGetTicks64();
+		if(byteCount == 0)
+			firstReadTime = readTime;
+		if(StreamThreadState.I2CTimestamp)
+		{
+			AdiTicks64ToBuffer(readTime, recordPtr);
+			recordPtr += ADI_I2C_STREAM_TIMESTAMP_LEN;
+		}
+
+		/* Read straight into the USB buffer */
+		status = CyU3PI2cReceiveBytes(&StreamThreadState.I2CStreamPreamble, recordPtr, StreamThreadState.NumCaptures, FX3State.I2CRetryCount);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(StreamThread_c, __LINE__, status);
+		}
+		recordPtr += StreamThreadState.NumCaptures;
+		byteCount += recordLength;
+		numReads++;
+
+		/* 0 reads requested streams until stopped */
+		if(((StreamThreadState.NumBuffers != 0) && (numReads >= StreamThreadState.NumBuffers)) || KillStreamEarly)
+		{
+			streamDone = CyTrue;
+		}
+		else
+		{
+			flush = AdiI2CFlushDue(firstReadTime, byteCount);
+		}
+	}
+
+	/* Send the packed reads (a short packet marks the end of the buffer) */
+	if(byteCount)
+	{
+		status = CyU3PDmaChannelCommitBuffer(&StreamingChannel, byteCount, 0);
+		if (status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(StreamThread_c, __LINE__, status);
+		}
+	}
+
+	/* Check to see if we've performed all the reads or if we were asked to stop data capture early */
+	if (streamDone || KillStreamEarly)
+	{
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Exiting stream thread, %d packed I2C reads performed.\r\n", numReads);
+#endif
+
+		/* Reset values */
+		numReads = 0;
+
+		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
+		if(KillStreamEarly)
+		{
+			CyU3PEventSet(&EventHandler, ADI_I2C_STREAM_DONE, CYU3P_EVENT_OR);
+		}
+	}
+	else
+	{
+		/* Reset flag */
+		CyU3PEventSet(&EventHandler, ADI_I2C_STREAM_ENABLE, CYU3P_EVENT_OR);
+	}
+
+	return status;
+}
+
 /**
   * @brief This is the worker function for the generic stream.
   *
@@ -201,6 +400,9 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 	/* track the current position within the MOSI (reglist) buffer */
 	uint8_t* MOSIPtr;
 
+	/* MISO data for the first transfer in the register list (not read back) */
+	uint8_t discardBuf[4];
+
 	/* If the stream channel buffer has not been set, get a new buffer */
 	if (MISOPtr == 0)
 	{
@@ -219,8 +421,14 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
 		/* Loop until interrupt is triggered */
 		while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)));
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
 	}
 
+	/* Start the SPI streaming session for this buffer. Closed before returning, so control endpoint
+	 * register accesses between buffers can use the SPI controller */
+	AdiSpiStreamSessionStart();
+
 	/* Run through the register list numCaptures times - this is one buffer */
 	for(captureCount = 0; captureCount < StreamThreadState.NumCaptures; captureCount++)
 	{
@@ -228,7 +436,7 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 		MOSIPtr = StreamThreadState.RegList;
 
 		/* Transmit the first words without reading back */
-		CyU3PSpiTransmitWords(MOSIPtr, 2);
+		AdiSpiStreamTransferWord(MOSIPtr, discardBuf);
 
 		/* Increment the MOSI pointer*/
 		MOSIPtr += 2;
@@ -245,7 +453,7 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 			while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
 
 			/* transfer words */
-			AdiSpiTransferWord(MOSIPtr, MISOPtr);
+			AdiSpiStreamTransferWord(MOSIPtr, MISOPtr);
 
 			/* Set the pin timer to 0 */
 			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
@@ -279,16 +487,22 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 					AdiLogError(StreamThread_c, __LINE__, status);
 				}
 
+				/* The buffer wait can block, so release the SPI controller while waiting */
+				AdiSpiStreamSessionEnd();
 				status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
 				if (status != CY_U3P_SUCCESS)
 				{
 					AdiLogError(StreamThread_c, __LINE__, status);
 				}
+				AdiSpiStreamSessionStart();
 				MISOPtr = StreamChannelBuffer.buffer;
 				byteCounter = 0;
 			}
 		}
 
+		/* Mark the frame on the sync strobe pin (overlaps the stall time) */
+		AdiSyncStrobe();
+
 		/* Wait for the complex GPIO timer to reach the stall time */
 		while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
 
@@ -298,6 +512,9 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
 	}
 
+	/* End the SPI streaming session */
+	AdiSpiStreamSessionEnd();
+
 	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
 	if((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
 	{
@@ -321,15 +538,8 @@ static CyU3PReturnStatus_t AdiGenericStreamWork()
 		/* Clear GPIO interrupts */
 		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
 
-		/* Clear timer interrupt */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
-
-		/* Update the threshold and period */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold = 0xFFFFFFFF;
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-
-		/* Disable interrupts */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
+		/* Return the timer to free running mode */
+		AdiTimerRelease();
 
 #ifdef VERBOSE_MODE
 		CyU3PDebugPrint (4, "Exiting stream thread, %d generic stream buffers read.\r\n", numBuffersRead + 1);
@@ -380,6 +590,8 @@ static CyU3PReturnStatus_t AdiRealTimeStreamWork()
 	{
 		interruptTriggered = ((CyBool_t)(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)) && (CyBool_t)(GPIO->lpp_gpio_simple[FX3State.DrPin] & CY_U3P_LPP_GPIO_IN_VALUE));
 	}
+	/* Count the edge (the GPIO ISR is masked while streaming) */
+	AdiGpioRouterCountEdge(FX3State.DrPin);
 
 	/* Set the config for DMA mode */
 	SPI->lpp_spi_config |= CY_U3P_LPP_SPI_DMA_MODE;
@@ -401,6 +613,9 @@ static CyU3PReturnStatus_t AdiRealTimeStreamWork()
 		AdiLogError(StreamThread_c, __LINE__, status);
 	}
 
+	/* Mark the frame on the sync strobe pin */
+	AdiSyncStrobe();
+
 	/* Check that we haven't captured the desired number of frames or were asked to kill the thread early */
 	if((numFramesCaptured >= (StreamThreadState.NumRealTimeCaptures - 1)) || KillStreamEarly)
 	{
@@ -482,6 +697,8 @@ static CyU3PReturnStatus_t AdiBurstStreamWork()
 		{
 			interruptTriggered = ((CyBool_t)(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)) || ((numBuffersRead == 0) && (GPIO->lpp_gpio_simple[FX3State.DrPin] & CY_U3P_LPP_GPIO_IN_VALUE)));
 		}
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
 	}
 
 	/* Set the config for DMA mode with RX and TX enabled */
@@ -504,6 +721,9 @@ static CyU3PReturnStatus_t AdiBurstStreamWork()
 		AdiLogError(StreamThread_c, __LINE__, status);
 	}
 
+	/* Mark the frame on the sync strobe pin */
+	AdiSyncStrobe();
+
 	/* Check that we haven't captured the desired number of frames or that we were asked to kill the thread early */
 	if((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
 	{
@@ -610,8 +830,14 @@ static CyU3PReturnStatus_t AdiTransferStreamWork()
 		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
 		/* Loop until interrupt is triggered */
 		while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)));
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
 	}
 
+	/* Start the SPI streaming session for this buffer. Closed before returning, so control endpoint
+	 * register accesses between buffers can use the SPI controller */
+	AdiSpiStreamSessionStart();
+
 	/* Set the pin timer to 0 */
 	GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
 	/* clear interrupt flag */
@@ -629,7 +855,7 @@ static CyU3PReturnStatus_t AdiTransferStreamWork()
 			while(!(GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status & CY_U3P_LPP_GPIO_INTR));
 
 			/* Transfer data */
-			AdiSpiTransferWord(MOSIData, bufPtr);
+			AdiSpiStreamTransferWord(MOSIData, bufPtr);
 
 			/* Set the pin timer to 0 */
 			GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].timer = 0;
@@ -655,18 +881,23 @@ static CyU3PReturnStatus_t AdiTransferStreamWork()
 					AdiLogError(StreamThread_c, __LINE__, status);
 				}
 
-				/* Get new buffer */
+				/* Get new buffer. The wait can block, so release the SPI controller while waiting */
+				AdiSpiStreamSessionEnd();
 				status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
 				if (status != CY_U3P_SUCCESS)
 				{
 					AdiLogError(StreamThread_c, __LINE__, status);
 				}
+				AdiSpiStreamSessionStart();
 				bufPtr = StreamChannelBuffer.buffer;
 				byteCounter = 0;
 			}
 		}
 	}
 
+	/* End the SPI streaming session */
+	AdiSpiStreamSessionEnd();
+
 	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
 	if ((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
 	{
@@ -692,15 +923,8 @@ static CyU3PReturnStatus_t AdiTransferStreamWork()
 		/* Clear GPIO interrupts */
 		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
 
-		/* Clear timer interrupt */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status |= CY_U3P_LPP_GPIO_INTR;
-
-		/* Update the threshold and period */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].threshold = 0xFFFFFFFF;
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].period = 0xFFFFFFFF;
-
-		/* Disable interrupts */
-		GPIO->lpp_gpio_pin[ADI_TIMER_PIN_INDEX].status &= ~(CY_U3P_LPP_GPIO_INTRMODE_MASK);
+		/* Return the timer to free running mode */
+		AdiTimerRelease();
 
 		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
 		if(KillStreamEarly)
@@ -723,4 +947,437 @@ static CyU3PReturnStatus_t AdiTransferStreamWork()
 	return status;
 }
 
+/**
+  * @brief This is the worker function for the bit bang SPI stream.
+  *
+  * @return A status code representing the success of the bit bang stream operation.
+  *
+  * Performs NumCaptures bit bang SPI transactions per data ready (or back to back, paced by the transaction
+  * stall time, if data ready triggering is disabled). The packed MISO data for each transaction is placed
+  * directly into the streaming DMA buffer. A DMA buffer is committed once the next transaction would not fit
+  * in BytesPerUsbPacket bytes. The packed MOSI data is stored in USBBuffer[40 ...] prior to this function being called.
+ **/
+static CyU3PReturnStatus_t AdiBitBangStreamWork()
+{
+	/* Track the current position within the DMA buffer*/
+	static uint8_t *bufPtr = 0;
+
+	/* Track the number of buffers read */
+	static uint32_t numBuffersRead = 0;
+
+	/* Track the number of bytes read into the current DMA buffer */
+	static uint32_t byteCounter = 0;
+
+	/* DMA buffer structure for the active buffer for the streaming DMA channel */
+	static CyU3PDmaBuffer_t StreamChannelBuffer = {0};
+
+	/* Return status code */
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Track current capture count */
+	uint32_t captureCount;
+
+	/* Number of packed MISO bytes per transaction */
+	uint32_t bytesPerTransaction;
+
+	/* If the stream channel buffer has not been set, get a new buffer */
+	if(bufPtr == 0)
+	{
+		/* get the buffer */
+		status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+		if (status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(StreamThread_c, __LINE__, status);
+		}
+		bufPtr = StreamChannelBuffer.buffer;
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Got the first bit bang stream DMA buffer, address = 0x%x\r\n", bufPtr);
+#endif
+	}
+
+	bytesPerTransaction = ((BitBangStreamConfig.BitsPerTransfer * BitBangStreamConfig.NumTransfers) + 7) >> 3;
+
+	/* Wait for DR if enabled */
+	if (FX3State.DrActive)
+	{
+		/* Clear GPIO interrupts */
+		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+		/* Loop until interrupt is triggered */
+		while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)));
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
+	}
+
+	for(captureCount = 0; captureCount < StreamThreadState.NumCaptures; captureCount++)
+	{
+		/* Perform the transaction, placing MISO data directly in the DMA buffer */
+		AdiBitBangSpiRun(USBBuffer + ADI_BITBANG_STREAM_HEADER_LEN, bufPtr, &BitBangStreamConfig);
+
+		/* Update counters and buffer pointers */
+		bufPtr += bytesPerTransaction;
+		byteCounter += bytesPerTransaction;
+
+		/* Check if a transmission is needed */
+		if ((byteCounter + bytesPerTransaction) > StreamThreadState.BytesPerUsbPacket)
+		{
+			/* Commit DMA buffer */
+			status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, FX3State.UsbBufferSize, 0);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+
+			/* Get new buffer */
+			status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+			bufPtr = StreamChannelBuffer.buffer;
+			byteCounter = 0;
+		}
+	}
+
+	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
+	if ((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
+	{
+
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Exiting stream thread, %d bit bang stream buffers read.\r\n", numBuffersRead + 1);
+#endif
+
+		/* Reset values */
+		numBuffersRead = 0;
+		/* Signal getting a new buffer */
+		bufPtr = 0;
+		if (byteCounter)
+		{
+			status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, FX3State.UsbBufferSize, 0);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+			byteCounter = 0;
+		}
+
+		/* Restore the timer, if it was used for the bit bang SCLK */
+		AdiBitBangSpiEnd();
+
+		/* Clear GPIO interrupts */
+		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+
+		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
+		if(KillStreamEarly)
+		{
+			CyU3PEventSet (&EventHandler, ADI_BITBANG_STREAM_DONE, CYU3P_EVENT_OR);
+		}
+	}
+	else
+	{
+		/* Increment buffer counter */
+		numBuffersRead++;
+		/* Reset flag */
+		CyU3PEventSet (&EventHandler, ADI_BITBANG_STREAM_ENABLE, CYU3P_EVENT_OR);
+	}
+	return status;
+}
+
+/**
+  * @brief This is the worker function for the SPI micro-sequencer stream.
+  *
+  * @return A status code representing the success of the sequencer stream operation.
+  *
+  * Runs the sequencer script NumCaptures times per data ready (or back to back), placing the
+  * captured data directly in the streaming DMA buffer. A failed run is logged, and the part of
+  * the capture it did not reach is zero filled, so the host data framing is never lost.
+ **/
+static CyU3PReturnStatus_t AdiSpiSeqStreamWork()
+{
+	/* Track the current position within the DMA buffer*/
+	static uint8_t *bufPtr = 0;
+
+	/* Track the number of buffers read */
+	static uint32_t numBuffersRead = 0;
+
+	/* Track the number of bytes read into the current DMA buffer */
+	static uint32_t byteCounter = 0;
+
+	/* DMA buffer structure for the active buffer for the streaming DMA channel */
+	static CyU3PDmaBuffer_t StreamChannelBuffer = {0};
+
+	/* Return status code */
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Track current capture count */
+	uint32_t captureCount;
+
+	/* Number of bytes captured per script run */
+	uint32_t bytesPerRun, bytesCaptured;
+
+	/* If the stream channel buffer has not been set, get a new buffer */
+	if(bufPtr == 0)
+	{
+		/* get the buffer */
+		status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+		if (status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(StreamThread_c, __LINE__, status);
+		}
+		bufPtr = StreamChannelBuffer.buffer;
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Got the first sequencer stream DMA buffer, address = 0x%x\r\n", bufPtr);
+#endif
+	}
+
+	bytesPerRun = AdiSpiSeqGetCaptureLength();
+
+	/* Wait for DR if enabled */
+	if (FX3State.DrActive)
+	{
+		/* Clear GPIO interrupts */
+		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+		/* Loop until interrupt is triggered */
+		while(!(GPIO->lpp_gpio_intr0 & (1 << FX3State.DrPin)));
+		/* Count the edge (the GPIO ISR is masked while streaming) */
+		AdiGpioRouterCountEdge(FX3State.DrPin);
+	}
+
+	for(captureCount = 0; captureCount < StreamThreadState.NumCaptures; captureCount++)
+	{
+		/* Run the script, placing captured data directly in the DMA buffer */
+		status = AdiSpiSeqExecute(bufPtr, &bytesCaptured);
+		if(status != CY_U3P_SUCCESS)
+		{
+			AdiLogError(StreamThread_c, __LINE__, status);
+			CyU3PMemSet(bufPtr + bytesCaptured, 0, bytesPerRun - bytesCaptured);
+		}
+
+		/* Update counters and buffer pointers */
+		bufPtr += bytesPerRun;
+		byteCounter += bytesPerRun;
+
+		/* Check if a transmission is needed */
+		if ((byteCounter + bytesPerRun) > StreamThreadState.BytesPerUsbPacket)
+		{
+			/* Commit DMA buffer */
+			status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, FX3State.UsbBufferSize, 0);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+
+			/* Get new buffer */
+			status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+			bufPtr = StreamChannelBuffer.buffer;
+			byteCounter = 0;
+		}
+	}
+
+	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
+	if ((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
+	{
+
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Exiting stream thread, %d sequencer stream buffers read.\r\n", numBuffersRead + 1);
+#endif
+
+		/* Reset values */
+		numBuffersRead = 0;
+		/* Signal getting a new buffer */
+		bufPtr = 0;
+		if (byteCounter)
+		{
+			status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, FX3State.UsbBufferSize, 0);
+			if (status != CY_U3P_SUCCESS)
+			{
+				AdiLogError(StreamThread_c, __LINE__, status);
+			}
+			byteCounter = 0;
+		}
+
+		/* Clear GPIO interrupts */
+		GPIO->lpp_gpio_simple[FX3State.DrPin] |= CY_U3P_LPP_GPIO_INTR;
+
+		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
+		if(KillStreamEarly)
+		{
+			CyU3PEventSet (&EventHandler, ADI_SEQ_STREAM_DONE, CYU3P_EVENT_OR);
+		}
+	}
+	else
+	{
+		/* Increment buffer counter */
+		numBuffersRead++;
+		/* Reset flag */
+		CyU3PEventSet (&EventHandler, ADI_SEQ_STREAM_ENABLE, CYU3P_EVENT_OR);
+	}
+	return status;
+}
+
+/**
+  * @brief This is the worker function for the edge timestamp stream.
+  *
+  * @return A status code representing the success of the edge stream operation.
+  *
+  * Fills one USB packet with edge timestamp records per call. The timer rollover count is carried
+  * in EdgeStreamState, so timestamps stay continuous across packets. Only the captured records are
+  * committed, so the packet sent when the stream is stopped is short (or zero length). When the stream
+  * ends (or is stopped) the edge interrupt is removed from the pin; the remaining cleanup is done by the
+  * generic stream finished function.
+ **/
+static CyU3PReturnStatus_t AdiEdgeStreamWork()
+{
+	/* Track the number of buffers read */
+	static uint32_t numBuffersRead = 0;
+
+	/* DMA buffer structure for the active buffer for the streaming DMA channel */
+	CyU3PDmaBuffer_t StreamChannelBuffer = {0};
+
+	/* Return status code */
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Number of edges per packet, and captured */
+	uint32_t edgesPerPacket, edgesCaptured;
+
+	/* Get a buffer */
+	status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+	if (status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamThread_c, __LINE__, status);
+	}
+
+	/* Fill it with edge records (returns early if the stream is stopped) */
+	edgesPerPacket = StreamThreadState.BytesPerUsbPacket / ADI_EDGE_RECORD_LEN;
+	edgesCaptured = AdiEdgeCaptureRun(&EdgeStreamState, StreamChannelBuffer.buffer, edgesPerPacket, 0);
+
+	/* Send the captured records */
+	status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, edgesCaptured * ADI_EDGE_RECORD_LEN, 0);
+	if (status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamThread_c, __LINE__, status);
+	}
+
+	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
+	if ((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
+	{
+
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Exiting stream thread, %d edge stream buffers read.\r\n", numBuffersRead + 1);
+#endif
+
+		/* Reset values */
+		numBuffersRead = 0;
+
+		/* Remove the edge interrupt from the pin */
+		AdiEdgeCaptureEnd(&EdgeStreamState);
+
+		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
+		if(KillStreamEarly)
+		{
+			CyU3PEventSet (&EventHandler, ADI_GENERIC_STREAM_DONE, CYU3P_EVENT_OR);
+		}
+	}
+	else
+	{
+		/* Increment buffer counter */
+		numBuffersRead++;
+		/* Reset flag */
+		CyU3PEventSet (&EventHandler, ADI_PIN_STREAM_ENABLE, CYU3P_EVENT_OR);
+	}
+	return status;
+}
+
+/**
+  * @brief This is the worker function for the logic analyzer stream.
+  *
+  * @return A status code representing the success of the logic stream operation.
+  *
+  * Fills one USB packet with run length encoded pin samples per call. The open run and the sample
+  * time are carried in LogicStreamState, so samples stay continuous across packets. A packet is sent
+  * when it is full, when the flush time passes, or when the stream is stopped. Cleanup is done by the
+  * generic stream finished function.
+ **/
+static CyU3PReturnStatus_t AdiLogicStreamWork()
+{
+	/* Track the number of buffers read */
+	static uint32_t numBuffersRead = 0;
+
+	/* DMA buffer structure for the active buffer for the streaming DMA channel */
+	CyU3PDmaBuffer_t StreamChannelBuffer = {0};
+
+	/* Return status code */
+	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+	/* Get a buffer */
+	status = CyU3PDmaChannelGetBuffer (&StreamingChannel, &StreamChannelBuffer, CYU3P_WAIT_FOREVER);
+	if (status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamThread_c, __LINE__, status);
+	}
+
+	/* Fill it with pin sample records (returns early if the stream is stopped) */
+	AdiLogicCaptureFill(&LogicStreamState, StreamChannelBuffer.buffer, StreamThreadState.BytesPerUsbPacket);
+
+	/* Send the packet */
+	status = CyU3PDmaChannelCommitBuffer (&StreamingChannel, FX3State.UsbBufferSize, 0);
+	if (status != CY_U3P_SUCCESS)
+	{
+		AdiLogError(StreamThread_c, __LINE__, status);
+	}
+
+	/* Check to see if we've captured enough buffers or if we were asked to stop data capture early */
+	if ((numBuffersRead >= (StreamThreadState.NumBuffers - 1)) || KillStreamEarly)
+	{
+
+#ifdef VERBOSE_MODE
+		CyU3PDebugPrint (4, "Exiting stream thread, %d logic stream buffers read, %d samples missed.\r\n", numBuffersRead + 1, LogicStreamState.MissedSamples);
+#endif
+
+		/* Reset values */
+		numBuffersRead = 0;
 
+		/* Set stream done flag if kill early event was processed (otherwise must be explicitly invoked by FX3 API) */
+		if(KillStreamEarly)
+		{
+			CyU3PEventSet (&EventHandler, ADI_GENERIC_STREAM_DONE, CYU3P_EVENT_OR);
+		}
+	}
+	else
+	{
+		/* Increment buffer counter */
+		numBuffersRead++;
+		/* Reset flag */
+		CyU3PEventSet (&EventHandler, ADI_PIN_STREAM_ENABLE, CYU3P_EVENT_OR);
+	}
+	return status;
+}
+
+/**
+  * @brief Pulses the sync strobe pin for a captured frame, if the strobe is enabled and the frame is a strobe frame.
+  *
+  * @return void
+  *
+  * Called by the burst, real time and generic stream workers right after each frame SPI transfer. Both pin
+  * register values are cached when the stream starts (AdiSyncStrobeStreamStart), so each edge is a single
+  * register write. The pulse width is busy waited.
+ **/
+static inline void AdiSyncStrobe()
+{
+	if(!StreamThreadState.StrobeEnable)
+		return;
+
+	if(StreamThreadState.StrobeCount == 0)
+	{
+		GPIO->lpp_gpio_simple[StreamThreadState.StrobePin] = StreamThreadState.StrobeActiveReg;
+		CyFx3BusyWait(StreamThreadState.StrobeWidth);
+		GPIO->lpp_gpio_simple[StreamThreadState.StrobePin] = StreamThreadState.StrobeIdleReg;
+	}
+
+	StreamThreadState.StrobeCount++;
+	if(StreamThreadState.StrobeCount >= StreamThreadState.StrobeDivider)
+		StreamThreadState.StrobeCount = 0;
+}
@@ -56,6 +56,15 @@ CyU3PThread StreamThread = {0};
 /** RTOS thread handle for the main application */
 CyU3PThread AppThread = {0};
 
+/** RTOS thread handle for deferred (long running) bulk channel commands */
+CyU3PThread BulkCmdThread = {0};
+
+/** RTOS thread handle for asynchronous pin measurement jobs */
+CyU3PThread PinJobThread = {0};
+
+/** RTOS thread handle for the background error log flash writes */
+CyU3PThread LogThread = {0};
+
 /** ADI event structure */
 CyU3PEvent EventHandler = {0};
 
@@ -121,6 +130,15 @@ volatile CyBool_t KillStreamEarly = CyFalse;
 /** Struct of data used to synchronize the data streaming / app threads */
 StreamState StreamThreadState = {0};
 
+/** Bit bang SPI transaction configuration for a bit bang SPI stream */
+BitBangSpiConf BitBangStreamConfig = {0};
+
+/** Edge timestamp stream capture state */
+EdgeCaptureState EdgeStreamState = {0};
+
+/** Logic analyzer stream capture state */
+LogicCaptureState LogicStreamState = {0};
+
 /**
   * @brief This is the main entry point function for the iSensor FX3 application firmware.
   *
@@ -239,6 +257,18 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
         CyU3PDebugPrint (4, "Vendor request = 0x%x\r\n", bRequest);
 #endif
 
+        /* Streams and background pin jobs both poll the pin interrupt bits with the GPIO vector masked.
+         * A stream can't start while a pin job is queued or running, or while a pin other than data
+         * ready is monitored by the GPIO router (its edges can't be counted under the mask) */
+        if(AdiIsStreamStart(bRequest, wIndex) && (AdiPinJobBusy() || AdiGpioRouterStreamConflict(bRequest)))
+        {
+        	AdiLogError(Main_c, __LINE__, CY_U3P_ERROR_INVALID_SEQUENCE);
+        	return CyFalse;
+        }
+
+        /* USBBuffer / BulkBuffer are shared with the bulk command handlers run by the AppThread */
+        AdiBulkCmdLockBuffers();
+
         switch (bRequest)
         {
         	/* Special command to trigger a data capture and measure the corresponding busy pulse. This
@@ -257,6 +287,31 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
         		status = AdiWriteRegByte(wIndex, wValue & 0xFF);
         		break;
 
+        	/* Batch register read/write. Returns data to PC over bulk endpoint */
+        	case ADI_REG_BATCH:
+        		status = AdiRegBatchHandler(wLength);
+        		break;
+
+        	/* Register shadow cache enable/invalidate/set flags */
+        	case ADI_REG_CACHE:
+        		status = AdiRegCacheHandler(wIndex, wValue, wLength);
+        		break;
+
+        	/* Register read-modify-write. Returns old/new value to PC over bulk endpoint */
+        	case ADI_RMW:
+        		status = AdiRegReadModifyWrite(wLength);
+        		break;
+
+        	/* SPI SCLK / stall characterization sweep. Returns results to PC over bulk endpoint */
+        	case ADI_SPI_SWEEP:
+        		status = AdiSpiSweepHandler(wLength);
+        		break;
+
+        	/* SPI micro-sequencer script upload / run. Returns status and captured data to PC over bulk endpoint */
+        	case ADI_SPI_SEQUENCER:
+        		status = AdiSpiSeqHandler(wIndex, wLength);
+        		break;
+
         	/* Set the application boot time */
         	case ADI_SET_BOOT_TIME:
         		status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
@@ -507,6 +562,124 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
 				}
 				break;
 
+			/* Bit bang SPI stream control */
+			case ADI_BITBANG_STREAM:
+				switch(wIndex)
+				{
+				case ADI_STREAM_START_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_BITBANG_STREAM_START, CYU3P_EVENT_OR);
+					StreamThreadState.TransferByteLength = wLength;
+					break;
+				case ADI_STREAM_DONE_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set stream done event */
+					status |= CyU3PEventSet(&EventHandler, ADI_BITBANG_STREAM_DONE, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_STOP_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_BITBANG_STREAM_STOP, CYU3P_EVENT_OR);
+					break;
+				default:
+					/* Shouldn't get here */
+					isHandled = CyFalse;
+					break;
+				}
+				if (status != CY_U3P_SUCCESS)
+				{
+					AdiLogError(Main_c, __LINE__, status);
+				}
+				break;
+
+			/* SPI micro-sequencer stream control */
+			case ADI_SPI_SEQ_STREAM:
+				switch(wIndex)
+				{
+				case ADI_STREAM_START_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_SEQ_STREAM_START, CYU3P_EVENT_OR);
+					StreamThreadState.TransferByteLength = wLength;
+					break;
+				case ADI_STREAM_DONE_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set stream done event */
+					status |= CyU3PEventSet(&EventHandler, ADI_SEQ_STREAM_DONE, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_STOP_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_SEQ_STREAM_STOP, CYU3P_EVENT_OR);
+					break;
+				default:
+					/* Shouldn't get here */
+					isHandled = CyFalse;
+					break;
+				}
+				if (status != CY_U3P_SUCCESS)
+				{
+					AdiLogError(Main_c, __LINE__, status);
+				}
+				break;
+
+			/* Edge timestamp stream control. Stop and cleanup are shared with the generic stream */
+			case ADI_EDGE_CAPTURE_STREAM:
+				switch(wIndex)
+				{
+				case ADI_STREAM_START_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set the pin stream start event */
+					StreamThreadState.PinStreamType = ADI_PIN_STREAM_EDGE;
+					status |= CyU3PEventSet(&EventHandler, ADI_PIN_STREAM_START, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_DONE_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set stream done event */
+					status |= CyU3PEventSet(&EventHandler, ADI_GENERIC_STREAM_DONE, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_STOP_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_GENERIC_STREAM_STOP, CYU3P_EVENT_OR);
+					break;
+				default:
+					/* Shouldn't get here */
+					isHandled = CyFalse;
+					break;
+				}
+				if (status != CY_U3P_SUCCESS)
+				{
+					AdiLogError(Main_c, __LINE__, status);
+				}
+				break;
+
+			/* Logic analyzer stream control. Stop and cleanup are shared with the generic stream */
+			case ADI_LOGIC_CAPTURE_STREAM:
+				switch(wIndex)
+				{
+				case ADI_STREAM_START_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set the pin stream start event */
+					StreamThreadState.PinStreamType = ADI_PIN_STREAM_LOGIC;
+					status |= CyU3PEventSet(&EventHandler, ADI_PIN_STREAM_START, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_DONE_CMD:
+					/* Get the data from the control endpoint */
+					status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
+					/* Set stream done event */
+					status |= CyU3PEventSet(&EventHandler, ADI_GENERIC_STREAM_DONE, CYU3P_EVENT_OR);
+					break;
+				case ADI_STREAM_STOP_CMD:
+					status = CyU3PEventSet(&EventHandler, ADI_GENERIC_STREAM_STOP, CYU3P_EVENT_OR);
+					break;
+				default:
+					/* Shouldn't get here */
+					isHandled = CyFalse;
+					break;
+				}
+				if (status != CY_U3P_SUCCESS)
+				{
+					AdiLogError(Main_c, __LINE__, status);
+				}
+				break;
+
 			/* Get the measured DR frequency */
             case ADI_MEASURE_DR:
             	/* Read config data into USBBuffer */
@@ -515,6 +688,41 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
 				status |= AdiMeasurePinFreq();
 				break;
 
+			/* Capture edge timestamps on a pin */
+			case ADI_EDGE_CAPTURE:
+				status = AdiEdgeCaptureHandler(wLength);
+				break;
+
+			/* Measure period statistics on a pin */
+			case ADI_PERIOD_STATS:
+				status = AdiMeasurePinPeriodStats(wLength);
+				break;
+
+			/* Per-frame sync strobe configuration */
+			case ADI_SYNC_STROBE:
+				status = AdiConfigureSyncStrobe(wLength);
+				break;
+
+			/* GPIO edge counter snapshot and pin monitoring */
+			case ADI_GPIO_ROUTER:
+				status = AdiGpioRouterHandler(wIndex, wValue, wLength);
+				break;
+
+			/* Discard abandoned bulk command responses */
+			case ADI_BULK_CMD_FLUSH:
+				status = AdiBulkCmdFlush(wLength);
+				break;
+
+			/* Asynchronous pin measurement jobs */
+			case ADI_PIN_JOB:
+				status = AdiPinJobHandler(wIndex, wValue, wLength);
+				break;
+
+			/* Phase aligned PWM group configuration */
+			case ADI_PWM_GROUP_CMD:
+				status = AdiConfigurePWMGroup(wLength);
+				break;
+
 			/* PWM configuration */
             case ADI_PWM_CMD:
             	/* Read config data into USBBuffer */
@@ -536,7 +744,7 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
             case ADI_BITBANG_SPI:
             	/* Call the handler function for the SPI bit bang. Returns data to PC over bulk endpoint */
             	status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
-            	status |= AdiBitBangSpiHandler();
+            	status |= AdiBitBangSpiHandler(wIndex, wLength);
             	break;
 
             /* Reset SPI peripheral (to recover from using bit bang SPI) */
@@ -558,15 +766,22 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
 				AdiFlashReadHandler((wIndex << 16) | wValue, wLength);
 				break;
 
+			/* Read flash memory. Returns data to PC over bulk endpoint */
+			case ADI_READ_FLASH_BULK:
+				status = AdiFlashBulkReadHandler((wIndex << 16) | wValue, wLength);
+				break;
+
 			/* Clear flash error log command */
 			case ADI_CLEAR_FLASH_LOG:
-				WriteErrorLogCount(0);
+				AdiErrorLogClear();
 				status = CyU3PUsbGetEP0Data(wLength, USBBuffer, bytesRead);
 				break;
 
 			/*Set I2C bit rate */
 			case ADI_I2C_SET_BIT_RATE:
+				AdiFlashLock();
 				status = AdiI2CInit(wIndex << 16 | wValue, CyFalse);
+				AdiFlashUnlock();
 				/* Return the status over control endpoint */
 				AdiSendStatus(status, wLength, CyTrue);
 				break;
@@ -589,6 +804,16 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
 				AdiSendStatus(status, 4, CyFalse);
 				break;
 
+			/* I2C batch of transactions. Returns data to PC over bulk endpoint */
+			case ADI_I2C_BATCH:
+				status = AdiI2CBatchHandler(wLength, wValue);
+				break;
+
+			/* I2C bus scan. Returns data to PC over bulk endpoint */
+			case ADI_I2C_SCAN:
+				status = AdiI2CScanHandler(wLength, wValue);
+				break;
+
 			/* I2C read stream start/done/cancel */
 			case ADI_I2C_READ_STREAM:
 				switch(wIndex)
@@ -631,6 +856,8 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
                 break;
         }
 
+        AdiBulkCmdUnlockBuffers();
+
         if (bType == CY_U3P_USB_STANDARD_RQT)
         {
             /* Handle SET_FEATURE(FUNCTION_SUSPEND) and CLEAR_FEATURE(FUNCTION_SUSPEND)
@@ -674,8 +901,8 @@ CyBool_t AdiControlEndpointHandler (uint32_t setupdat0, uint32_t setupdat1)
   *
   * @return A status code indicating the success of the function.
   *
-  * This function is currently unused. All event management to the host PC
-  * is performed through the control endpoint.
+  * This function is currently unused. Commands are received over the control endpoint,
+  * or over the bulk command channel (ChannelFromPC DMA callback, see BulkCommand.c).
   *
  **/
 void AdiBulkEndpointHandler(CyU3PUsbEpEvtType evType, CyU3PUSBSpeed_t usbSpeed, uint8_t epNum)
@@ -741,49 +968,27 @@ CyBool_t AdiLPMRequestHandler(CyU3PUsbLinkPowerMode link_mode)
 }
 
 /**
-  * @brief This function handles GPIO interrupts and sets the appropriate flag in GpioHandler.
+  * @brief This function handles GPIO interrupts and dispatches them to the GPIO router.
   *
   * @param gpioId The pin number of the pin which generated the interrupt
   *
   * @returns void
   *
   * This function is called by the RTOS whenever the GPIO interrupt vector is enabled and a
-  * GPIO interrupt is received. Instead of performing any work in this function, to improve
-  * system responsiveness, this function sets an RTOS event flag, to be handled by the
-  * application thread.
+  * GPIO interrupt is received. Timer rollovers are handled directly. Every other pin interrupt
+  * is routed through the GpioRouter table, which counts and timestamps the edge, sets the pin's
+  * RTOS event flag (to be handled by the waiting thread) and calls any attached callback.
  **/
 void AdiGPIOEventHandler(uint8_t gpioId)
 {
-	CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
-	CyBool_t gpioValue = CyFalse;
-	status = CyU3PGpioGetValue(gpioId, &gpioValue);
-    if (status == CY_U3P_SUCCESS)
-    {
-    	/* Read the pin ID that generated the event and set the appropriate flag */
-		if(gpioId == FX3State.PinMap.ADI_PIN_DIO1)
-			CyU3PEventSet(&GpioHandler, ADI_DIO1_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.ADI_PIN_DIO2)
-			CyU3PEventSet(&GpioHandler, ADI_DIO2_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.ADI_PIN_DIO3)
-			CyU3PEventSet(&GpioHandler, ADI_DIO3_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.ADI_PIN_DIO4)
-			CyU3PEventSet(&GpioHandler, ADI_DIO4_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.FX3_PIN_GPIO1)
-			CyU3PEventSet(&GpioHandler, FX3_GPIO1_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.FX3_PIN_GPIO2)
-			CyU3PEventSet(&GpioHandler, FX3_GPIO2_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-
-		if(gpioId == FX3State.PinMap.FX3_PIN_GPIO3)
-			CyU3PEventSet(&GpioHandler, FX3_GPIO3_INTERRUPT_FLAG, CYU3P_EVENT_OR);
+	/* 10MHz timer rollover */
+	if(gpioId == ADI_TIMER_PIN)
+	{
+		AdiTimerRolloverHandler();
+		return;
+	}
 
-		if(gpioId == FX3State.PinMap.FX3_PIN_GPIO4)
-			CyU3PEventSet(&GpioHandler, FX3_GPIO4_INTERRUPT_FLAG, CYU3P_EVENT_OR);
-    }
+	AdiGpioRouterDispatch(gpioId);
 }
 
 /**
@@ -803,6 +1008,9 @@ void AdiAppErrorHandler(CyU3PReturnStatus_t status)
     /* Application failed with the error code status */
 	CyU3PDebugPrint (4, "Application failed with fatal error! Error code: 0x%x\r\n", status);
 
+	/* Save any queued errors before the reset */
+	AdiErrorLogFlush();
+
 	for(int i = 5; i > 0; i--)
 	{
 		CyU3PDebugPrint (4, "Rebooting in %d seconds...\r\n", (i - 1));
@@ -831,6 +1039,9 @@ void AdiAppStop()
 	/* Signal that the app thread has been stopped */
 	FX3State.AppActive = CyFalse;
 
+	/* Save any queued errors before the reset */
+	AdiErrorLogFlush();
+
     /* De-init flash memory */
     AdiFlashDeInit();
 
@@ -989,6 +1200,9 @@ void AdiAppStart()
     	FX3State.PinMap.FX3_PIN_GPIO4 = 12;
     }
 
+	/* Route GPIO interrupts for the mapped pins */
+	AdiGpioRouterInit();
+
 	/* Override all pins used by ADI to act as GPIO.
 	 * Configuration relies on io matrix configuration in main(). For failed
 	 * GPIO config, firmware logs error then continues (GPIO config not crucial for
@@ -1139,7 +1353,8 @@ void AdiAppStart()
 	gpioComplexConfig.driveLowEn = CyTrue;
 	gpioComplexConfig.driveHighEn = CyTrue;
 	gpioComplexConfig.pinMode = CY_U3P_GPIO_MODE_STATIC;
-	gpioComplexConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	/* Rollover interrupt extends the timer to 64 bits (AdiGetTicks64) */
+	gpioComplexConfig.intrMode = CY_U3P_GPIO_INTR_TIMER_ZERO;
 	gpioComplexConfig.timerMode = CY_U3P_GPIO_TIMER_LOW_FREQ;
 	gpioComplexConfig.timer = 0;
 	gpioComplexConfig.period = 0xFFFFFFFF;
@@ -1273,9 +1488,11 @@ void AdiAppStart()
     dmaConfig.cb             	= NULL;
     dmaConfig.prodAvailCount 	= 0;
 
-    /* Configure DMA for ChannelFromPC */
+    /* Configure DMA for ChannelFromPC (bulk command channel, notify on each received frame) */
     dmaConfig.prodSckId = CY_U3P_UIB_SOCKET_PROD_1;
     dmaConfig.consSckId = CY_U3P_CPU_SOCKET_CONS;
+    dmaConfig.notification = CY_U3P_DMA_CB_RECV_CPLT;
+    dmaConfig.cb = AdiBulkCmdDmaCallback;
     status = CyU3PDmaChannelCreate(&ChannelFromPC, CY_U3P_DMA_TYPE_MANUAL_IN, &dmaConfig);
     if (status != CY_U3P_SUCCESS)
     {
@@ -1283,9 +1500,11 @@ void AdiAppStart()
     	AdiAppErrorHandler(status);
     }
 
-    /* Configure DMA for ChannelToPC */
+    /* Configure DMA for ChannelToPC (notify on each sent buffer, to chain queued bulk command responses) */
     dmaConfig.prodSckId = CY_U3P_CPU_SOCKET_PROD;
     dmaConfig.consSckId = CY_U3P_UIB_SOCKET_CONS_2;
+    dmaConfig.notification = CY_U3P_DMA_CB_SEND_CPLT;
+    dmaConfig.cb = AdiBulkCmdSendCallback;
     status = CyU3PDmaChannelCreate(&ChannelToPC, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
     if (status != CY_U3P_SUCCESS)
     {
@@ -1293,6 +1512,9 @@ void AdiAppStart()
     	AdiAppErrorHandler(status);
     }
 
+    /* Wait for the first bulk command frame */
+    AdiBulkCmdStart();
+
     /* Set app active flag */
     FX3State.AppActive = CyTrue;
 
@@ -1391,14 +1613,23 @@ FX3BoardType AdiGetFX3BoardType()
   * @brief This function is called by the RTOS kernel after booting and creates all the user threads.
   *
   * After the ThreadX kernel is started by a call to CyU3PKernelEntry() in main, this function is called.
-  * It creates the AppThread (for general execution / handling vendor requests) and the StreamThread for
-  * handling high throughput data streaming from a DUT.
+  * It creates the AppThread (for general execution / handling vendor requests), the StreamThread for
+  * handling high throughput data streaming from a DUT, the BulkCmdThread for long running bulk
+  * channel commands, the PinJobThread for asynchronous pin measurement jobs, and the LogThread for
+  * background error log flash writes.
  **/
 void CyFxApplicationDefine (void)
 {
     void *ptr = NULL;
     uint32_t retThrdCreate = CY_U3P_SUCCESS;
 
+    /* Create the flash lock, before any thread which uses the flash or I2C block */
+    if(AdiFlashCreateLock() != CY_U3P_SUCCESS)
+    {
+    	/* Lock creation failed. Fatal error. Cannot continue. */
+    	while(1);
+    }
+
     /* Create application (main) thread */
     ptr = CyU3PMemAlloc(APPTHREAD_STACK);
 
@@ -1448,4 +1679,79 @@ void CyFxApplicationDefine (void)
     	/* Thread creation failed. Fatal error. Cannot continue. */
     	while(1);
     }
+
+    /* Create the thread for deferred bulk commands */
+    ptr = CyU3PMemAlloc(BULKCMDTHREAD_STACK);
+
+    /* Create the bulk command thread */
+    retThrdCreate = CyU3PThreadCreate (&BulkCmdThread, 	/* Thread structure. */
+            "23:BulkCmdThread",                 		/* Thread ID and name. */
+            AdiBulkCmdThreadEntry,              		/* Thread entry function. */
+            0,                                     		/* Thread input parameter. */
+            ptr,                                   		/* Pointer to the allocated thread stack. */
+            BULKCMDTHREAD_STACK,                       	/* Allocated thread stack size. */
+            BULKCMDTHREAD_PRIORITY,                    	/* Thread priority. */
+            BULKCMDTHREAD_PRIORITY,                    	/* Thread pre-emption threshold: No preemption. */
+            CYU3P_NO_TIME_SLICE,                   		/* No time slice. Thread will run until task is
+                                                      	 completed or until the higher priority
+                                                      	 thread gets active. */
+            CYU3P_AUTO_START                      		/* Start the thread immediately. */
+            );
+
+    /* Check if creating thread succeeded */
+    if (retThrdCreate != CY_U3P_SUCCESS)
+    {
+    	/* Thread creation failed. Fatal error. Cannot continue. */
+    	while(1);
+    }
+
+    /* Create the thread for asynchronous pin measurement jobs */
+    ptr = CyU3PMemAlloc(PINJOBTHREAD_STACK);
+
+    /* Create the pin job thread */
+    retThrdCreate = CyU3PThreadCreate (&PinJobThread, 	/* Thread structure. */
+            "24:PinJobThread",                  		/* Thread ID and name. */
+            AdiPinJobThreadEntry,               		/* Thread entry function. */
+            0,                                     		/* Thread input parameter. */
+            ptr,                                   		/* Pointer to the allocated thread stack. */
+            PINJOBTHREAD_STACK,                        	/* Allocated thread stack size. */
+            PINJOBTHREAD_PRIORITY,                     	/* Thread priority. */
+            PINJOBTHREAD_PRIORITY,                     	/* Thread pre-emption threshold: No preemption. */
+            CYU3P_NO_TIME_SLICE,                   		/* No time slice. Thread will run until task is
+                                                      	 completed or until the higher priority
+                                                      	 thread gets active. */
+            CYU3P_AUTO_START                      		/* Start the thread immediately. */
+            );
+
+    /* Check if creating thread succeeded */
+    if (retThrdCreate != CY_U3P_SUCCESS)
+    {
+    	/* Thread creation failed. Fatal error. Cannot continue. */
+    	while(1);
+    }
+
+    /* Create the thread for background error log flash writes */
+    ptr = CyU3PMemAlloc(LOGTHREAD_STACK);
+
+    /* Create the log thread */
+    retThrdCreate = CyU3PThreadCreate (&LogThread, 		/* Thread structure. */
+            "25:LogThread",                     		/* Thread ID and name. */
+            AdiLogThreadEntry,                  		/* Thread entry function. */
+            0,                                     		/* Thread input parameter. */
+            ptr,                                   		/* Pointer to the allocated thread stack. */
+            LOGTHREAD_STACK,                           	/* Allocated thread stack size. */
+            LOGTHREAD_PRIORITY,                        	/* Thread priority. */
+            LOGTHREAD_PRIORITY,                        	/* Thread pre-emption threshold: No preemption. */
+            CYU3P_NO_TIME_SLICE,                   		/* No time slice. Thread will run until task is
+                                                      	 completed or until the higher priority
+                                                      	 thread gets active. */
+            CYU3P_AUTO_START                      		/* Start the thread immediately. */
+            );
+
+    /* Check if creating thread succeeded */
+    if (retThrdCreate != CY_U3P_SUCCESS)
+    {
+    	/* Thread creation failed. Fatal error. Cannot continue. */
+    	while(1);
+    }
 }
@@ -54,6 +54,12 @@
 #include "ErrorLog.h"
 #include "I2cFunctions.h"
 #include "HelperFunctions.h"
+#include "RegCache.h"
+#include "SpiSequencer.h"
+#include "BulkCommand.h"
+#include "LogicCapture.h"
+#include "PinJob.h"
+#include "GpioRouter.h"
 
 /* Lower level register access includes */
 #include "gpio_regs.h"
@@ -241,6 +247,45 @@ typedef struct StreamState
 	/** Preamble for I2C stream */
 	CyU3PI2cPreamble_t I2CStreamPreamble;
 
+	/** Track if the I2C stream packs multiple reads into each USB buffer */
+	CyBool_t I2CPacked;
+
+	/** Track if each packed I2C stream read is prefixed with a timestamp */
+	CyBool_t I2CTimestamp;
+
+	/** Max time a packed I2C stream read is held in a partial USB buffer, in 10MHz timer ticks (0 = only send full buffers) */
+	uint32_t I2CFlushTicks;
+
+	/** Type of pin capture stream started by the pin stream events (edge timestamps or logic analyzer) */
+	uint8_t PinStreamType;
+
+	/** Track if the per-frame sync strobe is enabled for burst, real time and generic streams */
+	CyBool_t StrobeEnable;
+
+	/** Sync strobe pin (one of FX3_PIN_GPIO1 - FX3_PIN_GPIO4) */
+	uint16_t StrobePin;
+
+	/** Sync strobe pulse width, in microseconds */
+	uint16_t StrobeWidth;
+
+	/** Sync strobe frame divider (pulse every Nth frame) */
+	uint16_t StrobeDivider;
+
+	/** Frames since the last sync strobe pulse */
+	uint16_t StrobeCount;
+
+	/** Sync strobe active polarity (CyTrue for an active high pulse) */
+	CyBool_t StrobePolarity;
+
+	/** Sync strobe pin register value which drives the active level. Read from the pin when each stream starts */
+	uint32_t StrobeActiveReg;
+
+	/** Sync strobe pin register value which drives the idle level. Read from the pin when each stream starts */
+	uint32_t StrobeIdleReg;
+
+	/** Track if the StreamThread is running a stream. Background error log flash writes are held off while set */
+	volatile CyBool_t StreamActive;
+
 }StreamState;
 
 /*
@@ -262,6 +307,12 @@ typedef struct StreamState
 /** I2C set rety count after slave sends NAK */
 #define ADI_I2C_RETRY_COUNT						(0x14)
 
+/** I2C batch of read / write transactions. Returns status and read data over the bulk endpoint */
+#define ADI_I2C_BATCH							(0x15)
+
+/** I2C bus scan (address bitmap and optional ID register reads). Returns data over the bulk endpoint */
+#define ADI_I2C_SCAN							(0x16)
+
 /** Return FX3 firmware ID (defined below) */
 #define ADI_FIRMWARE_ID_CHECK					(0xB0)
 
@@ -331,6 +382,54 @@ typedef struct StreamState
 /** Set GPIO resistor pull up or pull down */
 #define ADI_SET_PIN_RESISTOR					(0xD2)
 
+/** Perform a batch of register reads/writes and return all read data over the bulk endpoint */
+#define ADI_REG_BATCH							(0xD3)
+
+/** Configure, flag, or invalidate the DUT register shadow cache */
+#define ADI_REG_CACHE							(0xD4)
+
+/** Atomic read-modify-write of a 16 bit register */
+#define ADI_RMW									(0xD5)
+
+/** Run a SPI link characterization sweep over a grid of SCLK frequencies and stall times */
+#define ADI_SPI_SWEEP							(0xD6)
+
+/** Start, stop, or clean up a bit bang SPI stream */
+#define ADI_BITBANG_STREAM						(0xD7)
+
+/** Upload or run a SPI micro-sequencer script */
+#define ADI_SPI_SEQUENCER						(0xD8)
+
+/** Start, stop, or clean up a SPI micro-sequencer stream */
+#define ADI_SPI_SEQ_STREAM						(0xD9)
+
+/** Capture a timestamp for each edge on a pin, and return them over the bulk endpoint */
+#define ADI_EDGE_CAPTURE						(0xDA)
+
+/** Start, stop, or clean up an edge timestamp stream */
+#define ADI_EDGE_CAPTURE_STREAM					(0xDB)
+
+/** Measure a number of consecutive periods on a pin, and return period statistics and a histogram over the bulk endpoint */
+#define ADI_PERIOD_STATS						(0xDC)
+
+/** Configure a group of PWM outputs which start on the same clock tick with defined phase offsets */
+#define ADI_PWM_GROUP_CMD						(0xDD)
+
+/** Start, stop, or clean up a logic analyzer capture stream of the mapped DIO and GPIO pins */
+#define ADI_LOGIC_CAPTURE_STREAM				(0xDE)
+
+/** Start, poll, or cancel an asynchronous pin measurement job */
+#define ADI_PIN_JOB								(0xDF)
+
+/** Configure the per-frame sync strobe output for burst, real time and generic streams */
+#define ADI_SYNC_STROBE							(0xE0)
+
+/** Read the GPIO edge counters, or start / stop counting edges on a pin */
+#define ADI_GPIO_ROUTER							(0xE1)
+
+/** Discard the bulk command responses the host has stopped waiting for. Returns status[0-3], busy slots[4-7] */
+#define ADI_BULK_CMD_FLUSH						(0xE2)
+
 /** Read a word at a specified address and return the data over the control endpoint */
 #define ADI_READ_BYTES							(0xF0)
 
@@ -343,6 +442,9 @@ typedef struct StreamState
 /** Read flash memory */
 #define ADI_READ_FLASH							(0xF3)
 
+/** Read flash memory, returning the data over the bulk endpoint (up to 12KB per read) */
+#define ADI_READ_FLASH_BULK						(0xF4)
+
 /** Used to transfer bytes without any intervention/protocol management */
 #define ADI_TRANSFER_BYTES						(0xCA)
 
@@ -412,6 +514,12 @@ typedef struct StreamState
 /** FX3 GPIO weak pull up control register (upper 32 bits) */
 #define GCTL_WPU_CFG_UPPR						 (*(uvint32_t *)(0xE0051020 + 0x4))
 
+/** FX3 GPIO fast clock configuration register (clocks the complex GPIO timers) */
+#define GCTL_GPIO_FAST_CLK						 (*(uvint32_t *)(0xE0052018))
+
+/** Clock enable bit in the GCTL peripheral clock configuration registers */
+#define GCTL_GPIO_CLK_EN						 (1u << 31)
+
 /** FX3 serial number register */
 #define EFUSE_DIE_ID 							 (uvint32_t *)0xE0055010
 
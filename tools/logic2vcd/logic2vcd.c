@@ -0,0 +1,227 @@
+/**
+  * Copyright (c) Analog Devices Inc, 2018 - 2020
+  * All Rights Reserved.
+  *
+  * Use of this file is governed by the license agreement
+  * included in this repository.
+  *
+  * @file		logic2vcd.c
+  * @date		10/18/2026
+  * @author		A. Nolan (alex.nolan@analog.com)
+  * @brief		Converts an FX3 logic analyzer capture to a Value Change Dump (VCD) file.
+  *
+  * The input is the raw logic capture stream (the USB packets received from the FX3, saved
+  * back to back, e.g. from FX3Connection.LogicCaptureStream). The output can be opened in any
+  * VCD viewer, such as GTKWave or PulseView. This is plain C99 with no dependencies:
+  *
+  *   cc -std=c99 -O2 -o logic2vcd logic2vcd.c
+  *   logic2vcd [-r timer ticks per second] capture.bin capture.vcd
+  *
+  * The packet format is defined in firmware/FX3_Firmware/LogicCapture.h.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/** Logic capture packet header magic ("LA") */
+#define LOGIC_MAGIC				(0x414C)
+
+/** Number of header bytes at the start of each packet */
+#define LOGIC_HEADER_LEN		(24)
+
+/** Size of a single run length record */
+#define LOGIC_RECORD_LEN		(4)
+
+/** Run length field mask in a record */
+#define LOGIC_RUN_MASK			(0x7FFFFF)
+
+/** Bit position of the channel values in a record */
+#define LOGIC_VALUE_POS			(23)
+
+/** Max number of channels in a record */
+#define LOGIC_MAX_CHANNELS		(9)
+
+/** Default FX3 timer rate, in ticks per second (matches the FX3 API default) */
+#define DEFAULT_TICKS_PER_SEC	(10078400.0)
+
+/** Channel names, in record bit order */
+static const char * ChannelNames[LOGIC_MAX_CHANNELS] =
+{
+	"DIO1", "DIO2", "DIO3", "DIO4", "GPIO1", "GPIO2", "GPIO3", "GPIO4", "RESET"
+};
+
+static uint32_t ReadU16(const uint8_t * buf)
+{
+	return (uint32_t) buf[0] | ((uint32_t) buf[1] << 8);
+}
+
+static uint32_t ReadU32(const uint8_t * buf)
+{
+	return ReadU16(buf) | (ReadU16(buf + 2) << 16);
+}
+
+static uint64_t ReadU64(const uint8_t * buf)
+{
+	return (uint64_t) ReadU32(buf) | ((uint64_t) ReadU32(buf + 4) << 32);
+}
+
+/**
+  * @brief Converts a sample index to VCD time (ns)
+ **/
+static unsigned long long SampleToNs(uint64_t sample, uint32_t samplePeriod, double ticksPerSec)
+{
+	return (unsigned long long) (((double) sample * samplePeriod * 1e9) / ticksPerSec + 0.5);
+}
+
+static void WriteHeader(FILE * out, uint32_t numChannels, uint32_t samplePeriod, double ticksPerSec)
+{
+	uint32_t i;
+
+	fprintf(out, "$version FX3 logic2vcd $end\n");
+	fprintf(out, "$comment sample period %u ticks, %.1f ticks/s $end\n", (unsigned) samplePeriod, ticksPerSec);
+	fprintf(out, "$timescale 1ns $end\n");
+	fprintf(out, "$scope module fx3 $end\n");
+	for(i = 0; i < numChannels; i++)
+	{
+		fprintf(out, "$var wire 1 %c %s $end\n", (char) ('!' + i), ChannelNames[i]);
+	}
+	fprintf(out, "$upscope $end\n");
+	fprintf(out, "$enddefinitions $end\n");
+}
+
+int main(int argc, char * argv[])
+{
+	FILE * in;
+	FILE * out;
+	uint8_t * packet;
+	uint8_t header[LOGIC_HEADER_LEN];
+	double ticksPerSec = DEFAULT_TICKS_PER_SEC;
+	uint32_t packetLen, numRecords, numChannels, samplePeriod, missed, record, value, run, changed, i, r;
+	uint32_t lastValue = 0, lastMissed = 0, firstPeriod = 0;
+	uint64_t sample, expected = 0;
+	unsigned long long numPackets = 0;
+	int argIndex = 1;
+	int headerWritten = 0;
+	int started = 0;
+
+	if((argc == 5) && (strcmp(argv[1], "-r") == 0))
+	{
+		ticksPerSec = atof(argv[2]);
+		argIndex = 3;
+	}
+	if((argc - argIndex) != 2 || ticksPerSec <= 0)
+	{
+		fprintf(stderr, "Usage: logic2vcd [-r timer ticks per second] capture.bin capture.vcd\n");
+		return 1;
+	}
+
+	in = fopen(argv[argIndex], "rb");
+	if(in == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not open %s\n", argv[argIndex]);
+		return 1;
+	}
+	out = fopen(argv[argIndex + 1], "w");
+	if(out == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not create %s\n", argv[argIndex + 1]);
+		fclose(in);
+		return 1;
+	}
+
+	packet = NULL;
+	while(fread(header, 1, LOGIC_HEADER_LEN, in) == LOGIC_HEADER_LEN)
+	{
+		if(ReadU16(header) != LOGIC_MAGIC)
+		{
+			fprintf(stderr, "ERROR: Bad packet header after %llu packets\n", numPackets);
+			break;
+		}
+		packetLen = ReadU16(header + 2);
+		numRecords = ReadU16(header + 4);
+		numChannels = ReadU16(header + 6);
+		samplePeriod = ReadU32(header + 8);
+		missed = ReadU32(header + 12);
+		sample = ReadU64(header + 16);
+
+		if((packetLen < LOGIC_HEADER_LEN) || (numChannels > LOGIC_MAX_CHANNELS) || (samplePeriod == 0) ||
+			((LOGIC_HEADER_LEN + numRecords * LOGIC_RECORD_LEN) > packetLen))
+		{
+			fprintf(stderr, "ERROR: Invalid packet header after %llu packets\n", numPackets);
+			break;
+		}
+
+		/* Read the rest of the packet (records and zero fill) */
+		free(packet);
+		packet = (uint8_t *) malloc(packetLen);
+		if((packet == NULL) || (fread(packet, 1, packetLen - LOGIC_HEADER_LEN, in) != (packetLen - LOGIC_HEADER_LEN)))
+		{
+			fprintf(stderr, "WARNING: Truncated packet at end of capture\n");
+			break;
+		}
+
+		if(!headerWritten)
+		{
+			WriteHeader(out, numChannels, samplePeriod, ticksPerSec);
+			headerWritten = 1;
+			firstPeriod = samplePeriod;
+			expected = sample;
+		}
+		else if(sample != expected)
+		{
+			fprintf(stderr, "WARNING: Sample gap before packet %llu (expected sample %llu, got %llu)\n", numPackets, (unsigned long long) expected, (unsigned long long) sample);
+		}
+		if(missed != lastMissed)
+		{
+			fprintf(stderr, "WARNING: %u samples held by the FX3 before sample %llu\n", (unsigned) (missed - lastMissed), (unsigned long long) sample);
+			lastMissed = missed;
+		}
+
+		for(r = 0; r < numRecords; r++)
+		{
+			record = ReadU32(packet + r * LOGIC_RECORD_LEN);
+			run = record & LOGIC_RUN_MASK;
+			value = record >> LOGIC_VALUE_POS;
+			if(run == 0)
+				continue;
+
+			/* Dump all channels at the first sample, then only the ones that changed */
+			changed = started ? (value ^ lastValue) : ((1u << numChannels) - 1);
+			if(changed)
+			{
+				fprintf(out, "#%llu\n", SampleToNs(sample, firstPeriod, ticksPerSec));
+				if(!started)
+					fprintf(out, "$dumpvars\n");
+				for(i = 0; i < numChannels; i++)
+				{
+					if(changed & (1u << i))
+						fprintf(out, "%c%c\n", (value & (1u << i)) ? '1' : '0', (char) ('!' + i));
+				}
+				if(!started)
+					fprintf(out, "$end\n");
+			}
+			started = 1;
+			lastValue = value;
+			sample += run;
+		}
+		expected = sample;
+		numPackets++;
+	}
+
+	/* Close out the last run */
+	if(started)
+	{
+		fprintf(out, "#%llu\n", SampleToNs(expected, firstPeriod, ticksPerSec));
+	}
+	else
+	{
+		fprintf(stderr, "WARNING: No samples found in %s\n", argv[argIndex]);
+	}
+
+	free(packet);
+	fclose(in);
+	fclose(out);
+	return started ? 0 : 1;
+}